@@ -0,0 +1,147 @@
+/************************************************************************************
+ * 
+ * 重复指令缓存。服务器收不到回执时会重发同一条指令，如果每次都重新执行，开度卷膜、重置行程
+ * 会重复校验、重复动作，还会把通用回执和状态回执再发一遍，在共享信道上形成回执风暴。
+ * 这里按帧ID、数据哈希和CRC8记住最近处理过的几条指令，时间窗口内再次收到时只重发缓存的回执。
+ * 头文件中提供了各个类的公共接口。
+ * 
+*************************************************************************************/
+
+#include "Cmd_Cache.h"
+#include "Memory.h"
+
+Command_Cache LoRa_Cmd_Cache;
+
+/*
+ @brief   : 查找时间窗口内处理过的同一条指令
+ @param   : 1.帧ID
+            2.数据哈希
+            3.CRC8
+ @return  : 缓存下标，没有找到返回-1
+ */
+signed char Command_Cache::Find(unsigned int frame_id, unsigned int payload_hash, unsigned char crc)
+{
+  unsigned long WindowMs = Window();
+
+  for (unsigned char i = 0; i < CMD_CACHE_SIZE; i++)
+  {
+    if (!Entry[i].ValidFlag) continue;
+
+    if (millis() - Entry[i].Time >= WindowMs)
+    {
+      Entry[i].ValidFlag = false;   //过期
+      continue;
+    }
+
+    if (Entry[i].FrameID == frame_id && Entry[i].PayloadHash == payload_hash && Entry[i].Crc == crc)
+    {
+      HitNum++;
+      return i;
+    }
+  }
+  return -1;
+}
+
+/*
+ @brief   : 记录一条处理完成的指令和它的回执。
+            同一帧ID只保留最新的一条：例如开度50、开度0之后再收到开度50，是新的指令而不是重发，要执行。
+            没有同一帧ID的记录时，覆盖空闲或最旧的记录。
+ @param   : 1.帧ID
+            2.数据哈希
+            3.CRC8
+            4.是否是动作指令
+            5.处理时发出的回执
+ @return  : 无
+ */
+void Command_Cache::Save(unsigned int frame_id, unsigned int payload_hash, unsigned char crc, bool motion, const Receipt_Record &record)
+{
+  signed char Index = -1;
+  unsigned char i;
+
+  for (i = 0; i < CMD_CACHE_SIZE; i++)
+  {
+    if (Entry[i].ValidFlag && Entry[i].FrameID == frame_id)
+    {
+      Index = i;
+      break;
+    }
+  }
+
+  for (i = 0; Index < 0 && i < CMD_CACHE_SIZE; i++)
+  {
+    if (!Entry[i].ValidFlag)
+      Index = i;
+  }
+
+  if (Index < 0)
+  {
+    Index = 0;
+    for (i = 1; i < CMD_CACHE_SIZE; i++)
+    {
+      if ((long)(Entry[i].Time - Entry[Index].Time) < 0)
+        Index = i;
+    }
+  }
+
+  Entry[Index].FrameID = frame_id;
+  Entry[Index].PayloadHash = payload_hash;
+  Entry[Index].Crc = crc;
+  Entry[Index].MotionFlag = motion;
+  Entry[Index].Time = millis();
+  Entry[Index].Record = record;
+  Entry[Index].ValidFlag = true;
+}
+
+/*
+ @brief   : 作废所有动作指令的记录。
+            开度50之后收到停止或开度0，再收到开度50时卷膜机已经不在50，必须重新执行；
+            不同帧ID的动作指令也会互相改变开度，所以任何动作或停止都要作废全部动作记录。
+ @param   : 无
+ @return  : 无
+ */
+void Command_Cache::Clear_Motion(void)
+{
+  for (unsigned char i = 0; i < CMD_CACHE_SIZE; i++)
+  {
+    if (Entry[i].MotionFlag)
+      Entry[i].ValidFlag = false;
+  }
+  MotionClearNum++;
+}
+
+/*
+ @brief   : 读取保存的时间窗口，没有设置过或超过上限时使用默认窗口
+ @param   : 无
+ @return  : 时间窗口（ms）
+ */
+unsigned long Command_Cache::Window(void)
+{
+  unsigned char Data[CMD_CACHE_WINDOW_LEN];
+  unsigned int Sec = CMD_CACHE_WINDOW_DEFAULT;
+
+  if (Roll_Operation.Read_Cmd_Cache_Window(Data))
+  {
+    Sec = (Data[0] << 8) | Data[1];
+    if (Sec > CMD_CACHE_WINDOW_MAX)
+      Sec = CMD_CACHE_WINDOW_DEFAULT;
+  }
+  return (unsigned long)Sec * 1000;
+}
+
+/*
+ @brief   : 计算指令数据部分的Fletcher-16
+ @param   : 1.数据
+            2.数据长度
+ @return  : 哈希值
+ */
+unsigned int Command_Cache::Payload_Hash(const unsigned char *data, unsigned char len)
+{
+  unsigned int Sum1 = 0, Sum2 = 0;
+
+  for (unsigned char i = 0; i < len; i++)
+  {
+    Sum1 = (Sum1 + data[i]) % 255;
+    Sum2 = (Sum2 + Sum1) % 255;
+  }
+  return (Sum2 << 8) | Sum1;
+}
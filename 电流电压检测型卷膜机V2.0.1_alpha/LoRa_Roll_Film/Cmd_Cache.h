@@ -0,0 +1,48 @@
+#ifndef _CMD_CACHE_H
+#define _CMD_CACHE_H
+
+#include <Arduino.h>
+#include "receipt.h"
+
+#define CMD_CACHE_SIZE              4       //最近处理过的指令条数
+#define CMD_CACHE_WINDOW_DEFAULT    60      //没有设置过时间窗口时使用（S）
+#define CMD_CACHE_WINDOW_MAX        600     //时间窗口上限（S），0表示不去重
+
+/*最近处理过的一条指令，以及处理时发出的回执*/
+struct Cmd_Cache_Entry{
+  unsigned int FrameID;
+  unsigned int PayloadHash;     //数据部分的Fletcher-16，和CRC8一起区分同一帧ID的不同指令
+  unsigned char Crc;
+  bool ValidFlag;
+  bool MotionFlag;              //开度卷膜、强制开关、重置行程等动作指令
+  unsigned long Time;           //处理完成的时间
+  Receipt_Record Record;
+};
+
+/*
+ * 重复指令缓存，只在主循环里使用。
+ * 服务器没有收到回执会重发同一条指令，在时间窗口内命中缓存的指令不再执行，只重发当时的回执。
+ * 时间窗口保存在EEPROM里（寄存器0x1B），动作指令的记录在任何动作或停止之后都作废。
+ */
+class Command_Cache{
+public:
+  signed char Find(unsigned int frame_id, unsigned int payload_hash, unsigned char crc);
+  void Save(unsigned int frame_id, unsigned int payload_hash, unsigned char crc, bool motion, const Receipt_Record &record);
+  void Clear_Motion(void);
+  unsigned long Motion_Clear_Num(void) {return MotionClearNum;}
+  const Receipt_Record &Record(signed char index) {return Entry[index].Record;}
+  unsigned long Hit_Num(void) {return HitNum;}
+
+  static unsigned int Payload_Hash(const unsigned char *data, unsigned char len);
+
+private:
+  unsigned long Window(void);
+
+  Cmd_Cache_Entry Entry[CMD_CACHE_SIZE];
+  unsigned long HitNum;         //命中缓存、没有重复执行的指令数
+  unsigned long MotionClearNum; //作废动作指令记录的次数，处理指令期间变化说明动作已经被打断或改变
+};
+
+extern Command_Cache LoRa_Cmd_Cache;
+
+#endif
@@ -0,0 +1,129 @@
+/************************************************************************************
+ * 
+ * LoRa指令优先级队列。接收到的指令先校验CRC8，再按优先级放入队列，主循环每次取出优先级
+ * 最高的一条处理。强制停止、强制开关棚等指令会排在状态查询前面；卷膜过程中收到的动作指令
+ * 不会被丢掉，而是留在队列里，等当前卷膜完成后再执行。
+ * 头文件中提供了各个类的公共接口。
+ * 
+*************************************************************************************/
+
+#include "Cmd_Queue.h"
+
+/*槽状态*/
+#define SLOT_FREE       0
+#define SLOT_PENDING    1
+#define SLOT_HANDLING   2
+
+Command_Queue LoRa_Cmd_Queue;
+
+/*
+ @brief   : 将一帧指令按优先级放入队列。
+            队列满时，如果队列里有优先级更低的指令，挤掉其中最新的一条；否则丢弃本条指令。
+ @param   : 1.指令数据
+            2.指令长度
+            3.优先级
+            4.是否是卷膜动作指令
+            5.是否是可以在开度卷膜中直接修改目标开度的指令
+ @return  : true or false
+ */
+bool Command_Queue::Push(const unsigned char *data, unsigned char len, Cmd_Priority priority, bool motion_flag, bool retarget_flag)
+{
+  signed char Index = -1;
+
+  if (len > FRAME_MAX_LEN) return false;
+
+  for (unsigned char i = 0; i < CMD_QUEUE_SIZE; i++)
+  {
+    if (Slot[i].State == SLOT_FREE)
+    {
+      Index = i;
+      break;
+    }
+  }
+
+  /*队列已满，找一条优先级最低、入队最晚的等待指令让位*/
+  if (Index < 0)
+  {
+    for (unsigned char i = 0; i < CMD_QUEUE_SIZE; i++)
+    {
+      if (Slot[i].State != SLOT_PENDING || Slot[i].Priority >= priority)
+        continue;
+
+      if (Index < 0 || Slot[i].Priority < Slot[Index].Priority ||
+         (Slot[i].Priority == Slot[Index].Priority && Slot[i].Sequence > Slot[Index].Sequence))
+        Index = i;
+    }
+
+    if (Index < 0)
+    {
+      DropNum++;
+      Serial.println("Command queue full, drop frame !!! <Push>");
+      return false;
+    }
+    EvictNum++;
+    Serial.println("Command queue full, evict lower priority frame... <Push>");
+  }
+
+  memcpy(Slot[Index].Data, data, len);
+  Slot[Index].Length = len;
+  Slot[Index].Priority = priority;
+  Slot[Index].MotionFlag = motion_flag;
+  Slot[Index].RetargetFlag = retarget_flag;
+  Slot[Index].Sequence = SequenceNum++;
+  Slot[Index].State = SLOT_PENDING;
+  return true;
+}
+
+/*
+ @brief   : 取出优先级最高的一条等待指令，同一优先级先入先出。
+            正在卷膜时跳过卷膜动作指令，让它们留在队列里等待；但开度卷膜过程中，普通开度指令可以取出，直接修改目标开度。
+ @param   : 1.当前是否正在卷膜
+            2.当前是否允许修改目标开度
+ @return  : 槽下标，-1表示没有可以处理的指令
+ */
+signed char Command_Queue::Fetch(bool motion_busy, bool retarget_enable)
+{
+  signed char Index = -1;
+
+  for (unsigned char i = 0; i < CMD_QUEUE_SIZE; i++)
+  {
+    if (Slot[i].State != SLOT_PENDING) continue;
+    if (motion_busy && Slot[i].MotionFlag && !(retarget_enable && Slot[i].RetargetFlag)) continue;
+
+    if (Index < 0 || Slot[i].Priority > Slot[Index].Priority ||
+       (Slot[i].Priority == Slot[Index].Priority && Slot[i].Sequence < Slot[Index].Sequence))
+      Index = i;
+  }
+
+  if (Index >= 0)
+    Slot[Index].State = SLOT_HANDLING;
+
+  return Index;
+}
+
+/*
+ @brief   : 指令处理完成，释放槽位
+ @param   : 槽下标
+ @return  : 无
+ */
+void Command_Queue::Release(signed char index)
+{
+  if (index < 0 || index >= CMD_QUEUE_SIZE) return;
+  Slot[index].State = SLOT_FREE;
+}
+
+/*
+ @brief   : 队列中等待处理的指令数
+ @param   : 无
+ @return  : 指令数
+ */
+unsigned char Command_Queue::Pending_Num(void)
+{
+  unsigned char Num = 0;
+  for (unsigned char i = 0; i < CMD_QUEUE_SIZE; i++)
+  {
+    if (Slot[i].State == SLOT_PENDING)
+      Num++;
+  }
+  return Num;
+}
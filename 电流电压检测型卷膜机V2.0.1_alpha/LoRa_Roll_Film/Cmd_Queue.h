@@ -0,0 +1,45 @@
+#ifndef _CMD_QUEUE_H
+#define _CMD_QUEUE_H
+
+#include <Arduino.h>
+#include "Command_Analysis.h"
+
+#define CMD_QUEUE_SIZE    6   //指令队列容量（帧数）
+
+/*队列中的一帧指令*/
+struct Cmd_Frame{
+  unsigned char Data[FRAME_MAX_LEN];
+  unsigned char Length;
+  unsigned char Priority;
+  bool MotionFlag;          //是否是卷膜动作指令，正在卷膜时动作指令要等当前卷膜完成后再处理
+  bool RetargetFlag;        //是否是普通开度指令，开度卷膜过程中可以直接修改目标开度，不用等待
+  unsigned char State;      //槽状态：空闲、等待处理、正在处理
+  unsigned long Sequence;   //入队序号，同一优先级先入先出
+};
+
+/*
+ * 固定容量的指令优先级队列，只在主循环里使用。
+ * 取出的指令在处理期间仍然占用槽位（零拷贝），处理完调用Release()释放。
+ */
+class Command_Queue{
+public:
+  bool Push(const unsigned char *data, unsigned char len, Cmd_Priority priority, bool motion_flag, bool retarget_flag);
+  signed char Fetch(bool motion_busy, bool retarget_enable);
+  void Release(signed char index);
+  unsigned char *Frame_Data(signed char index) {return Slot[index].Data;}
+  unsigned char Frame_Length(signed char index) {return Slot[index].Length;}
+  unsigned char Pending_Num(void);
+
+  unsigned long Drop_Num(void)  {return DropNum;}
+  unsigned long Evict_Num(void) {return EvictNum;}
+
+private:
+  Cmd_Frame Slot[CMD_QUEUE_SIZE];
+  unsigned long SequenceNum;
+  unsigned long DropNum;    //队列满且优先级不够高，被丢弃的指令数
+  unsigned long EvictNum;   //队列满时被更高优先级指令挤掉的指令数
+};
+
+extern Command_Queue LoRa_Cmd_Queue;
+
+#endif
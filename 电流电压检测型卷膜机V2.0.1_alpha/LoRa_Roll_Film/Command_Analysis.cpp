@@ -19,152 +19,447 @@
 #include "Memory.h"
 #include "Motor.h"
 #include "receipt.h"
+#include "Ring_Buffer.h"
+#include "Cmd_Queue.h"
+#include "Cmd_Cache.h"
+#include "Private_Timer.h"
+#include "Private_RTC.h"
+#include "Schedule.h"
+#include "Param_Register.h"
+#include "Tx_Queue.h"
 
 Command_Analysis LoRa_Command_Analysis;
 
-unsigned char gReceiveCmd[128];   //接收LoRa数据缓存
-unsigned char gReceiveLength;     //接收LoRa数据长度
 bool gAccessNetworkFlag = true;   //是否已经注册到服务器标志位
-bool gStopWorkFlag = false;       //是否要强制停止标志位
+volatile bool gStopWorkFlag = false;  //是否要强制停止标志位
 bool gMassCommandFlag = false;    //接收的消息是否是群发标志位
 
 bool gIsHandleMsgFlag = true;     //是否接收到LoRa消息然后解析处理，还是只接收不解析处理（刚上电LoRa模块发的厂家信息）
 
+/*指令帧描述表在头文件里定义，这里只给出存储，二分查找时按地址取表项*/
+constexpr Command_Analysis::Frame_Descriptor Command_Analysis::FrameTable[];
+constexpr unsigned char Command_Analysis::FRAME_TABLE_NUM;
+
+/*
+ @brief   : 编译时检查指令帧描述表是否按帧ID严格递增排列
+ @param   : 从第几项开始检查
+ @return  : true or false
+ */
+constexpr bool Command_Analysis::Frame_Table_Sorted(unsigned char index)
+{
+  return (index + 1 >= FRAME_TABLE_NUM) ? true :
+         (FrameTable[index].FrameID < FrameTable[index + 1].FrameID && Frame_Table_Sorted(index + 1));
+}
+
+/*
+ @brief   : 按帧ID二分查找指令帧描述
+ @param   : 帧ID
+ @return  : 指令帧描述，没有找到返回NULL
+ */
+const Command_Analysis::Frame_Descriptor *Command_Analysis::Find_Frame_Descriptor(unsigned int frame_id)
+{
+  static_assert(Frame_Table_Sorted(0), "FrameTable must be sorted by frame ID");
+
+  unsigned char Low = 0, High = FRAME_TABLE_NUM;
+
+  while (Low < High)
+  {
+    unsigned char Mid = (Low + High) / 2;
+    if (FrameTable[Mid].FrameID == frame_id)
+      return &FrameTable[Mid];
+    else if (FrameTable[Mid].FrameID < frame_id)
+      Low = Mid + 1;
+    else
+      High = Mid;
+  }
+  return NULL;
+}
+
 /*
  @brief   : 从网关接收LoRa数据（网关 ---> 本机），接受的指令有通用指令和本设备私有指令。
-            每条指令以0xFE为帧头，0x0D 0x0A 0x0D 0x0A 0x0D 0x0A，6个字节为帧尾。最大接受指令长度为128字节，超过将清空接收的数据和长度。
+            每条指令以0xFE为帧头，0x0D 0x0A 0x0D 0x0A 0x0D 0x0A，6个字节为帧尾。最大接受指令长度为128字节，超过将丢弃该帧。
+            串口数据由定时器中断搬进环形缓存，这里只从缓存里同步出已经收完的指令，不等待、不延时。
+            同步出的指令按优先级放入指令队列，每次调用从队列里取出优先级最高的一条指令处理。
  @param   : 无
  @return  : 无
  */
 void Command_Analysis::Receive_LoRa_Cmd(void)
 {
-  unsigned char EndNum = 0;  //帧尾数量计数值
-  bool EndNumFlag = false;  //检测到第一个帧尾标志位
-  bool ReceiveEndFlag = false;  //正确接收到一笔数据标志位
-  unsigned char FrameHeadDex = 0;
-  gReceiveLength = 0;
   iwdg_feed();
 
-  while (LoRa_Serial.available() > 0)
+  while (Frame_Sync())
   {
-    iwdg_feed();
-    gReceiveCmd[gReceiveLength++] = LoRa_Serial.read();
-    delay(3);
-    Serial.print(gReceiveCmd[gReceiveLength - 1], HEX);
-    Serial.print(" ");
+    for (unsigned char i = 0; i < FrameLength; i++)
+    {
+      Serial.print(FrameBuffer[i], HEX);
+      Serial.print(" ");
+    }
+    Serial.println();
+
+    if (gIsHandleMsgFlag)
+      Queue_Frame(FrameBuffer, FrameLength);
+  }
+
+  if (!gIsHandleMsgFlag) return;
+
+  /*正在卷膜时，卷膜动作指令留在队列里，等卷膜完成后再处理。开度卷膜中的普通开度指令除外*/
+  bool MotionBusy = (gResetRollWorkingFlag || gOpeningWorkingFlag || gForceRollWorkingFlag);
+  signed char Index = LoRa_Cmd_Queue.Fetch(MotionBusy, gRetargetEnableFlag);
+  if (Index < 0) return;
+
+  /*卷膜过程中会嵌套调用本函数处理指令，保存外层正在处理的指令*/
+  unsigned char *LastFrame = CmdFrame;
+  unsigned char LastLength = CmdLength;
+
+  CmdFrame = LoRa_Cmd_Queue.Frame_Data(Index);
+  CmdLength = LoRa_Cmd_Queue.Frame_Length(Index);
+  Serial.println("Parsing LoRa command... <Receive_LoRa_Cmd>");
+  Receive_Data_Analysis();
+  LoRa_Cmd_Queue.Release(Index);
+
+  CmdFrame = LastFrame;
+  CmdLength = LastLength;
+  iwdg_feed();
+}
 
-    /*数据超出可以接收的范围*/
-    if (gReceiveLength >= 128)
+/*
+ @brief   : 根据帧长度字段，从接收缓存里同步出一帧完整的指令。
+            缓存开头不是0xFE的字节是噪音，直接丢弃。找到帧头后读出偏移3的数据长度，就知道整帧的确切长度
+            （帧头1 + 帧ID2 + 数据长度1 + 数据 + CRC8 1 + 帧尾6），等整帧收完后先确认帧尾，再逐字节累加CRC8。
+            收到前9个字节时先判断这一帧是不是发给本机的，帧ID认识、但发给其他设备的整帧跳过，不再等待、缓存和计算CRC8；
+            帧ID不认识的当作噪音，只跳过一个字节。
+            帧尾或CRC8不对，说明这个0xFE不是真正的帧头，只跳过这一个字节，从下一个0xFE重新同步。
+            按地址收发方式下（寄存器0x1C），每帧前面还有8个字节的硬件帧头，先校验其中的地址再同步0xFE帧。
+            全程只在环形缓存里移动读下标，校验通过后才把整帧拷贝出来，不需要搬移数据。
+ @param   : 无
+ @return  : true：FrameBuffer里是一帧校验通过的指令；false：缓存里还没有完整的指令
+ */
+bool Command_Analysis::Frame_Sync(void)
+{
+  const unsigned char FrameEnd[FRAME_END_LEN] = {0x0D, 0x0A, 0x0D, 0x0A, 0x0D, 0x0A};
+  unsigned int Available;
+  unsigned char c, Crc, DataLen;
+  unsigned char FrameLen = FRAME_FIXED_LEN;
+  unsigned char i;
+
+  while ((Available = LoRa_Rx_Buffer.Available()) > 0)
+  {
+    /*跳过不是发给本机的帧的剩余部分，不缓存也不校验*/
+    if (SkipRemainNum > 0)
     {
-      gReceiveLength = 0;
-      memset(gReceiveCmd, 0x00, sizeof(gReceiveCmd));
+      unsigned int Num = (Available < SkipRemainNum) ? Available : SkipRemainNum;
+      LoRa_Rx_Buffer.Skip(Num);
+      SkipRemainNum -= Num;
+      continue;
     }
 
-    //记录帧头所在接收的数据包里的位置（因为噪音的干扰，第一个字节可能不是帧头）
-    if (gReceiveCmd[gReceiveLength - 1] == 0xFE)
+    LoRa_Rx_Buffer.Peek_Byte(0, &c);
+
+    /*按地址接收时先同步硬件帧头，地址是本机或广播才去掉硬件帧头，接着同步紧跟的0xFE帧*/
+    if (LoRa_MHL9LF.Address_Mode() && !HwHeadFlag)
     {
-      FrameHeadDex = gReceiveLength - 1;
+      if (c != LORA_HW_HEAD)
+      {
+        LoRa_Rx_Buffer.Skip(1);
+        continue;
+      }
+
+      if (Available < LORA_HW_HEAD_LEN)
+      {
+        if (Frame_Wait(Available)) return false;
+        Frame_Resync();
+        continue;
+      }
+
+      unsigned char Addr[LORA_HW_ADDR_LEN];
+      for (i = 0; i < LORA_HW_ADDR_LEN; i++)
+        LoRa_Rx_Buffer.Peek_Byte(1 + i, &Addr[i]);
+
+      if (!LoRa_MHL9LF.Match_Hw_Addr(Addr))
+      {
+        HwAddrRejectNum++;
+        Frame_Resync();
+        continue;
+      }
+
+      LoRa_Rx_Buffer.Skip(LORA_HW_HEAD_LEN);
+      HwHeadFlag = true;
+      WaitAvailable = 0;
+      continue;
     }
 
-    /*验证帧尾: 0D 0A 0D 0A 0D 0A*/
-    if (EndNumFlag == false)
+    /*帧头之前的噪音直接丢弃*/
+    if (c != 0xFE)
     {
-      if (gReceiveCmd[gReceiveLength - 1] == 0x0D)  //如果检测到第一个帧尾
-        EndNumFlag = true;
+      LoRa_Rx_Buffer.Skip(1);
+      HwHeadFlag = false;   //硬件帧头后面不是0xFE，重新找硬件帧头
+      continue;
     }
-    /*接收校验剩余的帧尾*/
-    if (EndNumFlag == true)
+
+    if (Available > 3)
     {
-      switch (EndNum)
+      LoRa_Rx_Buffer.Peek_Byte(3, &DataLen);
+      if (DataLen > FRAME_MAX_LEN - FRAME_FIXED_LEN)  //数据超出可以接收的范围
       {
-        case 0 : gReceiveCmd[gReceiveLength - 1] == 0x0A ? EndNum += 1: EndNum = 0; break;
-        case 1 : gReceiveCmd[gReceiveLength - 1] == 0x0D ? EndNum += 1: EndNum = 0; break;
-        case 2 : gReceiveCmd[gReceiveLength - 1] == 0x0A ? EndNum += 1: EndNum = 0; break;
-        case 3 : gReceiveCmd[gReceiveLength - 1] == 0x0D ? EndNum += 1: EndNum = 0; break;
-        case 4 : gReceiveCmd[gReceiveLength - 1] == 0x0A ? EndNum += 1: EndNum = 0; break;
+        OversizeFrameNum++;
+        Frame_Resync();
+        continue;
       }
+      FrameLen = DataLen + FRAME_FIXED_LEN;
     }
-    if (EndNum == 5)  //帧尾校验正确
+
+    /*收到帧头前9个字节，马上判断是不是发给本机的指令，不是就整帧跳过*/
+    if (Available >= FRAME_HEADER_LEN && !HeaderCheckedFlag)
     {
-      EndNum = 0;
-      EndNumFlag = false;
-      ReceiveEndFlag = true;
-      Serial.println("Get frame end... <Receive_LoRa_Cmd>");
-      break;
+      unsigned char Header[FRAME_HEADER_LEN];
+      for (i = 0; i < FRAME_HEADER_LEN; i++)
+        LoRa_Rx_Buffer.Peek_Byte(i, &Header[i]);
+
+      Frame_Filter_Result Result = Verify_Frame_Header(Header, Find_Frame_Descriptor((Header[1] << 8) | Header[2]));
+      if (Result == Frame_Invalid)
+      {
+        Frame_Resync();
+        continue;
+      }
+      if (Result == Frame_Reject)
+      {
+        EarlyRejectNum++;
+        SkipRemainNum = FrameLen;
+        WaitAvailable = 0;
+        HwHeadFlag = false;
+        continue;
+      }
+      HeaderCheckedFlag = true;
     }
-  }
 
-  if (ReceiveEndFlag)
-  {
-    Serial.println("Parsing LoRa command... <Receive_LoRa_Cmd>");
-    ReceiveEndFlag = false;
+    /*一帧还没有收完。如果长时间没有新数据，说明这个帧头或长度是噪音，跳过它重新同步*/
+    if (Available <= 3 || Available < FrameLen)
+    {
+      if (Frame_Wait(Available)) return false;
+      Frame_Resync();
+      continue;
+    }
 
-    if (FrameHeadDex != 0)  //第一个字节不是0xFE，说明有噪音干扰，重新从0xFE开始组合出一帧
+    /*验证帧尾: 0D 0A 0D 0A 0D 0A*/
+    for (i = 0; i < FRAME_END_LEN; i++)
     {
-      unsigned char HeadStart = FrameHeadDex;
-      for (unsigned char i = 0; i < (gReceiveLength - HeadStart); i++)
-      {
-        gReceiveCmd[i] = gReceiveCmd[FrameHeadDex++];
-      }
+      LoRa_Rx_Buffer.Peek_Byte(FrameLen - FRAME_END_LEN + i, &c);
+      if (c != FrameEnd[i]) break;
+    }
+    if (i < FRAME_END_LEN)
+    {
+      FrameEndErrorNum++;
+      Frame_Resync();
+      continue;
     }
 
-    if (gIsHandleMsgFlag)
+    /*验证CRC8*/
+    Crc = 0;
+    for (i = 4; i < 4 + DataLen; i++)
     {
-      Receive_Data_Analysis();
+      LoRa_Rx_Buffer.Peek_Byte(i, &c);
+      Crc = Crc8_Update(Crc, c);
     }
-    gReceiveLength = 0;
-    iwdg_feed();
+    LoRa_Rx_Buffer.Peek_Byte(4 + DataLen, &c);
+    if (Crc != c)
+    {
+      CrcErrorNum++;
+      Serial.println("CRC8 ERROR! <Frame_Sync>");
+      Frame_Resync();
+      continue;
+    }
+
+    for (i = 0; i < FrameLen; i++)
+      LoRa_Rx_Buffer.Read_Byte(&FrameBuffer[i]);
+    FrameLength = FrameLen;
+    WaitAvailable = 0;
+    HeaderCheckedFlag = false;
+    HwHeadFlag = false;
+    return true;
   }
-  else
-    gReceiveLength = 0;
+  return false;
 }
 
 /*
- @brief     : 根据验证接收的帧ID，决定返回对应的指令枚举
- @param     : 无
- @return    : frame id type(enum) 
+ @brief   : 一帧还没有收完时判断是否继续等待。缓存里的字节数有变化就重新计时，超过等待时间没有新数据就不再等待。
+ @param   : 缓存里的字节数
+ @return  : true：继续等待；false：等待超时，当前帧头或长度是噪音，需要重新同步
  */
-Frame_ID Command_Analysis::FrameID_Analysis(void)
+bool Command_Analysis::Frame_Wait(unsigned int available)
 {
-  unsigned int FrameID = ((gReceiveCmd[1] << 8) | gReceiveCmd[2]);
-  switch (FrameID)
+  if (available != WaitAvailable)
   {
-    case 0xA011 : return Work_Para;       break;
-    case 0xA012 : return Set_Group_Num;   break;
-    case 0xA013 : return SN_Area_Channel; break;
-    case 0xA014 : return Work_Status;     break;
-    case 0xA015 : return Stop_Work;       break;
-    case 0xA020 : return ResetRoll;       break;
-    case 0xA021 : return Opening;         break;
-    case 0xA022 : return Work_Limit;      break;
+    WaitAvailable = available;
+    WaitStartTime = millis();
+    return true;
+  }
+  if (millis() - WaitStartTime < FRAME_WAIT_TIMEOUT)
+    return true;
+
+  SyncTimeoutNum++;
+  return false;
+}
 
-    default     : memset(gReceiveCmd, 0x00, sizeof(gReceiveCmd)); break;
+/*
+ @brief   : 当前的0xFE不是真正的帧头，跳过这一个字节，下一次从后面的0xFE重新同步
+ @param   : 无
+ @return  : 无
+ */
+void Command_Analysis::Frame_Resync(void)
+{
+  LoRa_Rx_Buffer.Skip(1);
+  WaitAvailable = 0;
+  HeaderCheckedFlag = false;
+  HwHeadFlag = false;
+}
+
+/*
+ @brief   : 按指令帧描述表中的优先级，把一帧校验通过的指令放入指令队列。
+ @param   : 1.指令数据
+            2.指令长度
+ @return  : true or false
+ */
+bool Command_Analysis::Queue_Frame(unsigned char *frame, unsigned char len)
+{
+  const Frame_Descriptor *Descriptor = Find_Frame_Descriptor((frame[1] << 8) | frame[2]);
+  if (Descriptor == NULL) return false;
+
+  bool RetargetFlag = false;
+  /*
+   *0到100的普通开度可以在开度卷膜中直接修改目标开度。
+   *F0、F1强制关棚、强制开棚也是卷膜动作，和其他卷膜指令一样等当前卷膜完成后再处理
+   */
+  if (Descriptor->Handler == &Command_Analysis::Opening_Command && frame[10] <= 100)
+    RetargetFlag = true;
+
+  return LoRa_Cmd_Queue.Push(frame, len, Descriptor->Priority, Descriptor->MotionFlag, RetargetFlag);
+}
+
+/*
+ @brief   : 在1ms的LoRa接收泵定时器中断里逐字节识别强制停止指令（A015）。收到一帧帧头、长度、帧尾、CRC8、设备类型、区域号和
+            工作组号都正确的A015，马上断开电机继电器并置位强制停止标志，不等主循环轮询到这条指令。
+            接收泵是定时轮询串口驱动缓存，不是串口接收中断，停止延时最多还要加上一个轮询周期。
+            这一帧照常进入接收缓存，回执、卷膜状态保存等仍由主循环里的 Stop_Work_Command 和 Force_Stop_Work 完成。
+            区域号和工作组号读的是参数RAM镜像，镜像没有加载时不能在中断里读EEPROM，只能等主循环处理。
+ @param   : 1.收到的字节
+            2.本次轮询开始的时间（us），用来统计最长的停止延时（A024寄存器0x1A可以读取）
+ @return  : 无
+ */
+void Command_Analysis::Fast_Stop_Detect(unsigned char c, unsigned long tick_time)
+{
+  const unsigned char Prefix[4] = {0xFE, 0xA0, 0x15, 0x06};
+  const unsigned char FrameEnd[FRAME_END_LEN] = {0x0D, 0x0A, 0x0D, 0x0A, 0x0D, 0x0A};
+
+  if (FastStopIndex < sizeof(Prefix))
+  {
+    if (c != Prefix[FastStopIndex])
+    {
+      FastStopIndex = 0;
+      if (c != Prefix[0]) return;
+    }
+    FastStopFrame[FastStopIndex++] = c;
+    return;
   }
+
+  FastStopFrame[FastStopIndex++] = c;
+  if (FastStopIndex < FAST_STOP_FRAME_LEN) return;
+  FastStopIndex = 0;
+
+  for (unsigned char i = 0; i < FRAME_END_LEN; i++)
+  {
+    if (FastStopFrame[FAST_STOP_FRAME_LEN - FRAME_END_LEN + i] != FrameEnd[i]) return;
+  }
+  if (GetCrc8(&FastStopFrame[4], Prefix[3]) != FastStopFrame[4 + Prefix[3]]) return;
+  if (!EEPROM_Operation.Param_Mirror_Valid()) return;
+  if (Verify_Frame_Header(FastStopFrame, Find_Frame_Descriptor(0xA015)) != Frame_Accept) return;
+
+  Motor_Operation.Direction_Selection(Stop);
+  gStopWorkFlag = true;
+  FastStopNum++;
+
+  unsigned long Latency = micros() - tick_time;
+  if (Latency > FastStopMaxLatency)
+    FastStopMaxLatency = Latency;
 }
 
 /*
- @brief     : 验证接收到的LoRa数据里的CRC8校验码
- @param     : 1.验证数据的起始地址
-              2.验证数据的长度
- @return    : true or false.
+ @brief   : 清零强制停止次数和最长停止延时，重新开始统计
+ @param   : 无
+ @return  : 无
  */
-bool Command_Analysis::Verify_CRC8(unsigned char verify_data_base_addr, unsigned char verify_data_len)
+void Command_Analysis::Clear_Fast_Stop_Statistics(void)
 {
-  unsigned char ReceiveCRC8 = GetCrc8(&gReceiveCmd[verify_data_base_addr], verify_data_len);
-  if (ReceiveCRC8 == gReceiveCmd[gReceiveLength - 7])
-    return true;
-  else
-    return false;
+  noInterrupts();
+  FastStopNum = 0;
+  FastStopMaxLatency = 0;
+  interrupts();
 }
 
 /*
- @brief   : 验证接收的设备ID与本机是否相同
+ @brief   : 打印LoRa接收统计信息：环形缓存丢弃的字节数、溢出次数、最高水位，帧同步失败的次数、提前丢弃的非本机指令数，以及指令队列丢弃的帧数。
+            用于根据网关实际的数据密度调整接收缓存的大小。
  @param   : 无
+ @return  : 无
+ */
+void Command_Analysis::Print_Rx_Statistics(void)
+{
+  Serial.print("LoRa Rx drop bytes: ");
+  Serial.print(LoRa_Rx_Buffer.Drop_Bytes());
+  Serial.print(", overflow times: ");
+  Serial.print(LoRa_Rx_Buffer.Overflow_Times());
+  Serial.print(", peak bytes: ");
+  Serial.print(LoRa_Rx_Buffer.Peak_Bytes());
+  Serial.print(", oversize frames: ");
+  Serial.print(OversizeFrameNum);
+  Serial.print(", frame end err: ");
+  Serial.print(FrameEndErrorNum);
+  Serial.print(", CRC8 err: ");
+  Serial.print(CrcErrorNum);
+  Serial.print(", sync timeout: ");
+  Serial.print(SyncTimeoutNum);
+  Serial.print(", early reject: ");
+  Serial.print(EarlyRejectNum);
+  Serial.print(", hw addr reject: ");
+  Serial.print(HwAddrRejectNum);
+  Serial.print(", queue drop: ");
+  Serial.print(LoRa_Cmd_Queue.Drop_Num());
+  Serial.print(", queue evict: ");
+  Serial.print(LoRa_Cmd_Queue.Evict_Num());
+  Serial.print(", tx drop: ");
+  Serial.print(LoRa_Tx_Queue.Drop_Num());
+  Serial.print(", tx replace: ");
+  Serial.print(LoRa_Tx_Queue.Replace_Num());
+  Serial.print(", tx combine: ");
+  Serial.print(LoRa_Tx_Queue.Combine_Num());
+  Serial.print(", tx ack: ");
+  Serial.print(LoRa_Tx_Queue.Ack_Num());
+  Serial.print(", tx retransmit: ");
+  Serial.print(LoRa_Tx_Queue.Retransmit_Num());
+  Serial.print(", tx ack fail: ");
+  Serial.print(LoRa_Tx_Queue.Ack_Fail_Num());
+  Serial.print(", tx busy defer: ");
+  Serial.print(LoRa_Tx_Queue.Defer_Num());
+  Serial.print(", tx busy force: ");
+  Serial.print(LoRa_Tx_Queue.Force_Num());
+  Serial.print(", tx defer max: ");
+  Serial.print(LoRa_Tx_Queue.Defer_Max());
+  Serial.print(", duplicate hit: ");
+  Serial.print(LoRa_Cmd_Cache.Hit_Num());
+  Serial.print(", fast stop: ");
+  Serial.print(FastStopNum);
+  Serial.print(", fast stop max latency(us): ");
+  Serial.print(FastStopMaxLatency);
+  Serial.println(" <Print_Rx_Statistics>");
+}
+
+/*
+ @brief   : 验证接收的设备ID与本机是否相同
+ @param   : 帧头数据（至少9个字节）
  @return  : true or false            
  */
-bool Command_Analysis::Verify_Device_Type_ID(void)
+bool Command_Analysis::Verify_Device_Type_ID(const unsigned char *header)
 {
-  unsigned int DeviceTypeID = ((gReceiveCmd[4] << 8) | gReceiveCmd[5]);
+  unsigned int DeviceTypeID = ((header[4] << 8) | header[5]);
   if (DeviceTypeID == 0x5555)
     return true;
 
@@ -181,20 +476,20 @@ bool Command_Analysis::Verify_Device_Type_ID(void)
  */
 void Command_Analysis::Verify_Mass_Commands(void)
 {
-  gReceiveCmd[6] == 0x55 ? gMassCommandFlag = true : gMassCommandFlag = false;
+  CmdFrame[6] == 0x55 ? gMassCommandFlag = true : gMassCommandFlag = false;
 }
 
 /*
  @brief   : 验证接收的区域号与本地是否相同
- @param   : 无
+ @param   : 帧头数据（至少9个字节）
  @return  : true or false            
  */
-bool Command_Analysis::Verify_Area_Number(void)
+bool Command_Analysis::Verify_Area_Number(const unsigned char *header)
 {
-  if (gReceiveCmd[7] == 0x55) return true;  //0x55:群控指令，忽略区域号
+  if (header[7] == 0x55) return true;  //0x55:群控指令，忽略区域号
     
   unsigned char LocalAreaNumber = Roll_Operation.Read_Area_Number();
-  if (gReceiveCmd[7] == LocalAreaNumber || LocalAreaNumber == 0) 
+  if (header[7] == LocalAreaNumber || LocalAreaNumber == 0) 
     return true;
   else  
     return false;
@@ -204,14 +499,32 @@ bool Command_Analysis::Verify_Area_Number(void)
  @brief   : 验证接收的工作组号是否在本机组控列表内。
             如果接收的组号是0x55，表明此指令忽略组控，发送给区域内所有的设备
             如果本设备还未申请注册过服务器，不用校验组号。
- @param   : 无
+ @param   : 帧头数据（至少9个字节）
  @return  : true or false
  */
-bool Command_Analysis::Verify_Work_Group(void)
+bool Command_Analysis::Verify_Work_Group(const unsigned char *header)
 {
-  if (gReceiveCmd[8] == 0x55) return true;  //0x55:群控指令，忽略工作组号
+  return Match_Work_Group(header[8]);
+}
+
+/*
+ @brief   : 判断一个工作组号是否在本机组控列表内。工作组位图在RAM镜像里，只需要测试一位；
+            还没有生成位图时（旧版本升级失败）按5个工作组号查找。
+ @param   : 工作组号，0x55表示所有工作组
+ @return  : true or false
+ */
+bool Command_Analysis::Match_Work_Group(unsigned char group)
+{
+  if (group == 0x55) return true;  //0x55:群控指令，忽略工作组号
+
+  if (Roll_Operation.Verify_Group_Bitmap_Flag())
+  {
+    /*没有加入任何工作组，说明是未初始化的组号，算校验通过*/
+    if (Roll_Operation.Read_Group_Bitmap_Num() == 0) return true;
+    return Roll_Operation.Is_Group_Member(group);
+  }
 
-  unsigned char LocalGroupNumber[5], ReceiveGroupSingleNumber = gReceiveCmd[8];
+  unsigned char LocalGroupNumber[5], ReceiveGroupSingleNumber = group;
   unsigned char UndefinedGroupNum = 0;
   Roll_Operation.Read_Group_Number(&LocalGroupNumber[0]);
 
@@ -231,59 +544,75 @@ bool Command_Analysis::Verify_Work_Group(void)
 }
 
 /*
- @brief   : 验证接收的指令CRC8校验、设备类型码、区域号、工作组是否合法。
-            可以通过形参决定是否屏蔽验证区域号和工作组。
- @param   : 1.验证的数据起始地址
-            2.验证的数据长度
-            3.是否要验证区域号标志位
-            4.是否要验证工作组号标志位
- @return  : true or false.
+ @brief   : 收到帧头的前9个字节（设备类型ID、群发标志、区域号、工作组号）后，按指令帧描述表判断这一帧是否可能是发给本机的。
+            这是指令唯一的一次合法性校验，后面的处理不再重复读EEPROM校验区域号和工作组号。
+ @param   : 1.帧头数据（至少9个字节）
+            2.查表得到的指令帧描述，没有找到为NULL
+ @return  : Frame_Accept：可能是本机的指令；Frame_Reject：不是本机的指令，整帧跳过；Frame_Invalid：帧头不合法，重新同步。
+            只有帧ID在表里、长度合法的帧才按长度字段整帧跳过；帧ID不认识时长度字段不可信，
+            可能是噪音里的0xFE，整帧跳过会吞掉后面真正的指令，只能逐字节重新同步
  */
-bool Command_Analysis::Verify_Frame_Validity(unsigned char verify_data_base_addr, unsigned char verify_data_len, bool area_flag = true, bool group_flag = true)
+Command_Analysis::Frame_Filter_Result Command_Analysis::Verify_Frame_Header(const unsigned char *header, const Frame_Descriptor *descriptor)
 {
-  if (Verify_CRC8(verify_data_base_addr, verify_data_len) == true)
-  {
-    if (Verify_Device_Type_ID() == true)
-    {
-      Verify_Mass_Commands();
-      if (Verify_Area_Number() == true || area_flag == false)
-      {
-        if (Verify_Work_Group() == true || group_flag == false)
-          return true;
-        else
-          Serial.println("Not this device group number... <Verify_Frame_Validity>");
-      }
-      else
-        Serial.println("Not this device area number... <Verify_Frame_Validity>");
-    }
-    else
-      Serial.println("Device type ID ERROR! <Verify_Frame_Validity>");
-  }
-  else
-    Serial.println("CRC8 ERROR! <Verify_Frame_Validity>");
-  return false;
+  if (descriptor == NULL)                         return Frame_Invalid; //不认识的帧ID，不是真正的帧头或本机不处理
+  if (descriptor->DataLen != FRAME_VAR_LEN && header[3] != descriptor->DataLen) return Frame_Invalid; //长度不对，不是真正的帧头
+  if (Verify_Device_Type_ID(header) == false)     return Frame_Reject;  //其他类型设备的指令
+
+  if (descriptor->NetworkFlag && gAccessNetworkFlag == false)       return Frame_Reject;  //如果设备还未注册到服务器，无视该指令
+  if (descriptor->AreaFlag && Verify_Area_Number(header) == false)  return Frame_Reject;
+  if (descriptor->GroupFlag && Verify_Work_Group(header) == false)  return Frame_Reject;
+
+  return Frame_Accept;
 }
 
 /*
- @brief   : 根据帧ID分析判断执行哪一个接收到的通用指令或私有指令
+ @brief   : 根据帧ID查表，执行对应的通用指令或私有指令。
+            需要去重的指令如果在时间窗口内处理过（帧ID、数据哈希、CRC8都相同），说明是服务器没收到回执的重发，
+            不再执行，只重发当时的回执。处理后发出过回执的指令才记入缓存，没有回执的指令服务器重发时仍然执行。
  @param   : 无
  @return  : 无
  */
 void Command_Analysis::Receive_Data_Analysis(void)
 {
-  switch (FrameID_Analysis())
+  const Frame_Descriptor *Descriptor = Find_Frame_Descriptor((CmdFrame[1] << 8) | CmdFrame[2]);
+  if (Descriptor == NULL) return;
+
+  Verify_Mass_Commands();
+
+  /*卷膜过程中会嵌套处理指令，保存外层指令已经发出的回执记录*/
+  Receipt_Record OuterRecord = Message_Receipt.Read_Record();
+  Message_Receipt.Clear_Record();
+
+  if (Descriptor->CacheFlag)
   {
-    /*通用指令*/
-    case Work_Para        : Query_Current_Work_Param();  break;
-    case Set_Group_Num    : Set_Group_Number();         break;
-    case SN_Area_Channel  : Set_SN_Area_Channel();      break;
-    case Work_Status      : Detailed_Work_Status();     break;
-    case Stop_Work        : Stop_Work_Command();        break;
-    /*卷膜机私有指令*/
-    case ResetRoll        : ResetRoll_Command();        break;
-    case Opening          : Opening_Command();          break;
-    case Work_Limit       : Working_Limit_Command();    break;
+    unsigned int PayloadHash = Command_Cache::Payload_Hash(&CmdFrame[4], CmdFrame[3]);
+    unsigned char Crc = CmdFrame[4 + CmdFrame[3]];
+    signed char Index = LoRa_Cmd_Cache.Find(Descriptor->FrameID, PayloadHash, Crc);
+
+    if (Index >= 0)
+    {
+      Serial.println("Duplicate command, replay cached receipt... <Receive_Data_Analysis>");
+      Message_Receipt.Replay_Record(LoRa_Cmd_Cache.Record(Index));
+    }
+    else
+    {
+      if (Descriptor->MotionFlag) LoRa_Cmd_Cache.Clear_Motion();
+      unsigned long ClearNum = LoRa_Cmd_Cache.Motion_Clear_Num();
+
+      (this->*Descriptor->Handler)();
+
+      /*卷膜过程中嵌套收到停止或其他动作指令，这条指令的结果已经被改变，不再缓存*/
+      if (Message_Receipt.Read_Record().SentFlags != 0 && !(Descriptor->MotionFlag && LoRa_Cmd_Cache.Motion_Clear_Num() != ClearNum))
+        LoRa_Cmd_Cache.Save(Descriptor->FrameID, PayloadHash, Crc, Descriptor->MotionFlag, Message_Receipt.Read_Record());
+    }
+  }
+  else
+  {
+    if (Descriptor->MotionFlag) LoRa_Cmd_Cache.Clear_Motion();
+    (this->*Descriptor->Handler)();
   }
+
+  Message_Receipt.Write_Record(OuterRecord);
 }
 
 /*
@@ -296,32 +625,26 @@ void Command_Analysis::Query_Current_Work_Param(void)
   //  帧头     |    帧ID   |  数据长度   |    设备类型ID   | 群发标志位  |所在执行区域号 | 申号标志 |  查询角色 | 采集时间间隔      |  时间   |  预留位     |  校验码  |     帧尾 
   //Frame head | Frame ID | Data Length | Device type ID |  mass flag |  Area number | intent   |  channel | collect interval  |  RTC   |   allocate  |  CRC8   |  Frame end
   //  1 byte       2 byte      1 byte          2 byte        1 byte       1 byte       1 byte      1 byte      2 byte           7 byte      8 byte     1 byte      6 byte
-  
-  if (gAccessNetworkFlag == false)  return;  //如果设备还未注册到服务器，无视该指令
 
-  if (Verify_Frame_Validity(4, 23, true, false) == true)
+  if (CmdFrame[8] == 0x01) //配置参数标志（LoRa大棚传感器是0x00配置采集时间）
   {
-    if (gReceiveCmd[8] == 0x01) //配置参数标志（LoRa大棚传感器是0x00配置采集时间）
+    /* 预留位第一字节用来设置LoRa的通信模式 */
+    if(LoRa_Para_Config.Save_LoRa_Com_Mode(CmdFrame[19]))
     {
-      /* 预留位第一字节用来设置LoRa的通信模式 */
-      if(LoRa_Para_Config.Save_LoRa_Com_Mode(gReceiveCmd[19]))
-      {
-        Message_Receipt.General_Receipt(SetLoRaModeOk, 1);
-        LoRa_MHL9LF.Parameter_Init(true);
-        Message_Receipt.Working_Parameter_Receipt(true, 2);
-      }
-      else 
-      {
-        Message_Receipt.General_Receipt(SetLoRaModeErr, 2);
-        Serial.println("Set LoRa Mode Err! <Query_Current_Work_Param>");
-      }
+      Message_Receipt.General_Receipt(SetLoRaModeOk, 1);
+      LoRa_MHL9LF.Parameter_Init(true);
+      Message_Receipt.Full_Working_Receipt(true, 2);
     }
-    else  //回执状态标志
+    else 
     {
-      Message_Receipt.Report_General_Parameter();
+      Message_Receipt.General_Receipt(SetLoRaModeErr, 2);
+      Serial.println("Set LoRa Mode Err! <Query_Current_Work_Param>");
     }
   }
-  memset(gReceiveCmd, 0x00, gReceiveLength);
+  else  //回执状态标志
+  {
+    Message_Receipt.Report_General_Parameter();
+  }
 }
 
 /*
@@ -334,24 +657,81 @@ void Command_Analysis::Set_Group_Number(void)
   //  帧头     |    帧ID   |  数据长度   |    设备类型ID   | 群发标志位   |所在执行区域号 | 工作组号   | 设备路数 |  校验码  |     帧尾 
   //Frame head | Frame ID | Data Length | Device type ID | mass flag   |  Area number |  workgroup |  channel |   CRC8 |  |  Frame end
   //  1 byte       2 byte      1 byte          2 byte        1 byte         1 byte        5 byte       1 byte    1 byte      6 byte
-  
-  if (gAccessNetworkFlag == false)  return;  //如果设备还未注册到服务器，无视该指令
 
-  if (Verify_Frame_Validity(4, 10, true, false) == true)
+  if (CmdFrame[3] != GROUP_LIST_DATA_LEN)
   {
-    if(Roll_Operation.Save_Group_Number(&gReceiveCmd[8]) == true)
-    {
-      Serial.println("Save group number success... <Set_Group_Number>");
-      Message_Receipt.General_Receipt(AssignGroupIdArrayOk, 2);
-    }
+    Set_Group_Bitmap();
+    return;
+  }
+
+  if(Roll_Operation.Save_Group_Number(&CmdFrame[8]) == true && Roll_Operation.Rebuild_Group_Bitmap() == true)
+  {
+    Serial.println("Save group number success... <Set_Group_Number>");
+    Message_Receipt.General_Receipt(AssignGroupIdArrayOk, 2);
+  }
+  else
+  {
+    Serial.println("Save group number failed !!! <Set_Group_Number>");
+    Set_Motor_Status(STORE_EXCEPTION);
+    Message_Receipt.General_Receipt(AssignGroupIdArrayErr, 1);
+  }
+}
+
+/*
+ @brief   : 按工作组列表批量加入、退出或重新设置本设备的工作组（服务器 ---> 本设备）
+            工作组保存为256位的位图，可以同时属于任意多个工作组。前5个工作组同时保存为原来的工作组号，用于上报。
+ @param   : 无
+ @return  : 无
+ */
+void Command_Analysis::Set_Group_Bitmap(void)
+{
+  //  帧头     |    帧ID   |  数据长度   |    设备类型ID   | 群发标志位   |所在执行区域号 | 操作       | 组数     | 工作组号列表 | 校验码  |     帧尾 
+  //Frame head | Frame ID | Data Length | Device type ID | mass flag   |  Area number | operation | group num |  group list |  CRC8  |  Frame end
+  //  1 byte       2 byte      1 byte          2 byte        1 byte         1 byte        1 byte      1 byte      N byte      1 byte      6 byte
+  //  操作：0x01加入列表中的工作组，0x02退出列表中的工作组，0x03只属于列表中的工作组
+
+  unsigned char Operation = CmdFrame[8];
+  unsigned char GroupNum = CmdFrame[9];
+  unsigned char Bitmap[GROUP_BITMAP_LEN] = {0};
+
+  if (CmdFrame[3] != GROUP_BITMAP_HEAD_LEN + GroupNum || Operation < GROUP_OP_SET || Operation > GROUP_OP_REPLACE)
+  {
+    Serial.println("Group bitmap command ERROR !!! <Set_Group_Bitmap>");
+    Message_Receipt.General_Receipt(AssignGroupIdArrayErr, 1);
+    return;
+  }
+
+  /*加入或退出工作组在原来的位图上修改，位图损坏时只能按新的列表重新设置*/
+  if (Operation != GROUP_OP_REPLACE && !Roll_Operation.Read_Group_Bitmap(Bitmap))
+  {
+    Serial.println("Read group bitmap ERROR !!! <Set_Group_Bitmap>");
+    Message_Receipt.General_Receipt(AssignGroupIdArrayErr, 1);
+    return;
+  }
+
+  for (unsigned char i = 0; i < GroupNum; i++)
+  {
+    unsigned char Group = CmdFrame[10 + i];
+    if (Group == 0x00 || Group == 0x55) continue;  //不是真正的组号
+
+    if (Operation == GROUP_OP_CLEAR)
+      Bitmap[Group >> 3] &= ~(1 << (Group & 0x07));
     else
-    {
-      Serial.println("Save group number failed !!! <Set_Group_Number>");
-      Set_Motor_Status(STORE_EXCEPTION);
-      Message_Receipt.General_Receipt(AssignGroupIdArrayErr, 1);
-    }
+      Bitmap[Group >> 3] |= (1 << (Group & 0x07));
+  }
+
+  /*前5个工作组保存为原来的工作组号*/
+  if (Roll_Operation.Save_Group_Bitmap(Bitmap) == true && Roll_Operation.Rebuild_Group_Number() == true)
+  {
+    Serial.println("Save group bitmap success... <Set_Group_Bitmap>");
+    Message_Receipt.General_Receipt(AssignGroupIdArrayOk, 2);
+  }
+  else
+  {
+    Serial.println("Save group bitmap failed !!! <Set_Group_Bitmap>");
+    Set_Motor_Status(STORE_EXCEPTION);
+    Message_Receipt.General_Receipt(AssignGroupIdArrayErr, 1);
   }
-  memset(gReceiveCmd, 0x00, gReceiveLength);
 }
 
 /*
@@ -365,32 +745,28 @@ void Command_Analysis::Set_SN_Area_Channel(void)
   //Frame head | Frame ID | Data Length | Device type ID | mass flag   |   Area number | Device channel |  subordinate channel   | SN code     |  CRC8   |  Frame end
   //  1 byte       2 byte      1 byte          2 byte        1 byte          1 byte          1 byte           1 byte                9 byte       1 byte      6 byte
 
-  if (Verify_Frame_Validity(4, 15, false, false) == true)
+  if (SN.Save_SN_Code(&CmdFrame[10]) == true && SN.Save_BKP_SN_Code(&CmdFrame[10]) == true)
   {
-    if (SN.Save_SN_Code(&gReceiveCmd[10]) == true && SN.Save_BKP_SN_Code(&gReceiveCmd[10]) == true)
+    Serial.println("Set SN code success... <Set_SN_Area_Channel>");
+    if (Roll_Operation.Save_Area_Number(CmdFrame[7]) == true)
     {
-      Serial.println("Set SN code success... <Set_SN_Area_Channel>");
-      if (Roll_Operation.Save_Area_Number(gReceiveCmd[7]) == true)
-      {
-        Serial.println("Save area number success... <Set_SN_Area_Channel>");
-        Message_Receipt.General_Receipt(SetSnAndSlaverCountOk, 1);
-        SN.Set_SN_Access_Network_Flag();
-      }
-      else
-      {
-        Serial.println("Save area number ERROR !!! <Set_SN_Area_Channel>");
-        Set_Motor_Status(STORE_EXCEPTION);
-        Message_Receipt.General_Receipt(SetSnAndSlaverCountErr, 1);
-      }
+      Serial.println("Save area number success... <Set_SN_Area_Channel>");
+      Message_Receipt.General_Receipt(SetSnAndSlaverCountOk, 1);
+      SN.Set_SN_Access_Network_Flag();
     }
     else
     {
-      Serial.println("Save SN code ERROR !!! <Set_SN_Area_Channel>");
+      Serial.println("Save area number ERROR !!! <Set_SN_Area_Channel>");
       Set_Motor_Status(STORE_EXCEPTION);
       Message_Receipt.General_Receipt(SetSnAndSlaverCountErr, 1);
     }
   }
-  memset(gReceiveCmd, 0x00, gReceiveLength);
+  else
+  {
+    Serial.println("Save SN code ERROR !!! <Set_SN_Area_Channel>");
+    Set_Motor_Status(STORE_EXCEPTION);
+    Message_Receipt.General_Receipt(SetSnAndSlaverCountErr, 1);
+  }
 }
 
 /*
@@ -403,13 +779,117 @@ void Command_Analysis::Detailed_Work_Status(void)
   //  帧头     |    帧ID   |  数据长度   |    设备类型ID   | 群发标志位  |所在执行区域号 |  设备路数 |  校验码  |     帧尾 
   //Frame head | Frame ID | Data Length | Device type ID |  mass flag |  Area number |   channel |   CRC8 |  |  Frame end
   //  1 byte       2 byte      1 byte          2 byte        1 byte        1 byte         1 byte    1 byte      6 byte
-  
-  if (gAccessNetworkFlag == false)  return;  //如果设备还未注册到服务器，无视该指令
 
-  if (Verify_Frame_Validity(4, 5, true, false) == true)
-    Message_Receipt.Working_Parameter_Receipt(true, 1);
+  Message_Receipt.Full_Working_Receipt(true, 1);
+}
+
+/*
+ @brief   : 设置RTC时间（服务器 ---> 本设备）。校时的同时估计晶振漂移，并按新的时间重新设置定时卷膜闹钟
+ @param   : 无
+ @return  : 无
+ */
+void Command_Analysis::Set_RTC_Command(void)
+{
+  //  帧头     |    帧ID   |  数据长度   |    设备类型ID   | 群发标志位  |所在执行区域号 | RTC时间 | 校验码 | 帧尾 
+  //Frame head | Frame ID | Data Length | Device type ID |  mass flag |  Area number |   RTC   |  CRC8 | Frame end
+  //  1 byte       2 byte      1 byte          2 byte        1 byte         1 byte       6 byte    1 byte  6 byte
+
+  UTCTime NewTime;
+
+  if (!Private_RTC.Convert_Time(&CmdFrame[8], &NewTime) || !Private_RTC.Time_Valid(NewTime))
+  {
+    Serial.println("RTC time ERROR !!! <Set_RTC_Command>");
+    Message_Receipt.General_Receipt(SetRtcErr, 1);
+    return;
+  }
 
-  memset(gReceiveCmd, 0x00, gReceiveLength);
+  Private_RTC.Set_Time(NewTime);
+  Roll_Schedule.Arm();
+  Message_Receipt.General_Receipt(SetRtcOk, 1);
+}
+
+/*
+ @brief   : 设置定时卷膜时间段（服务器 ---> 本设备）。设置后本机按RTC时间自己卷膜，只回执结果
+            数字输出的设定参数为1字节，0x00关棚，其他开棚；模拟输出为3字节，表示开度（0 - 100）
+ @param   : 无
+ @return  : 无
+ */
+void Command_Analysis::Set_Schedule_Command(void)
+{
+  //  帧头     |    帧ID   |  数据长度   |    设备类型ID   | 群发标志位  |所在执行区域号 | 执行方式 | 接口类型ID | 设备路数 | 时间段序号 | 设定参数 | 开始时间 | 结束时间 | 校验码 | 帧尾 
+  //Frame head | Frame ID | Data Length | Device type ID |  mass flag |  Area number |   mode   | interface | channel | sequence  |   para   |  start   |   end   |  CRC8 | Frame end
+  //  1 byte       2 byte      1 byte          2 byte        1 byte         1 byte       1 byte     2 byte      1 byte    1 byte      1/3 byte   6 byte     6 byte    1 byte  6 byte
+
+  unsigned char ParaLen;
+  Schedule_Entry Entry;
+
+  if (CmdFrame[3] == SCHEDULE_DIGITAL_DATA_LEN)
+    ParaLen = 1;
+  else if (CmdFrame[3] == SCHEDULE_ANALOG_DATA_LEN)
+    ParaLen = 3;
+  else
+  {
+    Serial.println("Schedule data length ERROR !!! <Set_Schedule_Command>");
+    return;
+  }
+
+  if (!Match_Channel(CmdFrame[11]))
+  {
+    Serial.println("Not this channel... <Set_Schedule_Command>");
+    return;
+  }
+
+  unsigned char Sequence = CmdFrame[12];
+  const unsigned char *Para = &CmdFrame[13];
+  const unsigned char *Time = &CmdFrame[13 + ParaLen];
+
+  Entry.Mode = CmdFrame[8];
+  if (ParaLen == 1)
+    Entry.Opening = (Para[0] == 0x00) ? 0 : 100;
+  else
+  {
+    unsigned long Value = ((unsigned long)Para[0] << 16) | (Para[1] << 8) | Para[2];
+    Entry.Opening = (Value <= 100) ? Value : 0xFF;
+  }
+
+  if (Sequence < 1 || Sequence > SCHEDULE_NUM || Entry.Mode > SCHEDULE_ONCE || Entry.Opening > 100
+    || !Private_RTC.Convert_Time(Time, &Entry.Start) || !Private_RTC.Convert_Time(Time + SCHEDULE_TIME_LEN, &Entry.End)
+    || (Entry.Mode == SCHEDULE_ONCE && Entry.End <= Entry.Start))
+  {
+    Serial.println("Schedule param ERROR !!! <Set_Schedule_Command>");
+    Message_Receipt.General_Receipt(SetScheduleErr, 1);
+    return;
+  }
+
+  Serial.print("Schedule "); Serial.print(Sequence);
+  Serial.print(", mode: "); Serial.print(Entry.Mode);
+  Serial.print(", opening: "); Serial.print(Entry.Opening);
+  Serial.println(" <Set_Schedule_Command>");
+
+  if (Roll_Schedule.Set(Sequence - 1, Entry))
+    Message_Receipt.General_Receipt(SetScheduleOk, 1);
+  else
+  {
+    Serial.println("Save schedule ERROR !!! <Set_Schedule_Command>");
+    Message_Receipt.General_Receipt(SetScheduleErr, 1);
+  }
+}
+
+/*
+ @brief   : 定时卷膜时间到，按时间段设定的开度卷膜。在主循环里调用
+ @param   : 无
+ @return  : 无
+ */
+void Command_Analysis::Schedule_Check(void)
+{
+  unsigned char Opening;
+
+  if (!Roll_Schedule.Fetch_Event(&Opening)) return;
+
+  Serial.print("Schedule time, opening: "); Serial.print(Opening);
+  Serial.println(" <Schedule_Check>");
+  LoRa_Cmd_Cache.Clear_Motion();
+  Execute_Opening(Opening);
 }
 
 /*
@@ -422,16 +902,27 @@ void Command_Analysis::Stop_Work_Command(void)
   //  帧头     |    帧ID   |  数据长度   |    设备类型ID   | 群发标志位  |所在执行区域号 |  设备路数 |  校验码  |     帧尾 
   //Frame head | Frame ID | Data Length | Device type ID |  mass flag |  Area number |   channel |   CRC8 |  |  Frame end
   //  1 byte       2 byte      1 byte          2 byte        1 byte        1 byte         1 byte    1 byte      6 byte
-  
-  if (gAccessNetworkFlag == false)  return;  //如果设备还未注册到服务器，无视该指令
 
-  if (Verify_Frame_Validity(4, 6, true, true) == true)
+  gStopWorkFlag = true;
+  LoRa_Cmd_Cache.Clear_Motion();
+  Message_Receipt.General_Receipt(TrunOffOk, 1);
+  MANUAL_ROLL_ON;  //使能手动
+}
+
+/*
+ @brief     : 设置开关状态（服务器 ---> 本设备）。数据长度为6的是原来的重置行程指令，
+              数据长度为19的是协议里按路数设置开度和超时时间的指令
+ @param     : 无
+ @return    : 无
+ */
+void Command_Analysis::Switch_Status_Command(void)
+{
+  switch (CmdFrame[3])
   {
-    gStopWorkFlag = true;
-    Message_Receipt.General_Receipt(TrunOffOk, 1);
-    MANUAL_ROLL_ON;  //使能手动
+    case RESET_ROLL_DATA_LEN    : ResetRoll_Command(); break;
+    case RATIO_OPENING_DATA_LEN : Ratio_Opening_Command(); break;
+    default                     : Serial.println("Switch status data length ERROR !!! <Switch_Status_Command>"); break;
   }
-  memset(gReceiveCmd, 0x00, gReceiveLength);
 }
 
 /*
@@ -444,51 +935,113 @@ void Command_Analysis::ResetRoll_Command(void)
   //  帧头     |    帧ID   |  数据长度   |    设备类型ID   | 群发标志位 |所在执行区域号 |  工作组号   | 设备路数 |  校验码  |     帧尾 
   //Frame head | Frame ID | Data Length | Device type ID |  mass flag  |  Area number |   workgroup | channel |   CRC8 |  |  Frame end
   //  1 byte       2 byte      1 byte          2 byte        1 byte          1 byte         1 byte      1 byte    1 byte      6 byte
-  
-  if (gAccessNetworkFlag == false)  return;  //如果设备还未注册到服务器，无视该指令
 
-  if (Verify_Frame_Validity(4, 6, true, true) == true)
+  /*如果电机手动卷膜按键电路异常，禁止自动卷膜，等待更换设备*/
+  if (gManualKeyExceptionFlag)
   {
-    /*如果电机手动卷膜按键电路异常，禁止自动卷膜，等待更换设备*/
-    if (gManualKeyExceptionFlag)
-    {
-      Serial.println("Manual roll key exception !!! <ResetRoll_Command>");
-      return;
-    }
-    /*如果当前正在卷膜，不进行二次卷膜*/
-    else if (gResetRollWorkingFlag == true || gOpeningWorkingFlag == true || gForceRollWorkingFlag == true)
+    Serial.println("Manual roll key exception !!! <ResetRoll_Command>");
+    return;
+  }
+  /*如果当前正在卷膜，不进行二次卷膜*/
+  else if (gResetRollWorkingFlag == true || gOpeningWorkingFlag == true || gForceRollWorkingFlag == true)
+  {
+    Serial.println("The motor is resetting the distance... <ResetRoll_Command>");
+    return;
+  }
+  /*如果当前正在手动卷膜。拒绝执行自动卷膜*/
+  else if (gManualUpDetectFlag || gManualDownDetectFlag)
+  {
+    if (digitalRead(DEC_MANUAL_UP_PIN) == LOW)  gManualUpDetectFlag = false;
+    if (digitalRead(DEC_MANUAL_DOWN_PIN) == LOW) gManualDownDetectFlag = false;
+    if (gManualUpDetectFlag || gManualDownDetectFlag)
     {
-      Serial.println("The motor is resetting the distance... <ResetRoll_Command>");
+      Serial.println("Detect manual rolling... <ResetRoll_Command>");
+      /*
+        *待处理事情
+      */
       return;
     }
-    /*如果当前正在手动卷膜。拒绝执行自动卷膜*/
-    else if (gManualUpDetectFlag || gManualDownDetectFlag)
-    {
-      if (digitalRead(DEC_MANUAL_UP_PIN) == LOW)  gManualUpDetectFlag = false;
-      if (digitalRead(DEC_MANUAL_DOWN_PIN) == LOW) gManualDownDetectFlag = false;
-      if (gManualUpDetectFlag || gManualDownDetectFlag)
-      {
-        Serial.println("Detect manual rolling... <ResetRoll_Command>");
-        /*
-          *待处理事情
-        */
-        return;
-      }
-    }
-    else
-    {
-      MANUAL_ROLL_OFF;
-      detachInterrupt(DEC_MANUAL_DOWN_PIN);
-      detachInterrupt(DEC_MANUAL_UP_PIN);
-      Message_Receipt.General_Receipt(RestRollerOk, 1);
-      Motor_Operation.Reset_Motor_Route();
-      attachInterrupt(DEC_MANUAL_UP_PIN, Manual_Up_Change_Interrupt, CHANGE);
-      attachInterrupt(DEC_MANUAL_DOWN_PIN, Manual_Down_Change_Interrupt, CHANGE);
-      MANUAL_ROLL_ON;
-      iwdg_feed();
-    }
   }
-  memset(gReceiveCmd, 0x00, gReceiveLength);
+  else
+  {
+    MANUAL_ROLL_OFF;
+    detachInterrupt(DEC_MANUAL_DOWN_PIN);
+    detachInterrupt(DEC_MANUAL_UP_PIN);
+    Message_Receipt.General_Receipt(RestRollerOk, 1);
+    Motor_Operation.Reset_Motor_Route();
+    attachInterrupt(DEC_MANUAL_UP_PIN, Manual_Up_Change_Interrupt, CHANGE);
+    attachInterrupt(DEC_MANUAL_DOWN_PIN, Manual_Down_Change_Interrupt, CHANGE);
+    MANUAL_ROLL_ON;
+    iwdg_feed();
+  }
+}
+
+/*
+ @brief     : 按路数设置开度，超时时间到后不需要服务器再发指令，自动回到设置前的开度
+ @param     : 无
+ @return    : 无
+ */
+void Command_Analysis::Ratio_Opening_Command(void)
+{
+  //  帧头     |    帧ID   |  数据长度   |    设备类型ID   | 群发标志位  |所在执行区域号 |  工作组号   | 设备路数 |  开度     | 超时时间（S） |  预留   | 校验码 |  帧尾 
+  //Frame head | Frame ID | Data Length | Device type ID |  mass flag |  Area number |   workgroup | channel |  OpenRatio |  WorkSec    | Allocate | CRC8 | Frame end
+  //  1 byte       2 byte      1 byte          2 byte        1 byte         1 byte         1 byte      1 byte     2 byte       3 byte        8 byte    1 byte  6 byte
+
+  if (!Match_Channel(CmdFrame[9]))
+  {
+    Serial.println("Not this channel... <Ratio_Opening_Command>");
+    return;
+  }
+
+  unsigned int OpenRatio = (CmdFrame[10] << 8) | CmdFrame[11];
+  unsigned long WorkSec = ((unsigned long)CmdFrame[12] << 16) | (CmdFrame[13] << 8) | CmdFrame[14];
+
+  if (OpenRatio > RATIO_OPENING_MAX)
+  {
+    Serial.println("Open ratio ERROR !!! <Ratio_Opening_Command>");
+    Message_Receipt.General_Receipt(OpenRollerErr, 1);
+    return;
+  }
+
+  Serial.print("Open ratio: "); Serial.print(OpenRatio);
+  Serial.print(", work sec: "); Serial.print(WorkSec);
+  Serial.println(" <Ratio_Opening_Command>");
+
+  /*超时时间为0表示一直保持；设置的就是全关时不需要再超时关闭*/
+  Execute_Opening(OpenRatio, 0, (OpenRatio > 0) ? WorkSec : 0);
+}
+
+/*
+ @brief     : 开始A020超时关闭计时，按millis()倒计时，卷膜和自检时暂停的定时器不影响计时
+ @param     : 超时时间（S）
+ @return    : 无
+ */
+void Command_Analysis::Start_Auto_Off(unsigned long sec)
+{
+  AutoOffTickTime = millis();
+  AutoOffRemain = sec;
+}
+
+/*
+ @brief     : A020超时时间到，关闭（开度0），不需要服务器再下发指令。在主循环里调用，
+            每次按经过的整秒数倒计时，卷膜等原因没有及时调用时下一次补上
+ @param     : 无
+ @return    : 无
+ */
+void Command_Analysis::Auto_Off_Check(void)
+{
+  if (AutoOffRemain == 0) return;
+
+  while (AutoOffRemain > 0 && millis() - AutoOffTickTime >= 1000)
+  {
+    AutoOffTickTime += 1000;
+    AutoOffRemain--;
+  }
+  if (AutoOffRemain > 0) return;
+
+  Serial.println("Work sec timeout, close... <Auto_Off_Check>");
+  LoRa_Cmd_Cache.Clear_Motion();
+  Execute_Opening(0);
 }
 
 /*
@@ -502,154 +1055,254 @@ void Command_Analysis::Opening_Command(void)
   //Frame head | Frame ID | Data Length | Device type ID |  mass flag  |  Area number |   workgroup | channel |  oepning | CRC8 |  |  Frame end
   //  1 byte       2 byte      1 byte          2 byte        1 byte         1 byte         1 byte      1 byte    1 byte    1 byte      6 byte
 
-  if (gAccessNetworkFlag == false)  return;  //如果本设备还没有注册到服务器，不理会该命令
+  Execute_Opening(CmdFrame[10]);
+}
 
-  if (Verify_Frame_Validity(4, 7, true, true) == true)  //如果校验通过（CRC校验、区域号校验、组号校验）
+/*
+ @brief     : 按开度值卷膜，开度指令和多指令开度帧共用
+ @param     : 1.开度值（0 - 100），F0强制关棚，F1强制开棚
+              2.工作时长上限（S，0不限），只在本次调用开始卷膜时生效；合并到正在进行的卷膜时不改变原来的上限
+              3.A020超时关闭时间（S，0一直保持）。接受这个开度时（开始卷膜或合并到正在进行的卷膜）从这里开始计时，
+                并覆盖还没有到时的超时关闭；被拒绝时原来的计时不变，设置了超时关闭时回执错误
+ @return    : true or false（卷膜完成且状态为ROLL_OK；被拒绝、卷膜异常或被强制停止时为false）
+ */
+bool Command_Analysis::Execute_Opening(unsigned char opening, unsigned int time_limit, unsigned long auto_off_sec)
+{
+  /*如果电机手动卷膜按键电路异常，禁止自动卷膜*/
+  if (gManualKeyExceptionFlag)
   {
-    /*如果电机手动卷膜按键电路异常，禁止自动卷膜*/
-    if (gManualKeyExceptionFlag)
+    Set_Motor_Status(MANUAL_KEY_EXCEPTION);
+    Message_Receipt.Working_Parameter_Receipt(false, 2); 
+    Serial.println("Manual roll key exception !!! <Execute_Opening>");
+    if (auto_off_sec > 0) Message_Receipt.General_Receipt(OpenRollerErr, 1);
+    return false;
+  }
+  /*如果当前正在手动卷膜。拒绝执行自动卷膜*/
+  else if (gManualUpDetectFlag || gManualDownDetectFlag)
+  {
+    if (digitalRead(DEC_MANUAL_UP_PIN) == LOW)  gManualUpDetectFlag = false;
+    if (digitalRead(DEC_MANUAL_DOWN_PIN) == LOW) gManualDownDetectFlag = false;
+    if (gManualUpDetectFlag || gManualDownDetectFlag)
     {
-      Set_Motor_Status(MANUAL_KEY_EXCEPTION);
-      Message_Receipt.Working_Parameter_Receipt(false, 2); 
-      Serial.println("Manual roll key exception !!! <Opening_Command>");
-      return;
+      Serial.println("Detect manual rolling... <Execute_Opening>");
+      /*
+        *待处理事情
+      */
+      if (auto_off_sec > 0) Message_Receipt.General_Receipt(OpenRollerErr, 1);
+      return false;
     }
-    /*如果当前正在手动卷膜。拒绝执行自动卷膜*/
-    else if (gManualUpDetectFlag || gManualDownDetectFlag)
+  }
+  /*如果当前正在卷膜，不进行二次卷膜*/
+  else if (gOpeningWorkingFlag == true || gResetRollWorkingFlag == true || gForceRollWorkingFlag == true)
+  {
+    /*正在开度卷膜时收到普通开度，交给 Motor_Coiling 合并到本次卷膜，卷膜完成后只回执一次ROLL_OK*/
+    if (gRetargetEnableFlag && opening <= 100)
     {
-      if (digitalRead(DEC_MANUAL_UP_PIN) == LOW)  gManualUpDetectFlag = false;
-      if (digitalRead(DEC_MANUAL_DOWN_PIN) == LOW) gManualDownDetectFlag = false;
-      if (gManualUpDetectFlag || gManualDownDetectFlag)
+      if (Roll_Operation.Save_Current_Opening_Value(opening))
       {
-        Serial.println("Detect manual rolling... <Opening_Command>");
-        /*
-          *待处理事情
-        */
-        return;
+        gRetargetOpening = opening;
+        Start_Auto_Off(auto_off_sec);
+        Message_Receipt.General_Receipt(OpenRollerOk, 1);
+        Serial.println("Retarget the running opening roll... <Execute_Opening>");
       }
+      else
+      {
+        Serial.println("Save current opening value ERROR !!! <Execute_Opening>");
+        if (auto_off_sec > 0) Message_Receipt.General_Receipt(OpenRollerErr, 1);
+      }
+      return false;
     }
-    /*如果当前正在卷膜，不进行二次卷膜*/
-    else if (gOpeningWorkingFlag == true || gResetRollWorkingFlag == true || gForceRollWorkingFlag == true)
-    {
-      Serial.println("Currently the motor is opening, and others opening cannot to do !!! <Opening_Command>");
-      return;
-    }
+    Serial.println("Currently the motor is opening, and others opening cannot to do !!! <Execute_Opening>");
+    if (auto_off_sec > 0) Message_Receipt.General_Receipt(OpenRollerErr, 1);
+    return false;
+  }
 
-    /*失能手动卷膜， 失能检测手动卷膜按键中断*/
-    detachInterrupt(DEC_MANUAL_DOWN_PIN);
-    detachInterrupt(DEC_MANUAL_UP_PIN);
-    MANUAL_ROLL_OFF;
+  /*失能手动卷膜， 失能检测手动卷膜按键中断*/
+  detachInterrupt(DEC_MANUAL_DOWN_PIN);
+  detachInterrupt(DEC_MANUAL_UP_PIN);
+  MANUAL_ROLL_OFF;
 
-    Message_Receipt.General_Receipt(OpenRollerOk, 1); //通用回执，告诉服务器接收到了开度卷膜命令
+  /*本次开始卷膜，工作时长从这里算起，重置行程、强制开关棚和开度卷膜都检查*/
+  Motor_Operation.Set_Work_Time_Limit(time_limit);
+  /*新的开度覆盖还没有到时的A020超时关闭*/
+  Start_Auto_Off(auto_off_sec);
 
-    volatile unsigned char opening_value = gReceiveCmd[10]; //获取从服务器接收的开度值
+  Message_Receipt.General_Receipt(OpenRollerOk, 1); //通用回执，告诉服务器接收到了开度卷膜命令
 
-    /* 
-      *如果是开度卷膜，且要求全关或全开。本次当前开度正好已经是全关或全开了
-      *那么就不需要再次进入到卷膜函数里。
-      *应用在于：假如冬天不能开棚，本来也确实关着。服务器发送一个关棚开度，
-      *程序会先判断有没有重置行程，假如有些因素导致还要重置行程，那么就会打开棚了。
-      *当然，不适用于强制卷膜
-      *还有，假如发来的开度是0或100，说明需要开棚和关棚，一般用于天冷了或天热了，这个时候就
-      *不去判断是否发来的和保存的是否一至了，而是发来的只要是关棚或开棚，同时需要重置行程，
-      *就会用强制开棚和强制关棚来操作，最大限度不去重置行程。
-      *而其他的开度值，就会去判断上一次的开度和本次的是否相等，如果相等，就不动作
-      *如果不相等，同时又需要重置行程，那么只能必须先重置行程才能开到某个开度了。
-     */
-    if (opening_value >= 0 && opening_value <= 100)
-    {
-      unsigned char RealTimeOpenTemp =  Roll_Operation.Read_RealTime_Opening_Value();
+  volatile unsigned char opening_value = opening; //获取从服务器接收的开度值
 
-      if (!Roll_Operation.Read_Route_Save_Flag())
-      {
-        if (opening_value == 0 || opening_value == 100)
-        {
-          if (opening_value == 0)
-            opening_value = 0xF0;
-          else
-            opening_value = 0xF1;
-
-          Serial.println("Prepare Force Open or Close. Be careful... <Opening_Command>");
-          Motor_Operation.Force_Open_or_Close(opening_value);
-          memset(gReceiveCmd, 0x00, gReceiveLength);
-          /*自动卷膜完成后，使能手动卷膜，打开检测手动卷膜按键中断*/
-          attachInterrupt(DEC_MANUAL_UP_PIN, Manual_Up_Change_Interrupt, CHANGE);
-          attachInterrupt(DEC_MANUAL_DOWN_PIN, Manual_Down_Change_Interrupt, CHANGE);
-          MANUAL_ROLL_ON;
-          return;
-        }
-      }
+  /* 
+    *如果是开度卷膜，且要求全关或全开。本次当前开度正好已经是全关或全开了
+    *那么就不需要再次进入到卷膜函数里。
+    *应用在于：假如冬天不能开棚，本来也确实关着。服务器发送一个关棚开度，
+    *程序会先判断有没有重置行程，假如有些因素导致还要重置行程，那么就会打开棚了。
+    *当然，不适用于强制卷膜
+    *还有，假如发来的开度是0或100，说明需要开棚和关棚，一般用于天冷了或天热了，这个时候就
+    *不去判断是否发来的和保存的是否一至了，而是发来的只要是关棚或开棚，同时需要重置行程，
+    *就会用强制开棚和强制关棚来操作，最大限度不去重置行程。
+    *而其他的开度值，就会去判断上一次的开度和本次的是否相等，如果相等，就不动作
+    *如果不相等，同时又需要重置行程，那么只能必须先重置行程才能开到某个开度了。
+   */
+  if (opening_value >= 0 && opening_value <= 100)
+  {
+    unsigned char RealTimeOpenTemp =  Roll_Operation.Read_RealTime_Opening_Value();
 
-      if (RealTimeOpenTemp == opening_value)
+    if (!Roll_Operation.Read_Route_Save_Flag())
+    {
+      if (opening_value == 0 || opening_value == 100)
       {
-        Serial.println("Film has been rolled to the current opening, do not repeat the film... <Opening_Command>");
-        Set_Motor_Status(ROLL_OK);
-        Message_Receipt.Working_Parameter_Receipt(true, 2);
+        if (opening_value == 0)
+          opening_value = 0xF0;
+        else
+          opening_value = 0xF1;
 
+        Serial.println("Prepare Force Open or Close. Be careful... <Execute_Opening>");
+        Motor_Operation.Force_Open_or_Close(opening_value);
+        /*自动卷膜完成后，使能手动卷膜，打开检测手动卷膜按键中断*/
         attachInterrupt(DEC_MANUAL_UP_PIN, Manual_Up_Change_Interrupt, CHANGE);
         attachInterrupt(DEC_MANUAL_DOWN_PIN, Manual_Down_Change_Interrupt, CHANGE);
         MANUAL_ROLL_ON;
-        return;
+        Motor_Operation.Set_Work_Time_Limit(0);
+        return (Read_Motor_Status() == ROLL_OK);
       }
     }
 
-    //正常开度值范围是0到100，如果是F0，表明是强制关棚，如果是F1，表明是强制开棚
-    if (opening_value == 0xF0 || opening_value == 0xF1)
+    if (RealTimeOpenTemp == opening_value)
     {
-      Serial.println("Prepare Force Open or Close. Be careful... <Opening_Command>");
-      Motor_Operation.Force_Open_or_Close(opening_value);
-      memset(gReceiveCmd, 0x00, gReceiveLength);
-      /*自动卷膜完成后，使能手动卷膜，打开检测手动卷膜按键中断*/
+      Serial.println("Film has been rolled to the current opening, do not repeat the film... <Execute_Opening>");
+      Set_Motor_Status(ROLL_OK);
+      Message_Receipt.Working_Parameter_Receipt(true, 2);
+
       attachInterrupt(DEC_MANUAL_UP_PIN, Manual_Up_Change_Interrupt, CHANGE);
       attachInterrupt(DEC_MANUAL_DOWN_PIN, Manual_Down_Change_Interrupt, CHANGE);
       MANUAL_ROLL_ON;
-      return;
+      Motor_Operation.Set_Work_Time_Limit(0);
+      return true;
     }
+  }
 
-    if (Roll_Operation.Read_Route_Save_Flag())  //如果已经重置行程过
+  //正常开度值范围是0到100，如果是F0，表明是强制关棚，如果是F1，表明是强制开棚
+  if (opening_value == 0xF0 || opening_value == 0xF1)
+  {
+    Serial.println("Prepare Force Open or Close. Be careful... <Execute_Opening>");
+    Motor_Operation.Force_Open_or_Close(opening_value);
+    /*自动卷膜完成后，使能手动卷膜，打开检测手动卷膜按键中断*/
+    attachInterrupt(DEC_MANUAL_UP_PIN, Manual_Up_Change_Interrupt, CHANGE);
+    attachInterrupt(DEC_MANUAL_DOWN_PIN, Manual_Down_Change_Interrupt, CHANGE);
+    MANUAL_ROLL_ON;
+    Motor_Operation.Set_Work_Time_Limit(0);
+    return (Read_Motor_Status() == ROLL_OK);
+  }
+
+  if (Roll_Operation.Read_Route_Save_Flag())  //如果已经重置行程过
+  {
+    if(Roll_Operation.Save_Current_Opening_Value(opening_value))  //保存当前开度值
+    {
+      Serial.println("Begin to coiling... <Execute_Opening>");
+      Motor_Operation.Motor_Coiling();  //开始卷膜
+      iwdg_feed();
+    }
+    else  //保存开度值异常
+    {
+      Serial.println("Save current opening value ERROR !!! <Execute_Opening>");
+      Set_Motor_Status(STORE_EXCEPTION);
+      Message_Receipt.Working_Parameter_Receipt(false, 2);
+    }
+  }
+  else  //或者没有重置行程
+  {
+    Serial.println("The film has not measured the distance, first measure, then roll the film... <Execute_Opening>");
+    /*重置行程中被强制停止或超过工作时长也返回true，状态不是RESET_ROLLOK时不再接着卷膜*/
+    if(Motor_Operation.Reset_Motor_Route() == true && Read_Motor_Status() == RESET_ROLLOK) //先重置行程，再开度卷膜
     {
+      Serial.println("Roll OK, motor begin coiling... <Execute_Opening>");
+
       if(Roll_Operation.Save_Current_Opening_Value(opening_value))  //保存当前开度值
       {
-        Serial.println("Begin to coiling... <Opening_Command>");
+        gAdjustOpeningFlag = false;
         Motor_Operation.Motor_Coiling();  //开始卷膜
-        iwdg_feed();
       }
-      else  //保存开度值异常
+      else  //保存开度值操作异常
       {
-        Serial.println("Save current opening value ERROR !!! <Opening_Command>");
+        Serial.println("Save current opening value ERROR !!! <Execute_Opening>");
         Set_Motor_Status(STORE_EXCEPTION);
         Message_Receipt.Working_Parameter_Receipt(false, 2);
       }
     }
-    else  //或者没有重置行程
-    {
-      Serial.println("The film has not measured the distance, first measure, then roll the film... <Opening_Command>");
-      if(Motor_Operation.Reset_Motor_Route() == true) //先重置行程，再开度卷膜
-      {
-        Serial.println("Roll OK, motor begin coiling... <Opening_Command>");
-
-        if(Roll_Operation.Save_Current_Opening_Value(opening_value))  //保存当前开度值
-        {
-          gAdjustOpeningFlag = false;
-          Motor_Operation.Motor_Coiling();  //开始卷膜
-        }
-        else  //保存开度值操作异常
-        {
-          Serial.println("Save current opening value ERROR !!! <Opening_Command>");
-          Set_Motor_Status(STORE_EXCEPTION);
-          Message_Receipt.Working_Parameter_Receipt(false, 2);
-        }
-      }
-      else  //重置行程失败
-        Serial.println("Reset motor route failed !!! <Opening_Command>");
-      iwdg_feed();
-    }
-    /*自动卷膜完成后，使能手动卷膜，打开检测手动卷膜按键中断*/
-    attachInterrupt(DEC_MANUAL_UP_PIN, Manual_Up_Change_Interrupt, CHANGE);
-    attachInterrupt(DEC_MANUAL_DOWN_PIN, Manual_Down_Change_Interrupt, CHANGE);
-    MANUAL_ROLL_ON;
+    else  //重置行程失败
+      Serial.println("Reset motor route failed !!! <Execute_Opening>");
+    iwdg_feed();
   }
-  memset(gReceiveCmd, 0x00, gReceiveLength);
+  /*自动卷膜完成后，使能手动卷膜，打开检测手动卷膜按键中断*/
+  attachInterrupt(DEC_MANUAL_UP_PIN, Manual_Up_Change_Interrupt, CHANGE);
+  attachInterrupt(DEC_MANUAL_DOWN_PIN, Manual_Down_Change_Interrupt, CHANGE);
+  MANUAL_ROLL_ON;
+  Motor_Operation.Set_Work_Time_Limit(0);
+  return (Read_Motor_Status() == ROLL_OK);
+}
+
+/*
+ @brief     : 多指令开度帧，一帧里按工作组号或设备路数给区域内多台设备分别设置开度（网关 ---> 本机）
+              一次遍历所有记录，执行第一条适用于本机的记录，回执与单条开度指令相同
+ @param     : 无
+ @return    : 无
+ */
+void Command_Analysis::Multi_Opening_Command(void)
+{
+  //  帧头     |    帧ID   |  数据长度   |    设备类型ID   | 群发标志位  |所在执行区域号 | 记录条数    | 记录1 ... 记录N | 校验码 | 帧尾 
+  //Frame head | Frame ID | Data Length | Device type ID |  mass flag |  Area number | record num |  records       |  CRC8 | Frame end
+  //  1 byte       2 byte      1 byte          2 byte        1 byte         1 byte        1 byte     5 byte * N       1 byte  6 byte
+  //
+  //  每条记录：目标类型（0x01工作组号，0x02设备路数） | 工作组号或路数（0x55所有） | 开度    | 工作时长上限（S，0不限）
+  //             1 byte                                   1 byte                     1 byte    2 byte
+
+  unsigned char RecordNum = CmdFrame[8];
+  const unsigned char *Record = &CmdFrame[9];
+
+  if (CmdFrame[3] != MULTI_OPENING_HEAD_LEN + RecordNum * MULTI_OPENING_RECORD_LEN)
+  {
+    Serial.println("Multi opening record number ERROR !!! <Multi_Opening_Command>");
+    return;
+  }
+
+  for (unsigned char i = 0; i < RecordNum; i++, Record += MULTI_OPENING_RECORD_LEN)
+  {
+    if (!Match_Opening_Record(Record)) continue;
+
+    unsigned int WorkTimeLimit = (Record[3] << 8) | Record[4];
+    Serial.print("Multi opening record <Multi_Opening_Command>: "); Serial.print(i);
+    Serial.print(", opening: "); Serial.print(Record[2]);
+    Serial.print(", time limit: "); Serial.println(WorkTimeLimit);
+
+    Execute_Opening(Record[2], WorkTimeLimit);
+    return;
+  }
+  Serial.println("No record for this device... <Multi_Opening_Command>");
+}
+
+/*
+ @brief     : 判断多指令开度帧里的一条记录是否适用于本机
+ @param     : 记录起始地址
+ @return    : true or false
+ */
+bool Command_Analysis::Match_Opening_Record(const unsigned char *record)
+{
+  switch (record[0])
+  {
+    case RECORD_TARGET_GROUP    : return Match_Work_Group(record[1]);
+    case RECORD_TARGET_CHANNEL  : return Match_Channel(record[1]);
+    default                     : return false;
+  }
+}
+
+/*
+ @brief     : 判断指令里的设备路数是否包含本机
+ @param     : 设备路数（0x55所有）
+ @return    : true or false
+ */
+bool Command_Analysis::Match_Channel(unsigned char channel)
+{
+  return (channel == 0x55 || channel == 0x01); //卷膜机默认只有一路
 }
 
 /*
@@ -662,20 +1315,145 @@ void Command_Analysis::Working_Limit_Command(void)
   //  帧头     |    帧ID   |  数据长度   |    设备类型ID   | 群发标志位  | 所在执行区域号 |  工作组号   | 设备路数 | 低电压阈值       |   高电压阈值      | 状态上报间隔     |校验码 | 帧尾 
   //Frame head | Frame ID | Data Length | Device type ID |  mass flag |   Area number |   workgroup | channel | LowVolThreshold | HighVolThreshold |  ReprotInterval | CRC8 |  Frame end
   //  1 byte       2 byte      1 byte          2 byte        1 byte         1 byte         1 byte      1 byte     2 byte             2 byte              1 byte        1 byte  6 byte
-  
-  if (gAccessNetworkFlag == false)  return;  //如果本设备还没有注册到服务器，不理会该命令
+  //数据长度为12时，状态上报间隔后面多1字节卷膜过程中的实时电流上报间隔（S）
 
-  if (Verify_Frame_Validity(4, 11, true, true) == true)
+  bool SaveOkFlag;
+
+  if (CmdFrame[3] != WORKING_LIMIT_DATA_LEN && CmdFrame[3] != WORKING_LIMIT_EXT_DATA_LEN)
+  {
+    Message_Receipt.General_Receipt(LimitRollerErr, 1);
+    return;
+  }
+
+  SaveOkFlag = Roll_Operation.Save_Roll_Work_Voltage_and_Report_Interval(&CmdFrame[10]);
+  if (SaveOkFlag && CmdFrame[3] == WORKING_LIMIT_EXT_DATA_LEN)
+    SaveOkFlag = Roll_Operation.Save_Current_Report_Interval(CmdFrame[15]);
+
+  if(SaveOkFlag == true)
+    Message_Receipt.General_Receipt(LimitRollerOk, 1);
+  else
+  {
+    Serial.println("Save working threshold ERROR !");
+    Message_Receipt.General_Receipt(LimitRollerErr, 1);
+    Set_Motor_Status(STORE_EXCEPTION);
+    Message_Receipt.Working_Parameter_Receipt(false, 2);
+  }
+}
+
+/*
+ @brief     : 批量读写参数寄存器（网关 ---> 本机）。一帧指令读或写一组寄存器，所有结果在一帧E024回执里返回。
+              写指令中有本机没有的寄存器时无法知道后面数据的位置，整帧不执行
+ @param     : 无
+ @return    : 无
+ */
+void Command_Analysis::Register_Map_Command(void)
+{
+  //  帧头     |    帧ID   |  数据长度   |    设备类型ID   | 群发标志位  | 所在执行区域号 | 设备路数 | 操作       | 寄存器个数 | 寄存器列表 | 校验码 | 帧尾 
+  //Frame head | Frame ID | Data Length | Device type ID |  mass flag |   Area number | channel | operation | reg num   | reg list  | CRC8 |  Frame end
+  //  1 byte       2 byte      1 byte          2 byte        1 byte         1 byte        1 byte    1 byte      1 byte       N byte    1 byte  6 byte
+  //  操作：0x01读，列表每项为寄存器号；0x02写，列表每项为寄存器号 + 寄存器数据
+
+  unsigned char Operation = CmdFrame[9];
+  unsigned char RegNum = CmdFrame[10];
+  unsigned char *Data = &CmdFrame[4];
+  unsigned int Pos = REGISTER_HEAD_LEN;
+  unsigned char Reply[REGISTER_REPLY_MAX_LEN];
+  unsigned char ReplyLen = 0, ReplyNum = 0;
+
+  if (!Match_Channel(CmdFrame[8]))
+  {
+    Serial.println("Not this channel... <Register_Map_Command>");
+    return;
+  }
+
+  /*先检查列表长度与数据长度是否一致*/
+  bool FrameOkFlag = (Operation == REGISTER_OP_READ || Operation == REGISTER_OP_WRITE);
+  for (unsigned char i = 0; FrameOkFlag && i < RegNum; i++)
+  {
+    if (Pos >= CmdFrame[3])
+    {
+      FrameOkFlag = false;
+      break;
+    }
+
+    if (Operation == REGISTER_OP_WRITE)
+    {
+      unsigned char Len = Param_Register.Register_Length(Data[Pos]);
+      if (Len == 0) FrameOkFlag = false;
+      Pos += Len;
+    }
+    Pos++;
+  }
+
+  if (!FrameOkFlag || Pos != CmdFrame[3])
   {
-    if(Roll_Operation.Save_Roll_Work_Voltage_and_Report_Interval(&gReceiveCmd[10]) == true)
-      Message_Receipt.General_Receipt(LimitRollerOk, 1);
+    Serial.println("Register list ERROR !!! <Register_Map_Command>");
+    Message_Receipt.General_Receipt(RegisterMapErr, 1);
+    return;
+  }
+
+  Pos = REGISTER_HEAD_LEN;
+  for (unsigned char i = 0; i < RegNum && ReplyLen + 2 <= REGISTER_REPLY_MAX_LEN; i++)
+  {
+    unsigned char Reg = Data[Pos++];
+    unsigned char Len = Param_Register.Register_Length(Reg);
+
+    Reply[ReplyLen++] = Reg;
+    if (Operation == REGISTER_OP_WRITE)
+    {
+      Reply[ReplyLen++] = Param_Register.Write_Register(Reg, &Data[Pos]);
+      Pos += Len;
+    }
+    else if (ReplyLen + 1 + Len > REGISTER_REPLY_MAX_LEN)
+    {
+      Reply[ReplyLen++] = REG_NO_ROOM;
+    }
     else
     {
-      Serial.println("Save working threshold ERROR !");
-      Message_Receipt.General_Receipt(LimitRollerErr, 1);
-      Set_Motor_Status(STORE_EXCEPTION);
-      Message_Receipt.Working_Parameter_Receipt(false, 2);
+      Register_Status Status = Param_Register.Read_Register(Reg, &Reply[ReplyLen + 1]);
+      Reply[ReplyLen++] = Status;
+      if (Status == REG_OK) ReplyLen += Len;
     }
+    ReplyNum++;
   }
-  memset(gReceiveCmd, 0x00, gReceiveLength);
+
+  Message_Receipt.Register_Receipt(Operation, ReplyNum, Reply, ReplyLen);
+
+  /*通信模式被修改，回执发送完后重新配置LoRa模块*/
+  if (Param_Register.LoRa_Reinit_Pending())
+  {
+    Param_Register.Clear_LoRa_Reinit();
+    LoRa_MHL9LF.Parameter_Init(true);
+  }
+}
+
+/*
+ @brief     : 服务器确认收到本机的回执（服务器 ---> 本设备）。只在上行确认模式下使用，本指令不回执。
+              上行序号只有1字节，同一区域里各设备的序号会重复，SN码与本机相同时才确认
+ @param     : 无
+ @return    : 无
+ */
+void Command_Analysis::Uplink_Ack_Command(void)
+{
+  //  帧头     |    帧ID   |  数据长度   |    设备类型ID   | 群发标志位  | 所在执行区域号 |  SN码   | 上行序号 | 校验码 | 帧尾 
+  //Frame head | Frame ID | Data Length | Device type ID |  mass flag |   Area number | SN code |   seq   |  CRC8 |  Frame end
+  //  1 byte       2 byte      1 byte          2 byte        1 byte         1 byte       9 byte    1 byte    1 byte   6 byte
+
+  unsigned char SN_Code[UPLINK_ACK_SN_LEN];
+
+  /*确认只发给单个设备，群发的确认会误确认其他设备的同一序号*/
+  if (gMassCommandFlag)
+  {
+    Serial.println("Mass ack rejected !!! <Uplink_Ack_Command>");
+    return;
+  }
+
+  if (!SN.Read_SN_Code(SN_Code) || memcmp(SN_Code, &CmdFrame[8], UPLINK_ACK_SN_LEN) != 0)
+  {
+    Serial.println("Not this device's ack... <Uplink_Ack_Command>");
+    return;
+  }
+
+  if (!LoRa_Tx_Queue.Ack(CmdFrame[8 + UPLINK_ACK_SN_LEN]))
+    Serial.println("No frame waiting for this ack... <Uplink_Ack_Command>");
 }
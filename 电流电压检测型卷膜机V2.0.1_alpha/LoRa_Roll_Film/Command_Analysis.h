@@ -3,40 +3,192 @@
 
 #include <Arduino.h>
 
-enum Frame_ID{
-  Work_Para, Set_Group_Num, SN_Area_Channel, Work_Status, ResetRoll, Opening, Work_Limit, Stop_Work
+/*指令优先级，数值越大越优先处理*/
+enum Cmd_Priority{
+  CMD_PRIORITY_QUERY = 0,   //状态查询（A011、A014）
+  CMD_PRIORITY_CONFIG,      //参数设置（A012、A013、A022、A024）
+  CMD_PRIORITY_MOTION,      //卷膜动作（A020、A021）
+  CMD_PRIORITY_URGENT       //强制停止（A015），卷膜过程中也马上处理
 };
 
+#define FRAME_MAX_LEN     128  //最大接收指令长度
+#define FRAME_END_LEN     6    //帧尾长度：0D 0A 0D 0A 0D 0A
+#define FRAME_FIXED_LEN   11   //除数据外的固定长度：帧头1 + 帧ID2 + 数据长度1 + CRC8 1 + 帧尾6
+#define FRAME_HEADER_LEN  9    //判断是否是本机指令需要的字节数：到工作组号为止
+#define FRAME_WAIT_TIMEOUT  200  //等待一帧剩余数据的超时时间（ms）
+
+#define FRAME_VAR_LEN       0xFF //指令帧描述表中表示数据长度不固定
+
+/*多指令开度帧A023*/
+#define MULTI_OPENING_HEAD_LEN    5     //数据中记录之前的部分：设备类型2 + 群发标志1 + 区域号1 + 记录条数1
+#define MULTI_OPENING_RECORD_LEN  5     //每条记录：目标类型1 + 工作组号或路数1 + 开度1 + 工作时长上限2
+#define RECORD_TARGET_GROUP       0x01  //记录按工作组号选择设备
+#define RECORD_TARGET_CHANNEL     0x02  //记录按设备路数选择设备
+
+/*设置工作组A012*/
+#define GROUP_LIST_DATA_LEN       10    //按5个工作组号设置的数据长度
+#define GROUP_BITMAP_HEAD_LEN     6     //按工作组列表设置时，列表之前的部分：设备类型2 + 群发标志1 + 区域号1 + 操作1 + 组数1
+#define GROUP_OP_SET              0x01  //加入列表中的工作组
+#define GROUP_OP_CLEAR            0x02  //退出列表中的工作组
+#define GROUP_OP_REPLACE          0x03  //只属于列表中的工作组
+
+/*设置开关状态A020*/
+#define RESET_ROLL_DATA_LEN       6     //原来的重置行程指令的数据长度
+#define RATIO_OPENING_DATA_LEN    19    //按路数设置开度的数据长度：设备类型2 + 群发标志1 + 区域号1 + 工作组号1 + 路数1 + 开度2 + 超时时间3 + 预留8
+#define RATIO_OPENING_MAX         100   //开度0x0064为全开
+
+/*电压阈值、上报间隔A022*/
+#define WORKING_LIMIT_DATA_LEN    11    //原来的设置电压阈值、状态上报间隔的数据长度
+#define WORKING_LIMIT_EXT_DATA_LEN 12   //在后面加1字节卷膜过程中E016实时电流上报间隔（S，0不上报）
+
+/*设置RTC时间A018*/
+#define RTC_TIME_LEN              6     //年-2000、月、日、时、分、秒
+
+/*定时卷膜A019*/
+#define SCHEDULE_DIGITAL_DATA_LEN 22    //设定参数为1字节（数字输出）时的数据长度
+#define SCHEDULE_ANALOG_DATA_LEN  24    //设定参数为3字节（模拟输出）时的数据长度
+#define SCHEDULE_TIME_LEN         6     //开始、结束时间：年-2000、月、日、时、分、秒
+
+/*参数寄存器读写A024*/
+#define REGISTER_HEAD_LEN         7     //寄存器列表之前的部分：设备类型2 + 群发标志1 + 区域号1 + 路数1 + 操作1 + 寄存器个数1
+#define REGISTER_OP_READ          0x01  //读列表中的寄存器，列表每项为寄存器号
+#define REGISTER_OP_WRITE         0x02  //写列表中的寄存器，列表每项为寄存器号 + 数据
+#define REGISTER_REPLY_MAX_LEN    (FRAME_MAX_LEN - FRAME_FIXED_LEN - REGISTER_HEAD_LEN) //一帧回执里寄存器结果的最大长度
+
+/*上行确认A025*/
+#define UPLINK_ACK_SN_LEN         9     //确认指令里的SN码长度，序号只有1字节，各设备会重复，按SN码区分设备
+
+#define FAST_STOP_FRAME_LEN (6 + FRAME_FIXED_LEN) //强制停止指令A015的帧长度
+
 class Command_Analysis{
 public:
   void Receive_LoRa_Cmd(void);
+  void Print_Rx_Statistics(void);
+  void Auto_Off_Check(void);
+  void Schedule_Check(void);
+  unsigned long Oversize_Frame_Num(void) {return OversizeFrameNum;}
+  unsigned long Early_Reject_Num(void) {return EarlyRejectNum;}
+
+  void Fast_Stop_Detect(unsigned char c, unsigned long tick_time);
+  unsigned long Fast_Stop_Num(void) {return FastStopNum;}
+  unsigned long Fast_Stop_Max_Latency(void) {return FastStopMaxLatency;}
+  void Clear_Fast_Stop_Statistics(void);
 
 private:
-  Frame_ID FrameID_Analysis(void);
-  bool Verify_CRC8(unsigned char verify_data_base_addr, unsigned char verify_data_len);
-  bool Verify_Device_Type_ID(void);
+  bool Frame_Sync(void);
+  bool Frame_Wait(unsigned int available);
+  void Frame_Resync(void);
+  bool Queue_Frame(unsigned char *frame, unsigned char len);
+
+  unsigned char FrameBuffer[FRAME_MAX_LEN]; //同步出的一帧指令
+  unsigned char FrameLength;                //同步出的指令长度
+  unsigned int WaitAvailable;               //等待一帧收完时，缓存里的字节数
+  unsigned long WaitStartTime;              //开始等待一帧收完的时间
+  unsigned long OversizeFrameNum;           //长度字段超过最大长度被丢弃的帧数
+  unsigned long FrameEndErrorNum;           //帧尾不对，重新同步的次数
+  unsigned long CrcErrorNum;                //CRC8不对，重新同步的次数
+  unsigned long SyncTimeoutNum;             //等待一帧收完超时，重新同步的次数
+  bool HeaderCheckedFlag;                   //当前帧头已经判断过是本机指令
+  unsigned int SkipRemainNum;               //不是本机指令的帧还要跳过的字节数
+  unsigned long EarlyRejectNum;             //收到帧头就丢弃的非本机指令数
+  bool HwHeadFlag;                          //已经去掉了本机或广播地址的硬件帧头，接着同步0xFE帧
+  unsigned long HwAddrRejectNum;            //硬件帧头地址不是本机或广播的帧数
+
+  unsigned char *CmdFrame;                  //正在处理的指令（指向指令队列的槽位）
+  unsigned char CmdLength;                  //正在处理的指令长度
+
+  unsigned long AutoOffRemain;              //A020超时关闭剩余秒数，0表示没有计时
+  unsigned long AutoOffTickTime;            //上一次倒计时1秒的时间（ms）
+
+  unsigned char FastStopFrame[FAST_STOP_FRAME_LEN]; //接收中断里识别强制停止指令的缓存
+  unsigned char FastStopIndex;
+  volatile unsigned long FastStopNum;               //接收中断里直接停止电机的次数
+  volatile unsigned long FastStopMaxLatency;        //最长的接收泵本次轮询开始到继电器断开时间（us）
+
+private:
+  /*指令帧描述：帧ID、数据长度、校验要求、优先级和处理函数*/
+  struct Frame_Descriptor{
+    unsigned int FrameID;
+    unsigned char DataLen;          //数据长度字段的固定值
+    bool AreaFlag;                  //是否校验区域号
+    bool GroupFlag;                 //是否校验工作组号
+    bool NetworkFlag;               //是否要求本机已注册到服务器
+    Cmd_Priority Priority;
+    bool MotionFlag;                //是否是卷膜动作指令
+    bool CacheFlag;                 //是否对服务器重发的同一条指令去重
+    void (Command_Analysis::*Handler)(void);
+  };
+
+  static constexpr bool Frame_Table_Sorted(unsigned char index);
+  const Frame_Descriptor *Find_Frame_Descriptor(unsigned int frame_id);
+
+private:
+  enum Frame_Filter_Result{
+    Frame_Accept = 0, Frame_Reject, Frame_Invalid
+  };
+
+  bool Verify_Device_Type_ID(const unsigned char *header);
   void Verify_Mass_Commands(void);
-  bool Verify_Area_Number(void);
-  bool Verify_Work_Group(void);
-  bool Verify_Frame_Validity(unsigned char verify_data_base_addr, unsigned char verify_data_len, bool area_flag, bool group_flag);
+  bool Verify_Area_Number(const unsigned char *header);
+  bool Verify_Work_Group(const unsigned char *header);
+  bool Match_Work_Group(unsigned char group);
+  bool Match_Opening_Record(const unsigned char *record);
+  bool Match_Channel(unsigned char channel);
+  Frame_Filter_Result Verify_Frame_Header(const unsigned char *header, const Frame_Descriptor *descriptor);
   
 private:
   void Receive_Data_Analysis(void);
   void Query_Current_Work_Param(void);
   void Set_Group_Number(void);
+  void Set_Group_Bitmap(void);
   void Set_SN_Area_Channel(void);
   void Detailed_Work_Status(void);
+  void Set_RTC_Command(void);
+  void Set_Schedule_Command(void);
+  void Switch_Status_Command(void);
   void ResetRoll_Command(void);
+  void Ratio_Opening_Command(void);
   void Opening_Command(void);
+  bool Execute_Opening(unsigned char opening, unsigned int time_limit = 0, unsigned long auto_off_sec = 0);
+  void Start_Auto_Off(unsigned long sec);
+  void Stop_Auto_Off(void) {AutoOffRemain = 0;}
+  void Multi_Opening_Command(void);
   void Working_Limit_Command(void);  
+  void Register_Map_Command(void);
+  void Uplink_Ack_Command(void);
   void Stop_Work_Command(void);
+
+private:
+  /*
+   * 指令帧描述表，必须按帧ID从小到大排列（编译时检查），按帧ID二分查找。
+   * 新增指令只需要在表里加一行，表项个数由表本身得出。
+   */
+  static constexpr Frame_Descriptor FrameTable[] = {
+    /* 帧ID  | 数据长度 | 校验区域 | 校验组号 | 需要注册 | 优先级              | 卷膜动作 | 重发去重 | 处理函数 */
+    /*通用指令*/
+    {0xA011,  23,   true,   false,  true,   CMD_PRIORITY_QUERY,   false,  true,   &Command_Analysis::Query_Current_Work_Param},
+    {0xA012,  FRAME_VAR_LEN,  true,  false,  true,  CMD_PRIORITY_CONFIG,  false,  true,  &Command_Analysis::Set_Group_Number},
+    {0xA013,  15,   false,  false,  false,  CMD_PRIORITY_CONFIG,  false,  true,   &Command_Analysis::Set_SN_Area_Channel},
+    {0xA014,  5,    true,   false,  true,   CMD_PRIORITY_QUERY,   false,  false,  &Command_Analysis::Detailed_Work_Status},
+    {0xA015,  6,    true,   true,   true,   CMD_PRIORITY_URGENT,  false,  false,  &Command_Analysis::Stop_Work_Command},
+    {0xA018,  10,   true,   false,  true,   CMD_PRIORITY_CONFIG,  false,  true,   &Command_Analysis::Set_RTC_Command},
+    {0xA019,  FRAME_VAR_LEN,  true,  false,  true,  CMD_PRIORITY_CONFIG,  false,  true,  &Command_Analysis::Set_Schedule_Command},
+    /*卷膜机私有指令*/
+    {0xA020,  FRAME_VAR_LEN,  true,  true,  true,  CMD_PRIORITY_MOTION,  true,  true,  &Command_Analysis::Switch_Status_Command},
+    {0xA021,  7,    true,   true,   true,   CMD_PRIORITY_MOTION,  true,   true,   &Command_Analysis::Opening_Command},
+    {0xA022,  FRAME_VAR_LEN,  true,  true,  true,  CMD_PRIORITY_CONFIG,  false,  true,   &Command_Analysis::Working_Limit_Command},
+    {0xA023,  FRAME_VAR_LEN,  true,  false,  true,  CMD_PRIORITY_MOTION,  true,  true,  &Command_Analysis::Multi_Opening_Command},
+    {0xA024,  FRAME_VAR_LEN,  true,  false,  false,  CMD_PRIORITY_CONFIG,  false,  false,  &Command_Analysis::Register_Map_Command},
+    {0xA025,  14,   true,   false,  false,  CMD_PRIORITY_QUERY,   false,  false,  &Command_Analysis::Uplink_Ack_Command},
+  };
+  static constexpr unsigned char FRAME_TABLE_NUM = sizeof(FrameTable) / sizeof(FrameTable[0]);
 };
 
 /*Create command analysis project*/
 extern Command_Analysis LoRa_Command_Analysis;
 
 extern bool gAccessNetworkFlag;  
-extern bool gStopWorkFlag;       
+extern volatile bool gStopWorkFlag;
 extern bool gMassCommandFlag;
 extern bool gIsHandleMsgFlag;
 
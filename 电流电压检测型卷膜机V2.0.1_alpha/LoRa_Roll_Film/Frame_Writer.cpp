@@ -0,0 +1,171 @@
+/************************************************************************************
+ *
+ * 回执帧写入器。以前每个回执函数在栈上组一帧，再单独算一遍CRC8，最后复制到发送队列；
+ * 帧头、群发标志、区域号、帧尾等代码在每个函数里重复一遍。现在直接写进发送队列的槽，
+ * 写的同时累加CRC8，各回执帧的布局在编译时检查数据长度。
+ * 头文件中提供了各个类的公共接口。
+ *
+*************************************************************************************/
+
+#include "Frame_Writer.h"
+#include "User_CRC8.h"
+#include "Tx_Queue.h"
+#include "receipt.h"
+#include "Memory.h"
+#include "Command_Analysis.h"
+
+/*
+ @brief   : 占用发送队列的一个槽，写入帧头
+ @param   : 1.帧ID
+            2.数据长度
+ @return  : 无
+ */
+Frame_Writer::Frame_Writer(unsigned int frame_id, unsigned char data_len)
+  : SlotIndex(-1), Buffer(NULL), Pos(0), DataLen(data_len), Crc(0), FinishFlag(false)
+{
+  if (FRAME_FIXED_LEN + data_len > FRAME_MAX_LEN) return;
+
+  SlotIndex = LoRa_Tx_Queue.Reserve();
+  if (SlotIndex < 0) return;
+
+  Buffer = LoRa_Tx_Queue.Slot_Data(SlotIndex);
+  Buffer[Pos++] = 0xFE; //帧头
+  Buffer[Pos++] = highByte(frame_id);
+  Buffer[Pos++] = lowByte(frame_id);
+  Buffer[Pos++] = data_len;
+}
+
+/*
+ @brief   : 没有发送的帧（中途返回、长度不对）释放占用的槽
+ @param   : 无
+ @return  : 无
+ */
+Frame_Writer::~Frame_Writer()
+{
+  LoRa_Tx_Queue.Cancel(SlotIndex);
+}
+
+/*
+ @brief   : 写入一个字节，同时累加CRC8。超过数据长度的部分不写
+ @param   : 字节
+ @return  : 无
+ */
+void Frame_Writer::Put_Byte(unsigned char c)
+{
+  if (Buffer == NULL || FinishFlag || Pos >= FRAME_HEAD_LEN + DataLen)
+  {
+    Pos++;  //仍然计数，Finish()时发现长度不对
+    return;
+  }
+
+  Buffer[Pos++] = c;
+  Crc = Crc8_Update(Crc, c);
+}
+
+/*
+ @brief   : 写入两个字节，高字节在前
+ @param   : 数据
+ @return  : 无
+ */
+void Frame_Writer::Put_Word(unsigned int w)
+{
+  Put_Byte(highByte(w));
+  Put_Byte(lowByte(w));
+}
+
+/*
+ @brief   : 写入一段数据
+ @param   : 1.数据
+            2.长度
+ @return  : 无
+ */
+void Frame_Writer::Put_Bytes(const unsigned char *data, unsigned char len)
+{
+  for (unsigned char i = 0; i < len; i++)
+    Put_Byte(data[i]);
+}
+
+/*
+ @brief   : 写入len个0，用于预留位
+ @param   : 长度
+ @return  : 无
+ */
+void Frame_Writer::Put_Zero(unsigned char len)
+{
+  for (unsigned char i = 0; i < len; i++)
+    Put_Byte(0x00);
+}
+
+/*
+ @brief   : 写入所有回执都有的设备类型ID、群发标志位和区域号
+ @param   : 无
+ @return  : 无
+ */
+void Frame_Writer::Put_Device_Head(void)
+{
+  Put_Word(DEVICE_TYPE_ID);
+  Put_Byte(gMassCommandFlag == true ? 0x55 : 0x00);
+  Put_Byte(Roll_Operation.Read_Area_Number());
+}
+
+/*
+ @brief   : 写入CRC8和帧尾
+ @param   : 无
+ @return  : true or false（没有占到槽，或写入的数据长度与帧头不一致）
+ */
+bool Frame_Writer::Finish(void)
+{
+  if (Buffer == NULL) return false;
+
+  if (Pos != FRAME_HEAD_LEN + DataLen)
+  {
+    Serial.print("Frame data length ERROR: "); Serial.print(Pos - FRAME_HEAD_LEN);
+    Serial.print(" != "); Serial.print(DataLen);
+    Serial.println(" <Finish>");
+    return false;
+  }
+
+  Buffer[Pos++] = Crc;
+  for (unsigned char i = 0; i < FRAME_END_LEN; i++)
+    Buffer[Pos++] = (i % 2 == 0) ? 0x0D : 0x0A;
+
+  FinishFlag = true;
+  return true;
+}
+
+/*
+ @brief   : 该帧需要服务器确认，在Send()之前调用
+ @param   : 1.上行序号
+            2.第一次等待确认的时间（ms）
+ @return  : 无
+ */
+void Frame_Writer::Expect_Ack(unsigned char seq, unsigned int timeout)
+{
+  LoRa_Tx_Queue.Expect_Ack(SlotIndex, seq, timeout);
+}
+
+/*
+ @brief   : 该帧的等待时间是群发回执时隙，合并发送时不移动，在Send()之前调用
+ @param   : 时隙周期（ms）
+ @return  : 无
+ */
+void Frame_Writer::Fix_Send_Time(unsigned long period)
+{
+  LoRa_Tx_Queue.Fix_Send_Time(SlotIndex, period);
+}
+
+/*
+ @brief   : 把组好的帧交给发送泵，马上返回。需要先Finish()
+ @param   : 1.随机等待时间（us），到时间后才发送
+            2.发送次数
+            3.回执种类，见Tx_Queue.h
+ @return  : 无
+ */
+void Frame_Writer::Send(unsigned long wait_us, unsigned char times, unsigned char kind)
+{
+  if (!FinishFlag) return;
+
+  LoRa_Tx_Queue.Commit(SlotIndex, Pos, wait_us / 1000, times, kind);
+  SlotIndex = -1;
+  Buffer = NULL;
+}
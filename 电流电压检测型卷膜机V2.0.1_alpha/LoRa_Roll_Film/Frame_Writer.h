@@ -0,0 +1,54 @@
+#ifndef _FRAME_WRITER_H
+#define _FRAME_WRITER_H
+
+#include <Arduino.h>
+
+#define FRAME_HEAD_LEN      4   //帧头1 + 帧ID2 + 数据长度1，不参与CRC8校验
+
+/*
+ * 回执帧写入器。直接在LoRa发送队列的槽里组帧，写数据时同时累加CRC8，
+ * Finish()补上校验码和帧尾，Send()交给发送泵。
+ * 写入的数据长度与帧头里的数据长度不一致时，Finish()失败，该帧不发送。
+ * 队列已满时写入器无效，所有写入操作直接忽略。
+ */
+class Frame_Writer{
+public:
+  Frame_Writer(unsigned int frame_id, unsigned char data_len);
+  ~Frame_Writer();
+
+  void Put_Byte(unsigned char c);
+  void Put_Word(unsigned int w);
+  void Put_Bytes(const unsigned char *data, unsigned char len);
+  void Put_Zero(unsigned char len);
+  void Put_Device_Head(void);
+
+  bool Finish(void);
+  void Expect_Ack(unsigned char seq, unsigned int timeout);
+  void Fix_Send_Time(unsigned long period);
+  void Send(unsigned long wait_us, unsigned char times, unsigned char kind);
+
+  const unsigned char *Frame(void) {return Buffer;}
+  unsigned char Length(void) {return Pos;}
+
+private:
+  signed char SlotIndex;      //发送队列的槽，-1表示没有占到槽
+  unsigned char *Buffer;
+  unsigned char Pos;          //已经写入的字节数
+  unsigned char DataLen;      //帧头里的数据长度
+  unsigned char Crc;          //已写入数据的CRC8
+  bool FinishFlag;
+};
+
+/*
+ * 按固定布局组帧。布局里给出帧ID、数据长度和各字段长度之和，
+ * 编译时检查两者是否一致，修改帧格式时漏改数据长度会编译失败。
+ * 上行确认模式下数据末尾另有序号，长度由构造参数给出。
+ */
+template <class Layout>
+class Layout_Frame_Writer : public Frame_Writer{
+  static_assert(Layout::FieldLen == Layout::DataLen, "frame fields do not add up to the Data Length byte");
+public:
+  explicit Layout_Frame_Writer(unsigned char trailer_len = 0) : Frame_Writer(Layout::FrameID, Layout::DataLen + trailer_len) {}
+};
+
+#endif
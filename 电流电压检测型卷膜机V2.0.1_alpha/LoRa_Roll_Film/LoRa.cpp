@@ -19,6 +19,8 @@
 #include "public.h"
 #include "fun_periph.h"
 #include "Memory.h"
+#include "Private_Timer.h"
+#include "Ring_Buffer.h"
 
 /*Create LoRa object*/
 LoRa LoRa_MHL9LF;
@@ -52,6 +54,7 @@ void LoRa::BaudRate(unsigned int baudrate)
 
 /*
  @brief     : 配置LoRa模式。
+              切换模式的回执需要直接从串口读取，所以先停止接收泵，进入透传模式后再重新开启。
  @param     : AT_status : 高电平是AT模式，低电平是透传模式
  @return    : 无
  */
@@ -59,6 +62,9 @@ bool LoRa::Mode(LoRa_Mode AT_status)
 {
     unsigned char RcvBuf[6];
     unsigned char i = 0;
+    bool ModeOKFlag = false;
+
+    Stop_LoRa_Rx_Pump();
 
     if (AT_status == AT)
         LoRa_Serial.print(SOFT_AT);
@@ -68,16 +74,37 @@ bool LoRa::Mode(LoRa_Mode AT_status)
     delay(100);
     while (LoRa_Serial.available() > 0)
     {
-        if (i >= 6) return false;
+        if (i >= 6)
+        {
+            i = 0;  //回执过长，视为切换失败
+            break;
+        }
         RcvBuf[i++] = LoRa_Serial.read();
     }
     if (i > 0)
     {
         if (RcvBuf[2] == 'O' && RcvBuf[3] == 'K')
-            return true;
+            ModeOKFlag = true;
     }
-    else
-        return false;
+
+    if (AT_status == PASS_THROUGH_MODE)
+        Start_LoRa_Rx_Pump();
+
+    return ModeOKFlag;
+}
+
+/*
+ @brief     : 丢弃LoRa串口和接收环形缓存里所有未处理的数据（如重启后LoRa模块发送的厂家信息）
+ @param     : 无
+ @return    : 无
+ */
+void LoRa::Rx_Flush(void)
+{
+    Stop_LoRa_Rx_Pump();
+    while (LoRa_Serial.available() > 0)
+        LoRa_Serial.read();
+    LoRa_Rx_Buffer.Clear();
+    Start_LoRa_Rx_Pump();
 }
 
 /*
@@ -104,6 +131,7 @@ void LoRa::IsReset(bool Is_reset)
 void LoRa::LoRa_Shutdown(void)
 {   
     LORA_PWR_OFF;
+    Stop_LoRa_Rx_Pump();
     /*注意！，如果下面这个end()已经执行过一次，并且中途没有重启打开begin，第二次end()，会死机！*/
     LoRa_Serial.end();
     pinMode(PA2, OUTPUT); //TX
@@ -496,10 +524,78 @@ bool LoRa::Rewrite_ID(void)
         if (!LoRa_Para_Config.Save_LoRa_Addr((unsigned char *)WriteAddr))
             return false;
     }
-    
+
+    Load_Hw_Addr(VerifyFlag ? WriteAddr : EP_Buffer);
     return true;
 }
 
+/*
+ @brief     : 把AT指令里的8位十六进制字符地址转换成硬件帧头里的4个字节，按地址接收时用来比较
+ @param     : 8位十六进制字符地址，如"14052A0C"
+ @return    : 无
+ */
+void LoRa::Load_Hw_Addr(const char *addr_str)
+{
+    unsigned char Nibble;
+
+    for (unsigned char i = 0; i < LORA_HW_ADDR_LEN * 2; i++)
+    {
+        if (addr_str[i] >= '0' && addr_str[i] <= '9')
+            Nibble = addr_str[i] - '0';
+        else if (addr_str[i] >= 'A' && addr_str[i] <= 'F')
+            Nibble = addr_str[i] - '7';
+        else
+        {
+            HwAddrValidFlag = false;
+            return;
+        }
+
+        if (i % 2 == 0)
+            HwAddr[i / 2] = Nibble << 4;
+        else
+            HwAddr[i / 2] |= Nibble;
+    }
+    HwAddrValidFlag = true;
+}
+
+/*
+ @brief     : 判断硬件帧头里的地址是不是本机地址或广播地址。
+              广播地址有两种写法：协议里的00000071，和配置给模块的组播地址71000000。
+ @param     : 硬件帧头里的4个地址字节
+ @return    : true or false
+ */
+bool LoRa::Match_Hw_Addr(const unsigned char *addr)
+{
+    const unsigned char BroadcastAddr[][LORA_HW_ADDR_LEN] = {
+        {0x00, 0x00, 0x00, 0x71}, {0x71, 0x00, 0x00, 0x00}
+    };
+
+    for (unsigned char i = 0; i < sizeof(BroadcastAddr) / LORA_HW_ADDR_LEN; i++)
+    {
+        if (memcmp(addr, BroadcastAddr[i], LORA_HW_ADDR_LEN) == 0)
+            return true;
+    }
+
+    if (!HwAddrValidFlag)
+        return false;
+
+    return (memcmp(addr, HwAddr, LORA_HW_ADDR_LEN) == 0);
+}
+
+/*
+ @brief     : 按地址收发时每一包前面加的硬件帧头（可以在中断里调用）。
+              上行都发给网关，地址用配置给所有模块的组播地址71000000，控制字不用，填0
+ @param     : 无
+ @return    : 硬件帧头（LORA_HW_HEAD_LEN byte）
+ */
+const unsigned char *LoRa::Tx_Hw_Head(void)
+{
+    static const unsigned char HwHead[LORA_HW_HEAD_LEN] = {
+        LORA_HW_HEAD, 0x71, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+    };
+    return HwHead;
+}
+
 bool LoRa::Param_Check(const char *cmd, const char *para, bool only_set)
 {
     unsigned char RcvBuffer[10] = {0};
@@ -586,9 +682,12 @@ void LoRa::Parameter_Init(bool only_net)
     unsigned char i = 0;
     unsigned char AlarmLEDRunNum = 0;
     bool SetStatusFlag;
-    unsigned char c;
 
     Serial.println("Configurate LoRa parameters...");
+
+    /*配置期间发送队列已经清空，先停止加硬件帧头，配置成功后再按保存的方式打开*/
+    AddrModeFlag = false;
+    bool AddrMode = (LoRa_Para_Config.Read_LoRa_Addr_Mode() == LORA_ADDR_MODE_ON);
  
     do{
         i = 0;
@@ -597,8 +696,9 @@ void LoRa::Parameter_Init(bool only_net)
         if (!only_net)
         {
             StatusBuffer[i++] = Rewrite_ID();
-            StatusBuffer[i++] = Param_Check(AT_MADDR_, "71000000", false);
+            StatusBuffer[i++] = Param_Check(AT_MADDR_, LORA_MADDR_PARA, false);
             StatusBuffer[i++] = Param_Check(AT_RIQ_, "00", true); 
+            StatusBuffer[i++] = Param_Check(AT_MODE_, AddrMode ? LORA_MODE_ADDRESS : LORA_MODE_TRANSPARENT, false);    //按地址收发时模块过滤不是发给本机的单播
             StatusBuffer[i++] = Param_Check(AT_TFREQ_, "1C4FECC0", false);
             StatusBuffer[i++] = Param_Check(AT_RFREQ_, "1C083560", false);
             StatusBuffer[i++] = Param_Check(AT_SYNC_, "12", false);
@@ -631,6 +731,7 @@ void LoRa::Parameter_Init(bool only_net)
           #else
             StatusBuffer[i++] = Param_Check(AT_NET_, "01", true);
           #endif
+            StatusBuffer[i++] = Param_Check(AT_MODE_, AddrMode ? LORA_MODE_ADDRESS : LORA_MODE_TRANSPARENT, false);
         }
 
         for (unsigned char j = 0; j < i; j++)
@@ -650,14 +751,23 @@ void LoRa::Parameter_Init(bool only_net)
                 break;
             }
         }
-        if (SetStatusFlag)  return;
+        if (SetStatusFlag)
+        {
+            AddrModeFlag = AddrMode;
+            /*
+             *已经在AT模式下，顺便读取信号强度。上电和定时自检时都会配置参数，
+             *回执里使用保存的值，不为了读信号强度停止收发泵
+             */
+            if (!LoRa_AT(SignalCSQ, true, AT_CSQ_, 0))
+                Serial.println("Read LoRa CSQ Err <Parameter_Init>");
+            return;
+        }
 
         #if USE_LORA_RESET
         LoRa_Restart();
         delay(2000);
         iwdg_feed();
-        while (LoRa_Serial.available() > 0)
-            c = LoRa_Serial.read();
+        Rx_Flush();
         #endif
 
     }
@@ -40,6 +40,7 @@
 #define AT_RIQ_                     "AT+RIQ?\r\n"
 #define AT_NET_                     "AT+NET?\r\n"
 #define AT_SIP_                     "AT+SIP?\r\n"
+#define AT_MODE_                    "AT+MODE?\r\n" //return 1 byte
 
 #define AT_INQUIRE_PARA(at)         at"\r\n"   
 
@@ -69,6 +70,23 @@
 
 #define AT_CONFIG_PARA(at, para)    at#para"\r\n"
 
+/*M-KL9 hardware frame head*/
+#define LORA_HW_HEAD                0x61    //硬件帧头
+#define LORA_HW_HEAD_LEN            8       //硬件帧头1 + 地址4 + 控制字3
+#define LORA_HW_ADDR_LEN            4
+#define LORA_MADDR_PARA             "71000000"  //组播地址
+#define LORA_MODE_TRANSPARENT       "00"    //透传发送，不带硬件帧头
+#define LORA_MODE_ADDRESS           "01"    //按地址收发，带硬件帧头
+
+/*
+ * 按地址收发方式（寄存器0x1C）：LoRa模块只把发给本机地址或广播地址的数据交给单片机，
+ * 收到的每一帧前面带有8个字节的硬件帧头；发送时模块也按硬件帧头里的地址发送，
+ * 所以每一包前面都要加上硬件帧头，上行发到组播地址，网关和各节点配置的组播地址相同。
+ * 需要服务器按地址发送，默认关闭，按原来的透传方式只找0xFE帧头。
+ */
+#define LORA_ADDR_MODE_OFF          0x00    //透传
+#define LORA_ADDR_MODE_ON           0x01    //按地址收发
+
 enum LoRa_Mode{
     AT = 0, PASS_THROUGH_MODE
 };
@@ -94,11 +112,16 @@ public:
     void BaudRate(unsigned int baudrate);
     //AT mode or pass-through mode
     bool Mode(LoRa_Mode AT_status);
+    void Rx_Flush(void);
     void IsReset(bool Is_reset);
     bool LoRa_AT(unsigned char *data_buffer, bool is_query, const char *cmd, const char *para);
     
     bool Rewrite_ID(void);
     void Parameter_Init(bool only_net);
+    bool Match_Hw_Addr(const unsigned char *addr);
+    bool Address_Mode(void) {return AddrModeFlag;}
+    const unsigned char *CSQ_Value(void) {return SignalCSQ;}
+    const unsigned char *Tx_Hw_Head(void);
 
 private:
     unsigned char Detect_Error_Receipt(unsigned char *verify_data);
@@ -113,6 +136,12 @@ private:
     bool String_to_Hex(unsigned char *str, unsigned char len);
 
     bool Param_Check(const char *cmd, const char *para, bool only_set);
+    void Load_Hw_Addr(const char *addr_str);
+
+    unsigned char HwAddr[LORA_HW_ADDR_LEN];  //本机LoRa地址，Rewrite_ID 确认后保存
+    bool HwAddrValidFlag;
+    volatile bool AddrModeFlag;  //模块已经配置成按地址收发，发送泵在中断里读取
+    unsigned char SignalCSQ[2];  //发送和接收信号强度，配置参数时读取，回执里只用保存的值
 };
 
 /*Create LoRa object*/
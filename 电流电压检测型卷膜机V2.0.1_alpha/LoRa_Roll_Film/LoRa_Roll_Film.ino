@@ -23,6 +23,8 @@
 #include "IAP.h"
 #include "Private_Timer.h"
 #include "Security.h"
+#include "Schedule.h"
+#include "Tx_Queue.h"
 #include "public.h"
 
 /*测试宏，清零上一次开度、本次开度、实时开度*/
@@ -52,10 +54,15 @@ void setup()
   Motor_Operation.Motor_GPIO_Config();
   Motor_Operation.Direction_Selection(Stop);
   EEPROM_Operation.EEPROM_GPIO_Config();
+  EEPROM_Operation.Param_Mirror_Load(); //参数区读进RAM，之后读参数不再走I2C
+  /*旧版本只保存了5个工作组号，升级后第一次上电生成工作组位图*/
+  if (!Roll_Operation.Verify_Group_Bitmap_Flag())
+    Roll_Operation.Rebuild_Group_Bitmap();
   Some_Peripheral.Peripheral_GPIO_Config();
   iwdg_feed();
 
   LoRa_MHL9LF.LoRa_GPIO_Config();
+  LoRa_Rx_Timer_Init(); //LoRa串口接收泵，进入透传模式后开启
   LoRa_MHL9LF.Mode(PASS_THROUGH_MODE);
   /*
    *上电后LoRa模块会发送厂家信息过来
@@ -95,6 +102,8 @@ void setup()
     iwdg_feed();
   }
   Serial.println("SN self_check success...");
+  /*信道忙退避的随机数按SN码生成，同时回复群发指令的设备退避时间互相错开*/
+  LoRa_Tx_Queue.Seed_Backoff(((unsigned long)gSN_Code[5] << 24) | ((unsigned long)gSN_Code[6] << 16) | (gSN_Code[7] << 8) | gSN_Code[8]);
   LED_RUNNING;
   iwdg_feed(); 
 
@@ -107,6 +116,9 @@ void setup()
   Motor_Operation.Adjust_deviation();
   iwdg_feed();   
 
+  Roll_Schedule.Load();
+  Roll_Schedule.Arm();
+
   Self_Check_Parameter_Timer_Init();                                                                                                                                                                                                                                                                                                                                                                                                                                
 }
 
@@ -114,11 +126,14 @@ void loop()
 {
   iwdg_feed(); 
   LoRa_Command_Analysis.Receive_LoRa_Cmd();
+  LoRa_Command_Analysis.Auto_Off_Check();
+  LoRa_Command_Analysis.Schedule_Check();
 
   Motor_Operation.Detect_Manual_Rolling();
   Motor_Operation.Trace_Opening();
 
   Motor_Operation.Adjust_Opening();
+  Motor_Operation.Refresh_Telemetry();
 
   Check_Store_Param_And_LoRa();
 
@@ -147,7 +162,7 @@ void Request_Access_Network(void)
       Serial.println("Already Clear area number and grouop number...");
 
     unsigned char Default_WorkGroup[5] = {0x01, 0x00, 0x00, 0x00, 0x00};
-    if(Roll_Operation.Save_Group_Number(Default_WorkGroup))
+    if(Roll_Operation.Save_Group_Number(Default_WorkGroup) && Roll_Operation.Rebuild_Group_Bitmap())
       Serial.println("Save gourp number success...");
 
    LED_NO_REGISTER;
@@ -15,6 +15,7 @@
 #include <libmaple/iwdg.h>
 #include "Motor.h"
 #include "public.h"
+#include "LoRa.h"
 
 /*创建EEPROM操作对象*/
 EEPROM_Operations EEPROM_Operation;
@@ -39,6 +40,178 @@ void EEPROM_Operations::EEPROM_GPIO_Config(void)
     I2C_Init();
 }
 
+unsigned char EEPROM_Operations::ParamMirror[PARAM_MIRROR_LEN];
+unsigned char EEPROM_Operations::ParamMirrorCRC = 0;
+bool EEPROM_Operations::ParamMirrorValidFlag = false;
+unsigned long EEPROM_Operations::ParamMirrorReloadTimes = 0;
+unsigned long EEPROM_Operations::ParamWriteTimes = 0;
+
+/*
+ @brief     : 上电时把EEPROM参数区读进RAM镜像。连续读两遍，两遍一致才认为总线读取可靠，
+              之后各个读参数函数都直接读镜像，不再走模拟I2C
+ @para      : 无
+ @return    : true or false（多次读取都不一致，镜像不启用，读参数仍然直接读EEPROM）
+ */
+bool EEPROM_Operations::Param_Mirror_Load(void)
+{
+    unsigned char Temp[PARAM_MIRROR_LEN];
+    unsigned char i;
+
+    ParamMirrorValidFlag = false;
+
+    for (unsigned char TryNum = 0; TryNum < PARAM_MIRROR_LOAD_TRY_NUM; TryNum++)
+    {
+        for (i = 0; i < PARAM_MIRROR_LEN; i++)
+            Temp[i] = AT24CXX_ReadOneByte(PARAM_MIRROR_BASE_ADDR + i);
+
+        for (i = 0; i < PARAM_MIRROR_LEN; i++)
+        {
+            if (AT24CXX_ReadOneByte(PARAM_MIRROR_BASE_ADDR + i) != Temp[i])
+                break;
+        }
+
+        if (i == PARAM_MIRROR_LEN)
+        {
+            memcpy(ParamMirror, Temp, PARAM_MIRROR_LEN);
+            ParamMirrorCRC = GetCrc8(ParamMirror, PARAM_MIRROR_LEN);
+            ParamMirrorValidFlag = true;
+            return true;
+        }
+        iwdg_feed();
+    }
+    Serial.println("Load parameter mirror ERROR !!! <Param_Mirror_Load>");
+    return false;
+}
+
+/*
+ @brief     : 后台校验RAM镜像。镜像自身CRC8不对（RAM被改写），或与EEPROM内容不一致，
+              都以EEPROM为准重新加载镜像
+ @para      : 无
+ @return    : true（镜像正常） or false（已重新加载）
+ */
+bool EEPROM_Operations::Param_Mirror_Verify(void)
+{
+    bool MirrorOK = ParamMirrorValidFlag;
+
+    if (MirrorOK && GetCrc8(ParamMirror, PARAM_MIRROR_LEN) != ParamMirrorCRC)
+        MirrorOK = false;
+
+    for (unsigned char i = 0; MirrorOK && i < PARAM_MIRROR_LEN; i++)
+    {
+        if (AT24CXX_ReadOneByte(PARAM_MIRROR_BASE_ADDR + i) != ParamMirror[i])
+            MirrorOK = false;
+    }
+
+    if (!MirrorOK)
+    {
+        ParamMirrorReloadTimes++;
+        Serial.println("Parameter mirror mismatch, reload from EEPROM... <Param_Mirror_Verify>");
+        Param_Mirror_Load();
+    }
+    return MirrorOK;
+}
+
+/*
+ @brief     : 读取一个参数字节。镜像已加载且地址在参数区内时直接读RAM，否则读EEPROM
+ @para      : EEPROM地址
+ @return    : 1 byte
+ */
+unsigned char EEPROM_Operations::Param_Read(unsigned int addr)
+{
+    if (ParamMirrorValidFlag && addr >= PARAM_MIRROR_BASE_ADDR && addr <= PARAM_MIRROR_END_ADDR)
+        return ParamMirror[addr - PARAM_MIRROR_BASE_ADDR];
+
+    return AT24CXX_ReadOneByte(addr);
+}
+
+/*
+ @brief     : 写一个参数字节到EEPROM，并把回读的值同步到镜像。
+              镜像保存的是回读值，所以各个保存函数写完后的回读校验读镜像即可，结果与读EEPROM相同
+ @para      : 1.EEPROM地址
+              2.数据值
+ @return    : 无
+ */
+void EEPROM_Operations::Param_Write(unsigned int addr, unsigned char dat)
+{
+    AT24CXX_WriteOneByte(addr, dat);
+    ParamWriteTimes++;
+
+    if (ParamMirrorValidFlag && addr >= PARAM_MIRROR_BASE_ADDR && addr <= PARAM_MIRROR_END_ADDR)
+    {
+        ParamMirror[addr - PARAM_MIRROR_BASE_ADDR] = AT24CXX_ReadOneByte(addr);
+        ParamMirrorCRC = GetCrc8(ParamMirror, PARAM_MIRROR_LEN);
+    }
+}
+
+/*
+ @brief     : 保存一段带CRC8校验的参数，与已保存的相同的字节不再重复写入
+ @para      : 1.起始地址
+              2.数据
+              3.长度（不超过16）
+              4.校验码地址
+ @return    : true or false
+ */
+bool EEPROM_Operations::Param_Block_Write(unsigned int base_addr, const unsigned char *data, unsigned char len, unsigned int verify_addr)
+{
+    unsigned char Temp[16];
+
+    if (len > sizeof(Temp))
+        return false;
+
+    memcpy(Temp, data, len);
+    unsigned char Verify = Param_Block_Crc(Temp, len);
+
+    EEPROM_Write_Enable();
+    for (unsigned char i = 0; i < len; i++)
+    {
+        /*如果本次要保存的数据与已经保存的数据相同，为了维护储存器，不再重复保存*/
+        if (Param_Read(base_addr + i) != Temp[i])
+            Param_Write(base_addr + i, Temp[i]);
+    }
+    if (Param_Read(verify_addr) != Verify)
+        Param_Write(verify_addr, Verify);
+    EEPROM_Write_Disable();
+
+    for (unsigned char i = 0; i < len; i++)
+    {
+        if (Param_Read(base_addr + i) != Temp[i])
+            return false;
+    }
+    return (Param_Read(verify_addr) == Verify);
+}
+
+/*
+ @brief     : 读取一段带CRC8校验的参数
+ @para      : 1.起始地址
+              2.读出的数据
+              3.长度
+              4.校验码地址
+ @return    : true or false（没有保存过或数据损坏）
+ */
+bool EEPROM_Operations::Param_Block_Read(unsigned int base_addr, unsigned char *data, unsigned char len, unsigned int verify_addr)
+{
+    for (unsigned char i = 0; i < len; i++)
+        data[i] = Param_Read(base_addr + i);
+
+    return (Param_Block_Crc(data, len) == Param_Read(verify_addr));
+}
+
+/*
+ @brief     : 计算参数块的CRC8，初始值为PARAM_BLOCK_CRC_SEED，
+              没有写过的全0或全0xFF参数块校验不通过，按没有设置过处理，使用默认值
+ @para      : 1.数据
+              2.长度
+ @return    : CRC8
+ */
+unsigned char EEPROM_Operations::Param_Block_Crc(const unsigned char *data, unsigned char len)
+{
+    unsigned char Crc = PARAM_BLOCK_CRC_SEED;
+
+    for (unsigned char i = 0; i < len; i++)
+        Crc = Crc8_Update(Crc, data[i]);
+    return Crc;
+}
+
 /*
  @brief     : 写SN码到EEPROM
  @para      : SN码数组
@@ -48,15 +221,15 @@ bool SN_Operations::Save_SN_Code(unsigned char *sn_code)
 {
     EEPROM_Write_Enable();
     for (unsigned char i = 0; i < 9; i++)
-        AT24CXX_WriteOneByte(SN_BASE_ADDR + i, sn_code[i]);
+        Param_Write(SN_BASE_ADDR + i, sn_code[i]);
 
     unsigned char SN_Verify = GetCrc8(&sn_code[0], 9); //得到SN码的CRC8
-    AT24CXX_WriteOneByte(SN_VERIFY_ADDR, SN_Verify);
+    Param_Write(SN_VERIFY_ADDR, SN_Verify);
     
     /*读出写入的SN码，生成一个CRC8，和写入的CRC8校验，判断写入是否成功*/
     unsigned char SN_CodeTemp[9];
     for (unsigned char i = 0; i < 9; i++)
-        SN_CodeTemp[i] = AT24CXX_ReadOneByte(SN_BASE_ADDR + i);
+        SN_CodeTemp[i] = Param_Read(SN_BASE_ADDR + i);
 
     unsigned char SN_VerifyTemp = GetCrc8(&SN_CodeTemp[0], 9);
     if (SN_VerifyTemp != SN_Verify)
@@ -66,8 +239,8 @@ bool SN_Operations::Save_SN_Code(unsigned char *sn_code)
     }
     else
     {
-        if (AT24CXX_ReadOneByte(SN_OPERATION_FLAG_ADDR) != 0x55)
-            AT24CXX_WriteOneByte(SN_OPERATION_FLAG_ADDR, 0x55); //校验成功，SN写入成功标志位置0x55。
+        if (Param_Read(SN_OPERATION_FLAG_ADDR) != 0x55)
+            Param_Write(SN_OPERATION_FLAG_ADDR, 0x55); //校验成功，SN写入成功标志位置0x55。
 
         EEPROM_Write_Disable();
         return true;
@@ -84,14 +257,14 @@ bool SN_Operations::Save_BKP_SN_Code(unsigned char *sn_code)
 {
     EEPROM_Write_Enable();
     for (unsigned char i = 0; i < 9; i++)
-        AT24CXX_WriteOneByte(SN_BKP_BASE_ADDR + i, sn_code[i]);
+        Param_Write(SN_BKP_BASE_ADDR + i, sn_code[i]);
 
     unsigned char SN_BKP_Verify = GetCrc8(&sn_code[0], 9);
-    AT24CXX_WriteOneByte(SN_BKP_VERIFY_ADDR, SN_BKP_Verify);
+    Param_Write(SN_BKP_VERIFY_ADDR, SN_BKP_Verify);
 
     unsigned char SN_CodeTemp[9];
     for (unsigned char i = 0; i < 9; i++)
-        SN_CodeTemp[i] = AT24CXX_ReadOneByte(SN_BKP_BASE_ADDR + i);
+        SN_CodeTemp[i] = Param_Read(SN_BKP_BASE_ADDR + i);
 
     unsigned char SN_BKP_VerifyTemp = GetCrc8(&SN_CodeTemp[0], 9);
     if (SN_BKP_VerifyTemp != SN_BKP_Verify)
@@ -101,8 +274,8 @@ bool SN_Operations::Save_BKP_SN_Code(unsigned char *sn_code)
     }
     else
     {
-        if (AT24CXX_ReadOneByte(SN_BKP_OPERATION_FLAG_ADDR) != 0x55)
-            AT24CXX_WriteOneByte(SN_BKP_OPERATION_FLAG_ADDR, 0x55);
+        if (Param_Read(SN_BKP_OPERATION_FLAG_ADDR) != 0x55)
+            Param_Write(SN_BKP_OPERATION_FLAG_ADDR, 0x55);
 
         EEPROM_Write_Disable();
         return true;
@@ -119,9 +292,9 @@ bool SN_Operations::Read_SN_Code(unsigned char *sn_code)
     unsigned char SN_Temp[9] = {0};
 
     for (unsigned char i = 0; i < 9; i++)
-        SN_Temp[i] = AT24CXX_ReadOneByte(SN_BASE_ADDR + i);
+        SN_Temp[i] = Param_Read(SN_BASE_ADDR + i);
 
-    unsigned char SN_Verify = AT24CXX_ReadOneByte(SN_VERIFY_ADDR);
+    unsigned char SN_Verify = Param_Read(SN_VERIFY_ADDR);
     unsigned char SN_VerifyTemp = GetCrc8(&SN_Temp[0], 9);
     
     /*校验数据CRC8*/
@@ -146,9 +319,9 @@ bool SN_Operations::Read_BKP_SN_Code(unsigned char *sn_code)
     unsigned char SN_BKP_Temp[9] = {0};
 
     for (unsigned char i = 0; i < 9; i++)
-        SN_BKP_Temp[i] = AT24CXX_ReadOneByte(SN_BKP_BASE_ADDR + i);
+        SN_BKP_Temp[i] = Param_Read(SN_BKP_BASE_ADDR + i);
 
-    unsigned char SN_BKP_Verify = AT24CXX_ReadOneByte(SN_BKP_VERIFY_ADDR);
+    unsigned char SN_BKP_Verify = Param_Read(SN_BKP_VERIFY_ADDR);
     unsigned char SN_BKP_VerifyTemp = GetCrc8(&SN_BKP_Temp[0], 9);
 
     if (SN_BKP_Verify != SN_BKP_VerifyTemp)
@@ -170,8 +343,8 @@ bool SN_Operations::Read_BKP_SN_Code(unsigned char *sn_code)
 void SN_Operations::Read_Random_Seed(unsigned char *random_seed)
 {
     unsigned char RandomTemp[2];
-    RandomTemp[0] = AT24CXX_ReadOneByte(SN_BKP_BASE_ADDR + 7);
-    RandomTemp[1] = AT24CXX_ReadOneByte(SN_BKP_BASE_ADDR + 8);
+    RandomTemp[0] = Param_Read(SN_BKP_BASE_ADDR + 7);
+    RandomTemp[1] = Param_Read(SN_BKP_BASE_ADDR + 8);
     *random_seed = GetCrc8(RandomTemp, 2);
 }
 
@@ -182,7 +355,7 @@ void SN_Operations::Read_Random_Seed(unsigned char *random_seed)
  */
 bool SN_Operations::Verify_Save_SN_Code(void)
 {
-    if (AT24CXX_ReadOneByte(SN_OPERATION_FLAG_ADDR) == 0x55)
+    if (Param_Read(SN_OPERATION_FLAG_ADDR) == 0x55)
         return true;
     else
         return false;
@@ -195,7 +368,7 @@ bool SN_Operations::Verify_Save_SN_Code(void)
  */
 bool SN_Operations::Verify_Save_BKP_SN_Code(void)
 {
-    if (AT24CXX_ReadOneByte(SN_BKP_OPERATION_FLAG_ADDR) == 0x55)
+    if (Param_Read(SN_BKP_OPERATION_FLAG_ADDR) == 0x55)
         return true;
     else
         return false;
@@ -209,14 +382,14 @@ bool SN_Operations::Verify_Save_BKP_SN_Code(void)
  */
 bool SN_Operations::Clear_SN_Save_Flag(void)
 {
-    if (AT24CXX_ReadOneByte(SN_OPERATION_FLAG_ADDR) == 0x00)
+    if (Param_Read(SN_OPERATION_FLAG_ADDR) == 0x00)
         return true;
 
     EEPROM_Write_Enable();
-    AT24CXX_WriteOneByte(SN_OPERATION_FLAG_ADDR, 0x00);
+    Param_Write(SN_OPERATION_FLAG_ADDR, 0x00);
     EEPROM_Write_Disable();
     /*判断是否已成功清除该标志位*/
-    if (AT24CXX_ReadOneByte(SN_OPERATION_FLAG_ADDR) == 0x00)
+    if (Param_Read(SN_OPERATION_FLAG_ADDR) == 0x00)
         return true;
     else
         return false;
@@ -231,14 +404,14 @@ bool SN_Operations::Clear_SN_Save_Flag(void)
  */
 bool SN_Operations::Clear_BKP_SN_Save_Flag(void)
 {
-    if (AT24CXX_ReadOneByte(SN_BKP_OPERATION_FLAG_ADDR) == 0x00)
+    if (Param_Read(SN_BKP_OPERATION_FLAG_ADDR) == 0x00)
         return true;
 
     EEPROM_Write_Enable();
-    AT24CXX_WriteOneByte(SN_BKP_OPERATION_FLAG_ADDR, 0x00);
+    Param_Write(SN_BKP_OPERATION_FLAG_ADDR, 0x00);
     EEPROM_Write_Disable();
 
-    if (AT24CXX_ReadOneByte(SN_BKP_OPERATION_FLAG_ADDR) == 0x00)
+    if (Param_Read(SN_BKP_OPERATION_FLAG_ADDR) == 0x00)
         return true;
     else
         return false;
@@ -251,14 +424,14 @@ bool SN_Operations::Clear_BKP_SN_Save_Flag(void)
  */
 bool SN_Operations::Set_SN_Access_Network_Flag(void)
 {
-    if (AT24CXX_ReadOneByte(SN_ACCESS_NETWORK_FLAG_ADDR) == 0x55)
+    if (Param_Read(SN_ACCESS_NETWORK_FLAG_ADDR) == 0x55)
         return true;
 
     EEPROM_Write_Enable();
-    AT24CXX_WriteOneByte(SN_ACCESS_NETWORK_FLAG_ADDR, 0X55);
+    Param_Write(SN_ACCESS_NETWORK_FLAG_ADDR, 0X55);
     EEPROM_Write_Disable();
     /*判断标志位是否写入成功*/
-    if (AT24CXX_ReadOneByte(SN_ACCESS_NETWORK_FLAG_ADDR) == 0x55)
+    if (Param_Read(SN_ACCESS_NETWORK_FLAG_ADDR) == 0x55)
         return true;
     else
         return false;
@@ -279,14 +452,14 @@ bool SN_Operations::Clear_SN_Access_Network_Flag(void)
         if (digitalRead(SW_FUN2) == LOW)
         {
             Some_Peripheral.Key_Buzz(1000);
-            if (AT24CXX_ReadOneByte(SN_ACCESS_NETWORK_FLAG_ADDR) != 0x00)
+            if (Param_Read(SN_ACCESS_NETWORK_FLAG_ADDR) != 0x00)
             {
                 EEPROM_Write_Enable();
-                AT24CXX_WriteOneByte(SN_ACCESS_NETWORK_FLAG_ADDR, 0x00);
+                Param_Write(SN_ACCESS_NETWORK_FLAG_ADDR, 0x00);
                 EEPROM_Write_Disable();
             }
             /*验证标志位是否清除成功*/
-            if (AT24CXX_ReadOneByte(SN_ACCESS_NETWORK_FLAG_ADDR) == 0x00)
+            if (Param_Read(SN_ACCESS_NETWORK_FLAG_ADDR) == 0x00)
                 return true;
             else
                 return false;  
@@ -302,7 +475,7 @@ bool SN_Operations::Clear_SN_Access_Network_Flag(void)
 bool SN_Operations::Verify_SN_Access_Network_Flag(void)
 {
     bool BoolValue;
-    AT24CXX_ReadOneByte(SN_ACCESS_NETWORK_FLAG_ADDR) == 0x55 ? BoolValue = true : BoolValue = false;
+    Param_Read(SN_ACCESS_NETWORK_FLAG_ADDR) == 0x55 ? BoolValue = true : BoolValue = false;
     return BoolValue;
 }
 
@@ -345,14 +518,14 @@ bool SN_Operations::Self_check(unsigned char *sn_code)
  */
 bool LoRa_Config::Save_LoRa_Config_Flag(void)
 {
-    if (AT24CXX_ReadOneByte(LORA_PARA_CONFIG_FLAG_ADDR) == 0x55)
+    if (Param_Read(LORA_PARA_CONFIG_FLAG_ADDR) == 0x55)
         return true;
 
     EEPROM_Write_Enable();
-    AT24CXX_WriteOneByte(LORA_PARA_CONFIG_FLAG_ADDR, 0x55);
+    Param_Write(LORA_PARA_CONFIG_FLAG_ADDR, 0x55);
     EEPROM_Write_Disable();
 
-    if (AT24CXX_ReadOneByte(LORA_PARA_CONFIG_FLAG_ADDR) == 0x55)
+    if (Param_Read(LORA_PARA_CONFIG_FLAG_ADDR) == 0x55)
         return true;
     else
         return false;
@@ -365,7 +538,7 @@ bool LoRa_Config::Save_LoRa_Config_Flag(void)
  */
 bool LoRa_Config::Verify_LoRa_Config_Flag(void)
 {
-    if (AT24CXX_ReadOneByte(LORA_PARA_CONFIG_FLAG_ADDR) == 0x55)
+    if (Param_Read(LORA_PARA_CONFIG_FLAG_ADDR) == 0x55)
         return true;
     else
         return false;
@@ -378,14 +551,14 @@ bool LoRa_Config::Verify_LoRa_Config_Flag(void)
  */
 bool LoRa_Config::Clear_LoRa_Config_Flag(void)
 {
-    if (AT24CXX_ReadOneByte(LORA_PARA_CONFIG_FLAG_ADDR) == 0x00)
+    if (Param_Read(LORA_PARA_CONFIG_FLAG_ADDR) == 0x00)
         return true;
     
     EEPROM_Write_Enable();
-    AT24CXX_WriteOneByte(LORA_PARA_CONFIG_FLAG_ADDR, 0x00);
+    Param_Write(LORA_PARA_CONFIG_FLAG_ADDR, 0x00);
     EEPROM_Write_Disable();   
 
-    if (AT24CXX_ReadOneByte(LORA_PARA_CONFIG_FLAG_ADDR) == 0x00)
+    if (Param_Read(LORA_PARA_CONFIG_FLAG_ADDR) == 0x00)
         return true;
     else
         return false;
@@ -393,14 +566,14 @@ bool LoRa_Config::Clear_LoRa_Config_Flag(void)
 
 bool LoRa_Config::Save_LoRa_Com_Mode_Flag(void)
 {
-    if (AT24CXX_ReadOneByte(LORA_COM_MODE_FLAG_ADDR) == 0x55)
+    if (Param_Read(LORA_COM_MODE_FLAG_ADDR) == 0x55)
         return true;
 
     EEPROM_Write_Enable();
-    AT24CXX_WriteOneByte(LORA_COM_MODE_FLAG_ADDR, 0x55);
+    Param_Write(LORA_COM_MODE_FLAG_ADDR, 0x55);
     EEPROM_Write_Disable();
     
-    if (AT24CXX_ReadOneByte(LORA_COM_MODE_FLAG_ADDR == 0x55))
+    if (Param_Read(LORA_COM_MODE_FLAG_ADDR == 0x55))
         return true;
     else
         return false;
@@ -408,14 +581,14 @@ bool LoRa_Config::Save_LoRa_Com_Mode_Flag(void)
 
 bool LoRa_Config::Clear_LoRa_Com_Mode_Flag(void)
 {
-    if (AT24CXX_ReadOneByte(LORA_COM_MODE_FLAG_ADDR) == 0x00)
+    if (Param_Read(LORA_COM_MODE_FLAG_ADDR) == 0x00)
         return true;
 
     EEPROM_Write_Enable();
-    AT24CXX_WriteOneByte(LORA_COM_MODE_FLAG_ADDR, 0x00);
+    Param_Write(LORA_COM_MODE_FLAG_ADDR, 0x00);
     EEPROM_Write_Disable();
     
-    if (AT24CXX_ReadOneByte(LORA_COM_MODE_FLAG_ADDR == 0x00))
+    if (Param_Read(LORA_COM_MODE_FLAG_ADDR == 0x00))
         return true;
     else
         return false;
@@ -427,15 +600,15 @@ bool LoRa_Config::Save_LoRa_Com_Mode(unsigned char mode)
 
     if (mode == 0xF0 || mode == 0xF1)
     {
-        if (AT24CXX_ReadOneByte(LORA_COM_MODE_ADDR) == mode)
+        if (Param_Read(LORA_COM_MODE_ADDR) == mode)
             return true;
         
         EEPROM_Write_Enable();
-        AT24CXX_WriteOneByte(LORA_COM_MODE_ADDR, mode);
+        Param_Write(LORA_COM_MODE_ADDR, mode);
         ModeCrc8 = GetCrc8(&mode, 1);
-        AT24CXX_WriteOneByte(LORA_COM_MODE_VERIFY_ADDR, ModeCrc8);
+        Param_Write(LORA_COM_MODE_VERIFY_ADDR, ModeCrc8);
 
-        if (AT24CXX_ReadOneByte(LORA_COM_MODE_ADDR) == mode)
+        if (Param_Read(LORA_COM_MODE_ADDR) == mode)
         {
             Save_LoRa_Com_Mode_Flag();
             EEPROM_Write_Disable();
@@ -459,10 +632,10 @@ unsigned char LoRa_Config::Read_LoRa_Com_Mode(void)
     unsigned char ComTemp;
     unsigned char Comcrc8;
 
-    ComTemp = AT24CXX_ReadOneByte(LORA_COM_MODE_ADDR);
+    ComTemp = Param_Read(LORA_COM_MODE_ADDR);
     Comcrc8 = GetCrc8(&ComTemp, 1);
 
-    if (Comcrc8 == AT24CXX_ReadOneByte(LORA_COM_MODE_VERIFY_ADDR))
+    if (Comcrc8 == Param_Read(LORA_COM_MODE_VERIFY_ADDR))
     {
         return ComTemp;
     }
@@ -473,6 +646,30 @@ unsigned char LoRa_Config::Read_LoRa_Com_Mode(void)
     }
 }
 
+/*
+ @brief     : 保存LoRa按地址收发方式
+ @para      : LORA_ADDR_MODE_OFF or LORA_ADDR_MODE_ON
+ @return    : true or false
+ */
+bool LoRa_Config::Save_LoRa_Addr_Mode(unsigned char mode)
+{
+    return Param_Block_Write(LORA_ADDR_MODE_ADDR, &mode, LORA_ADDR_MODE_LEN, LORA_ADDR_MODE_VERIFY_ADDR);
+}
+
+/*
+ @brief     : 读取LoRa按地址收发方式
+ @para      : 无
+ @return    : 收发方式（没有设置过或数据损坏，按原来的透传方式）
+ */
+unsigned char LoRa_Config::Read_LoRa_Addr_Mode(void)
+{
+    unsigned char Mode;
+
+    if (!Param_Block_Read(LORA_ADDR_MODE_ADDR, &Mode, LORA_ADDR_MODE_LEN, LORA_ADDR_MODE_VERIFY_ADDR))
+        return LORA_ADDR_MODE_OFF;
+    return Mode;
+}
+
 bool LoRa_Config::Save_LoRa_Addr(unsigned char *addr)
 {
     unsigned char TempBuf[8];
@@ -482,13 +679,13 @@ bool LoRa_Config::Save_LoRa_Addr(unsigned char *addr)
     AddrCrc8 = GetCrc8(&addr[0], 8);
     for (unsigned char i = 0; i < 8; i++)
     {
-        AT24CXX_WriteOneByte(EP_LORA_ADDR_BASE_ADDR + i, addr[i]);
+        Param_Write(EP_LORA_ADDR_BASE_ADDR + i, addr[i]);
     }
-    AT24CXX_WriteOneByte(EP_LORA_ADDR_VERIFY_ADDR, AddrCrc8);
+    Param_Write(EP_LORA_ADDR_VERIFY_ADDR, AddrCrc8);
 
     for (unsigned char i = 0; i < 8; i++)
     {
-        TempBuf[i] = AT24CXX_ReadOneByte(EP_LORA_ADDR_BASE_ADDR + i);
+        TempBuf[i] = Param_Read(EP_LORA_ADDR_BASE_ADDR + i);
     }
     AddrTempCrc8 = GetCrc8(&TempBuf[0], 8);
 
@@ -513,10 +710,10 @@ bool LoRa_Config::Read_LoRa_Addr(unsigned char *addr)
 
     for (unsigned char i = 0; i < 8; i++)
     {
-        TempBuf[i] = AT24CXX_ReadOneByte(EP_LORA_ADDR_BASE_ADDR + i);
+        TempBuf[i] = Param_Read(EP_LORA_ADDR_BASE_ADDR + i);
     }
     AddrCrc8 = GetCrc8(&TempBuf[0], 8);
-    AddrTempCrc8 = AT24CXX_ReadOneByte(EP_LORA_ADDR_VERIFY_ADDR);
+    AddrTempCrc8 = Param_Read(EP_LORA_ADDR_VERIFY_ADDR);
 
     if (AddrCrc8 != AddrTempCrc8)
         return false;
@@ -531,27 +728,27 @@ bool LoRa_Config::Read_LoRa_Addr(unsigned char *addr)
 
 void LoRa_Config::Save_LoRa_Addr_Flag(void)
 {
-    if (AT24CXX_ReadOneByte(EP_LORA_ADDR_SAVED_FLAG_ADDR) == 0X55)
+    if (Param_Read(EP_LORA_ADDR_SAVED_FLAG_ADDR) == 0X55)
         return;
 
     EEPROM_Write_Enable();
-    AT24CXX_WriteOneByte(EP_LORA_ADDR_SAVED_FLAG_ADDR, 0x55);
+    Param_Write(EP_LORA_ADDR_SAVED_FLAG_ADDR, 0x55);
     EEPROM_Write_Disable();
 }
 
 void LoRa_Config::Clear_LoRa_Addr_Flag(void)
 {
-    if (AT24CXX_ReadOneByte(EP_LORA_ADDR_SAVED_FLAG_ADDR) == 0x00)
+    if (Param_Read(EP_LORA_ADDR_SAVED_FLAG_ADDR) == 0x00)
         return;
 
     EEPROM_Write_Enable();
-    AT24CXX_WriteOneByte(EP_LORA_ADDR_SAVED_FLAG_ADDR, 0x00);
+    Param_Write(EP_LORA_ADDR_SAVED_FLAG_ADDR, 0x00);
     EEPROM_Write_Disable();
 }
 
 bool LoRa_Config::Verify_LoRa_Addr_Flag(void)
 {
-    if (AT24CXX_ReadOneByte(EP_LORA_ADDR_SAVED_FLAG_ADDR) == 0x55)
+    if (Param_Read(EP_LORA_ADDR_SAVED_FLAG_ADDR) == 0x55)
         return true;
     else
         return false;
@@ -565,8 +762,8 @@ bool LoRa_Config::Verify_LoRa_Addr_Flag(void)
 void Soft_Hard_Vertion::Save_Software_version(unsigned char number_high, unsigned char number_low)
 {
     EEPROM_Write_Enable();
-    AT24CXX_WriteOneByte(SOFT_HARD_VERSION_BASE_ADDR, number_high);
-    AT24CXX_WriteOneByte(SOFT_HARD_VERSION_BASE_ADDR + 1,  number_low);
+    Param_Write(SOFT_HARD_VERSION_BASE_ADDR, number_high);
+    Param_Write(SOFT_HARD_VERSION_BASE_ADDR + 1,  number_low);
     EEPROM_Write_Disable();
 }
 
@@ -578,8 +775,8 @@ void Soft_Hard_Vertion::Save_Software_version(unsigned char number_high, unsigne
 void Soft_Hard_Vertion::Save_hardware_version(unsigned char number_high, unsigned char number_low)
 {
     EEPROM_Write_Enable();
-    AT24CXX_WriteOneByte(SOFT_HARD_VERSION_BASE_ADDR + 2, number_high);
-    AT24CXX_WriteOneByte(SOFT_HARD_VERSION_END_ADDR, number_low);
+    Param_Write(SOFT_HARD_VERSION_BASE_ADDR + 2, number_high);
+    Param_Write(SOFT_HARD_VERSION_END_ADDR, number_low);
     EEPROM_Write_Disable();
 }
 
@@ -590,14 +787,14 @@ void Soft_Hard_Vertion::Save_hardware_version(unsigned char number_high, unsigne
  */
 bool Roll_Operations::Set_Route_Save_Flag(void)
 {
-    if (AT24CXX_ReadOneByte(ROUTE_FLAG_ADDR) == 0x55)
+    if (Param_Read(ROUTE_FLAG_ADDR) == 0x55)
         return true;
 
     EEPROM_Write_Enable();
-    AT24CXX_WriteOneByte(ROUTE_FLAG_ADDR, 0x55);
+    Param_Write(ROUTE_FLAG_ADDR, 0x55);
     EEPROM_Write_Disable();
 
-    if (AT24CXX_ReadOneByte(ROUTE_FLAG_ADDR) != 0x55)
+    if (Param_Read(ROUTE_FLAG_ADDR) != 0x55)
         return false;
     else
         return true;
@@ -610,7 +807,7 @@ bool Roll_Operations::Set_Route_Save_Flag(void)
  */
 bool Roll_Operations::Read_Route_Save_Flag(void)
 {
-    if (AT24CXX_ReadOneByte(ROUTE_FLAG_ADDR) == 0x55)
+    if (Param_Read(ROUTE_FLAG_ADDR) == 0x55)
         return true;
     else   
         return false;
@@ -623,14 +820,14 @@ bool Roll_Operations::Read_Route_Save_Flag(void)
  */
 bool Roll_Operations::Clear_Route_Save_Flag(void)
 {    
-    if (AT24CXX_ReadOneByte(ROUTE_FLAG_ADDR) == 0x00)
+    if (Param_Read(ROUTE_FLAG_ADDR) == 0x00)
         return true;
 
     EEPROM_Write_Enable();
-    AT24CXX_WriteOneByte(ROUTE_FLAG_ADDR, 0x00);
+    Param_Write(ROUTE_FLAG_ADDR, 0x00);
     EEPROM_Write_Disable();
 
-    if (AT24CXX_ReadOneByte(ROUTE_FLAG_ADDR) == 0x00)
+    if (Param_Read(ROUTE_FLAG_ADDR) == 0x00)
         return true;
     else
         return false;
@@ -656,20 +853,20 @@ bool Roll_Operations::Save_Rolling_Time(unsigned int time)
     if (time < 15 || time > 480) return false;
 
     /*如果本次要保存的数据与已经保存的数据相同，为了维护储存器，不再重复保存*/
-    if (TimeBuffer[0] == AT24CXX_ReadOneByte(ROLL_TIME_HIGH_ADDR) && TimeBuffer[1] == AT24CXX_ReadOneByte(ROLL_TIME_LOW_ADDR))
+    if (TimeBuffer[0] == Param_Read(ROLL_TIME_HIGH_ADDR) && TimeBuffer[1] == Param_Read(ROLL_TIME_LOW_ADDR))
         return true;
 
     EEPROM_Write_Enable();
-    AT24CXX_WriteOneByte(ROLL_TIME_HIGH_ADDR, TimeBuffer[0]);
-    AT24CXX_WriteOneByte(ROLL_TIME_LOW_ADDR, TimeBuffer[1]);
+    Param_Write(ROLL_TIME_HIGH_ADDR, TimeBuffer[0]);
+    Param_Write(ROLL_TIME_LOW_ADDR, TimeBuffer[1]);
 
     CRC8 = GetCrc8(TimeBuffer, sizeof(TimeBuffer));
 
-    AT24CXX_WriteOneByte(ROLL_TIME_VERIFY_ADDR, CRC8);
+    Param_Write(ROLL_TIME_VERIFY_ADDR, CRC8);
     EEPROM_Write_Disable();
 
-    TimeBuffer[0] = AT24CXX_ReadOneByte(ROLL_TIME_HIGH_ADDR);
-    TimeBuffer[1] = AT24CXX_ReadOneByte(ROLL_TIME_LOW_ADDR);
+    TimeBuffer[0] = Param_Read(ROLL_TIME_HIGH_ADDR);
+    TimeBuffer[1] = Param_Read(ROLL_TIME_LOW_ADDR);
     CRC8_Temp = GetCrc8(TimeBuffer, sizeof(TimeBuffer));
 
     if (CRC8_Temp == CRC8)
@@ -688,10 +885,10 @@ unsigned int Roll_Operations::Read_Rolling_Time(void)
     unsigned char TimeBuffer[2];
     unsigned char CRC8, CRC8_Temp;
 
-    TimeBuffer[0] = AT24CXX_ReadOneByte(ROLL_TIME_HIGH_ADDR);
-    TimeBuffer[1] = AT24CXX_ReadOneByte(ROLL_TIME_LOW_ADDR);
+    TimeBuffer[0] = Param_Read(ROLL_TIME_HIGH_ADDR);
+    TimeBuffer[1] = Param_Read(ROLL_TIME_LOW_ADDR);
 
-    CRC8 = AT24CXX_ReadOneByte(ROLL_TIME_VERIFY_ADDR);
+    CRC8 = Param_Read(ROLL_TIME_VERIFY_ADDR);
     CRC8_Temp = GetCrc8(TimeBuffer, sizeof(TimeBuffer));
 
     if (CRC8 == CRC8_Temp)
@@ -910,10 +1107,10 @@ bool Roll_Operations::Clear_All_Opening_Value(void)
     EEPROM_Write_Enable();
     for (unsigned char i = EP_MOTOR_LAST_OPENING_ADDR; i <= EP_MOTOR_REALTIME_OPENING_CRC_ADDR; i++)
     {
-        if (AT24CXX_ReadOneByte(i) != 0x00) //原来的开度值不是0，才去清零，避免重复擦除EEPROM
+        if (Param_Read(i) != 0x00) //原来的开度值不是0，才去清零，避免重复擦除EEPROM
         {
-            AT24CXX_WriteOneByte(i, 0x00);
-            if (AT24CXX_ReadOneByte(i) != 0x00)
+            Param_Write(i, 0x00);
+            if (Param_Read(i) != 0x00)
             {
                 EEPROM_Write_Disable();
                 return false;
@@ -937,7 +1134,7 @@ bool Roll_Operations::Save_Group_Number(unsigned char *group_num)
     /*如果本次要保存的数据与已经保存的数据相同，为了维护储存器，不再重复保存*/
     for (unsigned char i = 0; i < 5; i++)
     {
-        if (group_num[i] != AT24CXX_ReadOneByte(GROUP_NUMBER_BASE_ADDR + i))
+        if (group_num[i] != Param_Read(GROUP_NUMBER_BASE_ADDR + i))
         {
             SaveGroupFlag = true;
             break;
@@ -947,26 +1144,26 @@ bool Roll_Operations::Save_Group_Number(unsigned char *group_num)
 
     EEPROM_Write_Enable();
     for (unsigned char i = 0; i < 5; i++)
-        AT24CXX_WriteOneByte(GROUP_NUMBER_BASE_ADDR + i, group_num[i]);
+        Param_Write(GROUP_NUMBER_BASE_ADDR + i, group_num[i]);
 
     unsigned char CRC8 = GetCrc8(&group_num[0], 5);
-    AT24CXX_WriteOneByte(GROUP_NUMBER_VERIFY_ADDR, CRC8);
+    Param_Write(GROUP_NUMBER_VERIFY_ADDR, CRC8);
 
     /*判断是否保存数据成功*/
     for (unsigned char i = 0; i < 5; i++)
     {
-        if (AT24CXX_ReadOneByte(GROUP_NUMBER_BASE_ADDR + i) != group_num[i])
+        if (Param_Read(GROUP_NUMBER_BASE_ADDR + i) != group_num[i])
         {
             EEPROM_Write_Disable();
              return false;
         }
     }
 
-    if (AT24CXX_ReadOneByte(GROUP_NUMBER_VERIFY_ADDR) == CRC8)
+    if (Param_Read(GROUP_NUMBER_VERIFY_ADDR) == CRC8)
     {
-        if (AT24CXX_ReadOneByte(GROUP_NUMBER_FLAG_ADDR) != 0x55)
+        if (Param_Read(GROUP_NUMBER_FLAG_ADDR) != 0x55)
         {
-            AT24CXX_WriteOneByte(GROUP_NUMBER_FLAG_ADDR, 0x55); //保存数据成功，置标志位
+            Param_Write(GROUP_NUMBER_FLAG_ADDR, 0x55); //保存数据成功，置标志位
         }
         EEPROM_Write_Disable();
         return true;
@@ -988,10 +1185,10 @@ bool Roll_Operations::Read_Group_Number(unsigned char *group_num)
     unsigned char GroupNumber[5];
     unsigned char CRC8;
     for (unsigned char i = 0; i < 5; i++)
-        GroupNumber[i] = AT24CXX_ReadOneByte(GROUP_NUMBER_BASE_ADDR + i);
+        GroupNumber[i] = Param_Read(GROUP_NUMBER_BASE_ADDR + i);
 
     CRC8 = GetCrc8(&GroupNumber[0], 5);
-    if (CRC8 != AT24CXX_ReadOneByte(GROUP_NUMBER_VERIFY_ADDR))
+    if (CRC8 != Param_Read(GROUP_NUMBER_VERIFY_ADDR))
         return false;
     else
     {
@@ -1011,10 +1208,10 @@ bool Roll_Operations::Check_Group_Number(void)
     unsigned char GroupTemp[5]; 
 
     for (unsigned char i = 0; i < 5; i++)
-        GroupTemp[i] =AT24CXX_ReadOneByte(GROUP_NUMBER_BASE_ADDR + i);
+        GroupTemp[i] =Param_Read(GROUP_NUMBER_BASE_ADDR + i);
 
     unsigned char VerifyCRC8_Temp = GetCrc8(&GroupTemp[0], 5);
-    if (VerifyCRC8_Temp == AT24CXX_ReadOneByte(GROUP_NUMBER_VERIFY_ADDR))
+    if (VerifyCRC8_Temp == Param_Read(GROUP_NUMBER_VERIFY_ADDR))
         return true;
     else
         return false;
@@ -1028,7 +1225,7 @@ bool Roll_Operations::Check_Group_Number(void)
 bool Roll_Operations::Verify_Group_Number_Flag(void)
 {
     bool BoolValue;
-    AT24CXX_ReadOneByte(GROUP_NUMBER_FLAG_ADDR) == 0X55 ? BoolValue = true : BoolValue = false;
+    Param_Read(GROUP_NUMBER_FLAG_ADDR) == 0X55 ? BoolValue = true : BoolValue = false;
     return BoolValue;
 }
 
@@ -1042,23 +1239,241 @@ bool Roll_Operations::Clear_Group_Number(void)
     EEPROM_Write_Enable();
     for (unsigned char i = 0; i < 5; i++)
     {
-        if (AT24CXX_ReadOneByte(GROUP_NUMBER_BASE_ADDR + i) != 0x00)
+        if (Param_Read(GROUP_NUMBER_BASE_ADDR + i) != 0x00)
         {
-            AT24CXX_WriteOneByte(GROUP_NUMBER_BASE_ADDR + i, 0x00);
-            if (AT24CXX_ReadOneByte(GROUP_NUMBER_BASE_ADDR + i) != 0x00)
+            Param_Write(GROUP_NUMBER_BASE_ADDR + i, 0x00);
+            if (Param_Read(GROUP_NUMBER_BASE_ADDR + i) != 0x00)
             {
                 EEPROM_Write_Disable();
                 return false;
             }
         }
     }
-    if (AT24CXX_ReadOneByte(GROUP_NUMBER_FLAG_ADDR) != 0x00)    //保护EP，防止重复擦写。
-        AT24CXX_WriteOneByte(GROUP_NUMBER_FLAG_ADDR, 0x00); //同时清除保存组号标志位
+    if (Param_Read(GROUP_NUMBER_FLAG_ADDR) != 0x00)    //保护EP，防止重复擦写。
+        Param_Write(GROUP_NUMBER_FLAG_ADDR, 0x00); //同时清除保存组号标志位
+
+    EEPROM_Write_Disable();
+    return true;
+}
+
+/*
+ @brief     : 保存工作组位图。只写入有变化的字节，同时保存组数和CRC8
+ @para      : 工作组位图（32byte，第n位为1表示属于工作组n）
+ @return    : true or false
+ */
+bool Roll_Operations::Save_Group_Bitmap(const unsigned char *bitmap)
+{
+    unsigned char Temp[GROUP_BITMAP_LEN + 1];
+    unsigned char Num = 0;
+    unsigned char CRC8;
+
+    for (unsigned char i = 0; i < GROUP_BITMAP_LEN; i++)
+    {
+        Temp[i] = bitmap[i];
+        for (unsigned char Bit = bitmap[i]; Bit; Bit &= Bit - 1)
+            Num++;
+    }
+    Temp[GROUP_BITMAP_LEN] = Num;
+    CRC8 = GetCrc8(Temp, sizeof(Temp));
+
+    EEPROM_Write_Enable();
+    for (unsigned char i = 0; i <= GROUP_BITMAP_LEN; i++)
+    {
+        /*如果本次要保存的数据与已经保存的数据相同，为了维护储存器，不再重复保存*/
+        if (Param_Read(GROUP_BITMAP_BASE_ADDR + i) == Temp[i])
+            continue;
+
+        Param_Write(GROUP_BITMAP_BASE_ADDR + i, Temp[i]);
+        if (Param_Read(GROUP_BITMAP_BASE_ADDR + i) != Temp[i])
+        {
+            EEPROM_Write_Disable();
+            return false;
+        }
+    }
+
+    if (Param_Read(GROUP_BITMAP_VERIFY_ADDR) != CRC8)
+        Param_Write(GROUP_BITMAP_VERIFY_ADDR, CRC8);
+
+    if (Param_Read(GROUP_BITMAP_VERIFY_ADDR) == CRC8)
+    {
+        if (Param_Read(GROUP_BITMAP_FLAG_ADDR) != 0x55)
+            Param_Write(GROUP_BITMAP_FLAG_ADDR, 0x55); //保存数据成功，置标志位
+        EEPROM_Write_Disable();
+        return true;
+    }
+    else
+    {
+        EEPROM_Write_Disable();
+        return false;
+    }
+}
+
+/*
+ @brief     : 读取工作组位图
+ @para      : 工作组位图（array 32byte）
+ @return    : true or false
+ */
+bool Roll_Operations::Read_Group_Bitmap(unsigned char *bitmap)
+{
+    if (!Check_Group_Bitmap())
+        return false;
+
+    for (unsigned char i = 0; i < GROUP_BITMAP_LEN; i++)
+        bitmap[i] = Param_Read(GROUP_BITMAP_BASE_ADDR + i);
+    return true;
+}
+
+/*
+ @brief     : 验证保存的工作组位图是否损坏
+ @para      : None
+ @return    : true or false
+ */
+bool Roll_Operations::Check_Group_Bitmap(void)
+{
+    unsigned char Temp[GROUP_BITMAP_LEN + 1];
+
+    for (unsigned char i = 0; i <= GROUP_BITMAP_LEN; i++)
+        Temp[i] = Param_Read(GROUP_BITMAP_BASE_ADDR + i);
+
+    if (GetCrc8(Temp, sizeof(Temp)) == Param_Read(GROUP_BITMAP_VERIFY_ADDR))
+        return true;
+    else
+        return false;
+}
+
+/*
+ @brief     : 验证是否已经保存过工作组位图
+ @para      : None
+ @return    : true or false
+ */
+bool Roll_Operations::Verify_Group_Bitmap_Flag(void)
+{
+    if (Param_Read(GROUP_BITMAP_FLAG_ADDR) == 0x55)
+        return true;
+    else
+        return false;
+}
+
+/*
+ @brief     : 按保存的5个工作组号重新生成工作组位图。用于旧版本升级、A012按组号列表设置工作组，
+              以及位图自检失败后的恢复
+ @para      : None
+ @return    : true or false
+ */
+bool Roll_Operations::Rebuild_Group_Bitmap(void)
+{
+    unsigned char GroupNumber[5];
+    unsigned char Bitmap[GROUP_BITMAP_LEN] = {0};
+
+    if (!Read_Group_Number(GroupNumber))
+        return false;
+
+    for (unsigned char i = 0; i < 5; i++)
+    {
+        /*0x00是未定义的组号，0x55表示所有工作组，都不是真正的组号*/
+        if (GroupNumber[i] == 0x00 || GroupNumber[i] == 0x55)
+            continue;
+        Bitmap[GroupNumber[i] >> 3] |= (1 << (GroupNumber[i] & 0x07));
+    }
+    return Save_Group_Bitmap(Bitmap);
+}
+
+/*
+ @brief     : 按工作组位图重新生成原来的5个工作组号（位图中最小的5个组号），用于上报
+ @para      : 无
+ @return    : true or false
+ */
+bool Roll_Operations::Rebuild_Group_Number(void)
+{
+    unsigned char Bitmap[GROUP_BITMAP_LEN];
+    unsigned char GroupNumber[5] = {0};
+    unsigned char GroupNum = 0;
+
+    if (!Read_Group_Bitmap(Bitmap))
+        return false;
+
+    for (unsigned int Group = 1; Group < GROUP_BITMAP_LEN * 8 && GroupNum < 5; Group++)
+    {
+        if (Bitmap[Group >> 3] & (1 << (Group & 0x07)))
+            GroupNumber[GroupNum++] = Group;
+    }
+    return Save_Group_Number(GroupNumber);
+}
+
+/*
+ @brief     : 保存一个定时卷膜时间段。每个时间段单独校验，只写入有变化的字节
+ @para      : 1.时间段下标（0 - SCHEDULE_NUM-1）
+              2.时间段数据（SCHEDULE_DATA_LEN byte）
+ @return    : true or false
+ */
+bool Roll_Operations::Save_Schedule(unsigned char index, const unsigned char *schedule)
+{
+    if (index >= SCHEDULE_NUM)
+        return false;
+
+    unsigned char BaseAddr = SCHEDULE_BASE_ADDR + index * SCHEDULE_SLOT_LEN;
+    unsigned char Temp[SCHEDULE_SLOT_LEN];
+
+    for (unsigned char i = 0; i < SCHEDULE_DATA_LEN; i++)
+        Temp[i] = schedule[i];
+    Temp[SCHEDULE_DATA_LEN] = GetCrc8(Temp, SCHEDULE_DATA_LEN);
+
+    EEPROM_Write_Enable();
+    for (unsigned char i = 0; i < SCHEDULE_SLOT_LEN; i++)
+    {
+        /*如果本次要保存的数据与已经保存的数据相同，为了维护储存器，不再重复保存*/
+        if (Param_Read(BaseAddr + i) == Temp[i])
+            continue;
+
+        Param_Write(BaseAddr + i, Temp[i]);
+        if (Param_Read(BaseAddr + i) != Temp[i])
+        {
+            EEPROM_Write_Disable();
+            return false;
+        }
+    }
 
+    if (Param_Read(SCHEDULE_FLAG_ADDR) != 0x55)
+        Param_Write(SCHEDULE_FLAG_ADDR, 0x55); //保存数据成功，置标志位
     EEPROM_Write_Disable();
     return true;
 }
 
+/*
+ @brief     : 读取一个定时卷膜时间段
+ @para      : 1.时间段下标（0 - SCHEDULE_NUM-1）
+              2.时间段数据（array SCHEDULE_DATA_LEN byte）
+ @return    : true or false（没有保存过或数据损坏）
+ */
+bool Roll_Operations::Read_Schedule(unsigned char index, unsigned char *schedule)
+{
+    if (index >= SCHEDULE_NUM || !Verify_Schedule_Flag())
+        return false;
+
+    unsigned char BaseAddr = SCHEDULE_BASE_ADDR + index * SCHEDULE_SLOT_LEN;
+
+    for (unsigned char i = 0; i < SCHEDULE_DATA_LEN; i++)
+        schedule[i] = Param_Read(BaseAddr + i);
+
+    if (GetCrc8(schedule, SCHEDULE_DATA_LEN) == Param_Read(BaseAddr + SCHEDULE_DATA_LEN))
+        return true;
+    else
+        return false;
+}
+
+/*
+ @brief     : 验证是否已经保存过定时卷膜时间段
+ @para      : None
+ @return    : true or false
+ */
+bool Roll_Operations::Verify_Schedule_Flag(void)
+{
+    if (Param_Read(SCHEDULE_FLAG_ADDR) == 0x55)
+        return true;
+    else
+        return false;
+}
+
 /*
  @brief     : 保存区域号
  @para      : area number
@@ -1067,18 +1482,18 @@ bool Roll_Operations::Clear_Group_Number(void)
 bool Roll_Operations::Save_Area_Number(unsigned char area_num)
 {
     /*如果本次要保存的数据与已经保存的数据相同，为了维护储存器，不再重复保存*/
-    if (area_num == AT24CXX_ReadOneByte(AREA_ADDR))
+    if (area_num == Param_Read(AREA_ADDR))
         return true;
 
     EEPROM_Write_Enable();
-    AT24CXX_WriteOneByte(AREA_ADDR, area_num);
-    AT24CXX_WriteOneByte(AREA_VERIFY_ADDR, GetCrc8(&area_num, 1));
+    Param_Write(AREA_ADDR, area_num);
+    Param_Write(AREA_VERIFY_ADDR, GetCrc8(&area_num, 1));
     /*验证是否保存数据成功*/
-    if (AT24CXX_ReadOneByte(AREA_ADDR) == area_num)
+    if (Param_Read(AREA_ADDR) == area_num)
     {
-        if (AT24CXX_ReadOneByte(AREA_FLAG_ADDR) != 0x55)
+        if (Param_Read(AREA_FLAG_ADDR) != 0x55)
         {
-            AT24CXX_WriteOneByte(AREA_FLAG_ADDR, 0x55);
+            Param_Write(AREA_FLAG_ADDR, 0x55);
         }
         EEPROM_Write_Disable();
         return true;
@@ -1097,7 +1512,7 @@ bool Roll_Operations::Save_Area_Number(unsigned char area_num)
  */
 unsigned char Roll_Operations::Read_Area_Number(void)
 {
-    return (AT24CXX_ReadOneByte(AREA_ADDR));
+    return (Param_Read(AREA_ADDR));
 }
 
 /*
@@ -1107,10 +1522,10 @@ unsigned char Roll_Operations::Read_Area_Number(void)
 */
 bool Roll_Operations::Check_Area_Number(void)
 {
-    unsigned char AreaTemp = AT24CXX_ReadOneByte(AREA_ADDR);
+    unsigned char AreaTemp = Param_Read(AREA_ADDR);
     unsigned char VerifyTemp = GetCrc8(&AreaTemp, 1);
 
-    if (VerifyTemp == AT24CXX_ReadOneByte(AREA_VERIFY_ADDR))
+    if (VerifyTemp == Param_Read(AREA_VERIFY_ADDR))
         return true;
     else
         return false;
@@ -1124,7 +1539,7 @@ bool Roll_Operations::Check_Area_Number(void)
 bool Roll_Operations::Verify_Area_Number_Flag(void)
 {
     bool BoolValue;
-    AT24CXX_ReadOneByte(AREA_FLAG_ADDR) == 0x55 ? BoolValue = true : BoolValue = false;
+    Param_Read(AREA_FLAG_ADDR) == 0x55 ? BoolValue = true : BoolValue = false;
     return BoolValue;
 }
 
@@ -1135,12 +1550,12 @@ bool Roll_Operations::Verify_Area_Number_Flag(void)
  */
 bool Roll_Operations::Clear_Area_Number(void)
 {
-    if (AT24CXX_ReadOneByte(AREA_ADDR) == 0x00)
+    if (Param_Read(AREA_ADDR) == 0x00)
         return true;
 
     EEPROM_Write_Enable();
-    AT24CXX_WriteOneByte(AREA_ADDR, 0X00);  //默认区域号
-    if (AT24CXX_ReadOneByte(AREA_ADDR) != 0x00)
+    Param_Write(AREA_ADDR, 0X00);  //默认区域号
+    if (Param_Read(AREA_ADDR) != 0x00)
     {
         EEPROM_Write_Disable();
         return false;
@@ -1164,7 +1579,7 @@ bool Roll_Operations::Save_Roll_Work_Voltage_and_Report_Interval(unsigned char *
 
     for (unsigned char i = 0; i < 5; i++)
     {
-        if (threshold_value[i] != AT24CXX_ReadOneByte(ROLL_THRESHOLD_VALUE_BASE_ADDR + i))
+        if (threshold_value[i] != Param_Read(ROLL_THRESHOLD_VALUE_BASE_ADDR + i))
         {
             SaveFlag = true;
             break;
@@ -1176,15 +1591,15 @@ bool Roll_Operations::Save_Roll_Work_Voltage_and_Report_Interval(unsigned char *
     EEPROM_Write_Enable();
     for (unsigned char i = 0; i < 5; i++)
     {
-        AT24CXX_WriteOneByte(ROLL_THRESHOLD_VALUE_BASE_ADDR + i, threshold_value[i]);
-        if (AT24CXX_ReadOneByte(ROLL_THRESHOLD_VALUE_BASE_ADDR + i) != threshold_value[i])
+        Param_Write(ROLL_THRESHOLD_VALUE_BASE_ADDR + i, threshold_value[i]);
+        if (Param_Read(ROLL_THRESHOLD_VALUE_BASE_ADDR + i) != threshold_value[i])
         {
             EEPROM_Write_Disable();
             return false;
         }
     }
-    if (AT24CXX_ReadOneByte(SAVE_ROLL_THRESHOLD_FLAG_ADDR) != 0x55)
-        AT24CXX_WriteOneByte(SAVE_ROLL_THRESHOLD_FLAG_ADDR, 0x55);
+    if (Param_Read(SAVE_ROLL_THRESHOLD_FLAG_ADDR) != 0x55)
+        Param_Write(SAVE_ROLL_THRESHOLD_FLAG_ADDR, 0x55);
         
     EEPROM_Write_Disable();
     return true;
@@ -1197,10 +1612,10 @@ bool Roll_Operations::Save_Roll_Work_Voltage_and_Report_Interval(unsigned char *
  */
 unsigned char Roll_Operations::Read_Roll_Low_Voltage_Limit_Value(void)
 {
-    if (AT24CXX_ReadOneByte(SAVE_ROLL_THRESHOLD_FLAG_ADDR) != 0x55)
+    if (Param_Read(SAVE_ROLL_THRESHOLD_FLAG_ADDR) != 0x55)
         return 20;
 
-    unsigned char Low_Current_Value = AT24CXX_ReadOneByte(ROLL_THRESHOLD_VALUE_BASE_ADDR + 1);
+    unsigned char Low_Current_Value = Param_Read(ROLL_THRESHOLD_VALUE_BASE_ADDR + 1);
     
     if (Low_Current_Value < 1 || Low_Current_Value > 100)
         Low_Current_Value = 20;
@@ -1215,10 +1630,10 @@ unsigned char Roll_Operations::Read_Roll_Low_Voltage_Limit_Value(void)
 */
 unsigned char Roll_Operations::Read_Roll_High_Current_Limit_Value(void)
 {
-    if (AT24CXX_ReadOneByte(SAVE_ROLL_THRESHOLD_FLAG_ADDR) != 0x55)
+    if (Param_Read(SAVE_ROLL_THRESHOLD_FLAG_ADDR) != 0x55)
     return 20;  //默认2.0倍电流阈值
     
-    unsigned char HighCurrentValue = AT24CXX_ReadOneByte(ROLL_THRESHOLD_VALUE_BASE_ADDR + 3);
+    unsigned char HighCurrentValue = Param_Read(ROLL_THRESHOLD_VALUE_BASE_ADDR + 3);
 
     if (HighCurrentValue < 1 || HighCurrentValue > 100) //步进0.1倍，最大10倍
         HighCurrentValue = 20;  //如果设置的电流阈值小于0.1倍或大于10倍，默认2倍。
@@ -1234,13 +1649,132 @@ unsigned char Roll_Operations::Read_Roll_High_Current_Limit_Value(void)
  */
 unsigned char Roll_Operations::Read_Roll_Report_Status_Interval_Value(void)
 {
-    unsigned char interval = AT24CXX_ReadOneByte(ROLL_THRESHOLD_VALUE_BASE_ADDR + 4);
+    unsigned char interval = Param_Read(ROLL_THRESHOLD_VALUE_BASE_ADDR + 4);
     if (interval >= 1 && interval <= 10)
         return interval;
     else
         return 3;
 }
 
+/*
+ @brief     : 保存卷膜过程中E016实时电流上报间隔
+ @param     : 上报间隔（S），0表示不上报
+ @return    : true or false
+ */
+bool Roll_Operations::Save_Current_Report_Interval(unsigned char interval)
+{
+    unsigned char IntervalVerify = GetCrc8(&interval, 1);
+
+    /*如果本次要保存的数据与已经保存的数据相同，为了维护储存器，不再重复保存*/
+    if (interval == Param_Read(CURRENT_REPORT_INTERVAL_ADDR) && IntervalVerify == Param_Read(CURRENT_REPORT_INTERVAL_VERIFY_ADDR))
+        return true;
+
+    EEPROM_Write_Enable();
+    Param_Write(CURRENT_REPORT_INTERVAL_ADDR, interval);
+    Param_Write(CURRENT_REPORT_INTERVAL_VERIFY_ADDR, IntervalVerify);
+    EEPROM_Write_Disable();
+
+    if (Param_Read(CURRENT_REPORT_INTERVAL_ADDR) == interval && Param_Read(CURRENT_REPORT_INTERVAL_VERIFY_ADDR) == IntervalVerify)
+        return true;
+    else
+        return false;
+}
+
+/*
+ @brief     : 读取卷膜过程中E016实时电流上报间隔。没有设置过或数据损坏时不上报
+ @param     : 无
+ @return    : 上报间隔（S），0表示不上报
+ */
+unsigned char Roll_Operations::Read_Current_Report_Interval(void)
+{
+    unsigned char interval = Param_Read(CURRENT_REPORT_INTERVAL_ADDR);
+
+    if (GetCrc8(&interval, 1) == Param_Read(CURRENT_REPORT_INTERVAL_VERIFY_ADDR))
+        return interval;
+    else
+        return 0;
+}
+
+/*
+ @brief     : 保存状态上报方式和各项的上报死区
+ @para      : 上报方式1 + 开度死区1 + 电流死区1 + 电压死区1（array STATUS_REPORT_CONFIG_LEN byte）
+ @return    : true or false
+ */
+bool Roll_Operations::Save_Status_Report_Config(const unsigned char *config)
+{
+    return Param_Block_Write(STATUS_REPORT_CONFIG_BASE_ADDR, config, STATUS_REPORT_CONFIG_LEN, STATUS_REPORT_CONFIG_VERIFY_ADDR);
+}
+
+/*
+ @brief     : 读取状态上报方式和各项的上报死区
+ @para      : 上报方式1 + 开度死区1 + 电流死区1 + 电压死区1（array STATUS_REPORT_CONFIG_LEN byte）
+ @return    : true or false（没有设置过或数据损坏，服务器没有协商过，按完整的E014上报）
+ */
+bool Roll_Operations::Read_Status_Report_Config(unsigned char *config)
+{
+    return Param_Block_Read(STATUS_REPORT_CONFIG_BASE_ADDR, config, STATUS_REPORT_CONFIG_LEN, STATUS_REPORT_CONFIG_VERIFY_ADDR);
+}
+
+/*
+ @brief     : 保存群发指令的回执时隙
+ @para      : 时隙宽度1（10ms） + 时隙个数2 + 本机时隙号2（array REPLY_SLOT_CONFIG_LEN byte）
+ @return    : true or false
+ */
+bool Roll_Operations::Save_Reply_Slot_Config(const unsigned char *config)
+{
+    return Param_Block_Write(REPLY_SLOT_CONFIG_BASE_ADDR, config, REPLY_SLOT_CONFIG_LEN, REPLY_SLOT_CONFIG_VERIFY_ADDR);
+}
+
+/*
+ @brief     : 读取群发指令的回执时隙
+ @para      : 时隙宽度1（10ms） + 时隙个数2 + 本机时隙号2（array REPLY_SLOT_CONFIG_LEN byte）
+ @return    : true or false（没有设置过或数据损坏，群发指令仍然随机等待）
+ */
+bool Roll_Operations::Read_Reply_Slot_Config(unsigned char *config)
+{
+    return Param_Block_Read(REPLY_SLOT_CONFIG_BASE_ADDR, config, REPLY_SLOT_CONFIG_LEN, REPLY_SLOT_CONFIG_VERIFY_ADDR);
+}
+
+/*
+ @brief     : 保存上行确认方式
+ @para      : 确认方式1 + 最多重发次数1 + 第一次等待确认时间1（100ms）（array UPLINK_ACK_CONFIG_LEN byte）
+ @return    : true or false
+ */
+bool Roll_Operations::Save_Uplink_Ack_Config(const unsigned char *config)
+{
+    return Param_Block_Write(UPLINK_ACK_CONFIG_BASE_ADDR, config, UPLINK_ACK_CONFIG_LEN, UPLINK_ACK_CONFIG_VERIFY_ADDR);
+}
+
+/*
+ @brief     : 读取上行确认方式
+ @para      : 确认方式1 + 最多重发次数1 + 第一次等待确认时间1（100ms）（array UPLINK_ACK_CONFIG_LEN byte）
+ @return    : true or false（没有设置过或数据损坏，按原来的固定次数发送）
+ */
+bool Roll_Operations::Read_Uplink_Ack_Config(unsigned char *config)
+{
+    return Param_Block_Read(UPLINK_ACK_CONFIG_BASE_ADDR, config, UPLINK_ACK_CONFIG_LEN, UPLINK_ACK_CONFIG_VERIFY_ADDR);
+}
+
+/*
+ @brief     : 保存重复指令缓存时间窗口
+ @para      : 窗口时长（S），高字节在前（array CMD_CACHE_WINDOW_LEN byte）
+ @return    : true or false
+ */
+bool Roll_Operations::Save_Cmd_Cache_Window(const unsigned char *window)
+{
+    return Param_Block_Write(CMD_CACHE_WINDOW_BASE_ADDR, window, CMD_CACHE_WINDOW_LEN, CMD_CACHE_WINDOW_VERIFY_ADDR);
+}
+
+/*
+ @brief     : 读取重复指令缓存时间窗口
+ @para      : 窗口时长（S），高字节在前（array CMD_CACHE_WINDOW_LEN byte）
+ @return    : true or false（没有设置过或数据损坏，使用默认窗口）
+ */
+bool Roll_Operations::Read_Cmd_Cache_Window(unsigned char *window)
+{
+    return Param_Block_Read(CMD_CACHE_WINDOW_BASE_ADDR, window, CMD_CACHE_WINDOW_LEN, CMD_CACHE_WINDOW_VERIFY_ADDR);
+}
+
 /*
  @brief     : 保存卷膜电压值
  @param     : 电压值
@@ -1253,7 +1787,7 @@ bool Roll_Operations::Save_Roll_Voltage(unsigned int voltage)
     unsigned int VolTemp;
 
     /* 如果保存的电压值和要保存的电压值相差100mV以内，视为相等，不重复保存 */
-    VolTemp = ((AT24CXX_ReadOneByte(ROLL_VOLTAGE_HIGH_ADDR) << 8) | AT24CXX_ReadOneByte(ROLL_VOLTAGE_LOW_ADDR));
+    VolTemp = ((Param_Read(ROLL_VOLTAGE_HIGH_ADDR) << 8) | Param_Read(ROLL_VOLTAGE_LOW_ADDR));
     if (((voltage - VolTemp) <= 100) || ((VolTemp - voltage) <= 100))
         return true;
 
@@ -1263,17 +1797,17 @@ bool Roll_Operations::Save_Roll_Voltage(unsigned int voltage)
     VoltageVerify = GetCrc8(&VoltageBuffer[0], sizeof(VoltageBuffer));
 
     EEPROM_Write_Enable();
-    AT24CXX_WriteOneByte(ROLL_VOLTAGE_HIGH_ADDR, VoltageBuffer[0]);
-    AT24CXX_WriteOneByte(ROLL_VOLTAGE_LOW_ADDR,  VoltageBuffer[1]);
-    AT24CXX_WriteOneByte(ROLL_VOLTAGE_VERIFY_ADDR, VoltageVerify);    
+    Param_Write(ROLL_VOLTAGE_HIGH_ADDR, VoltageBuffer[0]);
+    Param_Write(ROLL_VOLTAGE_LOW_ADDR,  VoltageBuffer[1]);
+    Param_Write(ROLL_VOLTAGE_VERIFY_ADDR, VoltageVerify);    
     EEPROM_Write_Disable();
 
-    VoltageBuffer[0] = AT24CXX_ReadOneByte(ROLL_VOLTAGE_HIGH_ADDR);
-    VoltageBuffer[1] = AT24CXX_ReadOneByte(ROLL_VOLTAGE_LOW_ADDR);
+    VoltageBuffer[0] = Param_Read(ROLL_VOLTAGE_HIGH_ADDR);
+    VoltageBuffer[1] = Param_Read(ROLL_VOLTAGE_LOW_ADDR);
     VoltageVerifyTemp = GetCrc8(&VoltageBuffer[0], sizeof(VoltageBuffer));
 
 
-    if (AT24CXX_ReadOneByte(ROLL_VOLTAGE_VERIFY_ADDR) == VoltageVerifyTemp)
+    if (Param_Read(ROLL_VOLTAGE_VERIFY_ADDR) == VoltageVerifyTemp)
         return true;
     else
         return false;
@@ -1289,11 +1823,11 @@ bool Roll_Operations::Read_Roll_Voltage(unsigned int *voltage)
     unsigned char VoltageBuffer[2];
     unsigned char VoltageCRC8;
 
-    VoltageBuffer[0] = AT24CXX_ReadOneByte(ROLL_VOLTAGE_HIGH_ADDR);
-    VoltageBuffer[1] = AT24CXX_ReadOneByte(ROLL_VOLTAGE_LOW_ADDR);
+    VoltageBuffer[0] = Param_Read(ROLL_VOLTAGE_HIGH_ADDR);
+    VoltageBuffer[1] = Param_Read(ROLL_VOLTAGE_LOW_ADDR);
 
     VoltageCRC8 = GetCrc8(VoltageBuffer, sizeof(VoltageBuffer));
-    if (VoltageCRC8 != AT24CXX_ReadOneByte(ROLL_VOLTAGE_VERIFY_ADDR))
+    if (VoltageCRC8 != Param_Read(ROLL_VOLTAGE_VERIFY_ADDR))
         return false;
     else
     {
@@ -1319,7 +1853,7 @@ bool Roll_Operations::Save_Roll_Up_Current(unsigned int current)
     int CurrentDiffer;
 
     /*采集的电流值与保存的电流值在正负100mA之间，视为相等，不重复保存*/
-    CurrentTemp = ((AT24CXX_ReadOneByte(ROLL_UP_CURRENT_HIGH_ADDR) << 8) | AT24CXX_ReadOneByte(ROLL_UP_CURRENT_LOW_ADDR));
+    CurrentTemp = ((Param_Read(ROLL_UP_CURRENT_HIGH_ADDR) << 8) | Param_Read(ROLL_UP_CURRENT_LOW_ADDR));
     CurrentDiffer = (int)CurrentTemp - (int)current;
 
     if ((CurrentDiffer <= 100) && (CurrentDiffer>= 0))
@@ -1333,19 +1867,19 @@ bool Roll_Operations::Save_Roll_Up_Current(unsigned int current)
     CurrentVerify = GetCrc8(&CurrentBuffer[0], sizeof(CurrentBuffer));
 
     EEPROM_Write_Enable();
-    AT24CXX_WriteOneByte(ROLL_UP_CURRENT_HIGH_ADDR, CurrentBuffer[0]);
-    AT24CXX_WriteOneByte(ROLL_UP_CURRENT_LOW_ADDR,  CurrentBuffer[1]);
-    AT24CXX_WriteOneByte(ROLL_UP_CURRENT_VERIFY_ADDR, CurrentVerify);    
+    Param_Write(ROLL_UP_CURRENT_HIGH_ADDR, CurrentBuffer[0]);
+    Param_Write(ROLL_UP_CURRENT_LOW_ADDR,  CurrentBuffer[1]);
+    Param_Write(ROLL_UP_CURRENT_VERIFY_ADDR, CurrentVerify);    
 
-    CurrentBuffer[0] = AT24CXX_ReadOneByte(ROLL_UP_CURRENT_HIGH_ADDR);
-    CurrentBuffer[1] = AT24CXX_ReadOneByte(ROLL_UP_CURRENT_LOW_ADDR);
+    CurrentBuffer[0] = Param_Read(ROLL_UP_CURRENT_HIGH_ADDR);
+    CurrentBuffer[1] = Param_Read(ROLL_UP_CURRENT_LOW_ADDR);
     CurrentVerifyTemp = GetCrc8(&CurrentBuffer[0], sizeof(CurrentBuffer));
 
-    if (AT24CXX_ReadOneByte(ROLL_UP_CURRENT_VERIFY_ADDR) == CurrentVerifyTemp)
+    if (Param_Read(ROLL_UP_CURRENT_VERIFY_ADDR) == CurrentVerifyTemp)
     {
-        if (AT24CXX_ReadOneByte(SAVE_UP_CURRENT_FLAG_ADDR) != 0x55)
+        if (Param_Read(SAVE_UP_CURRENT_FLAG_ADDR) != 0x55)
         {
-            AT24CXX_WriteOneByte(SAVE_UP_CURRENT_FLAG_ADDR, 0x55);
+            Param_Write(SAVE_UP_CURRENT_FLAG_ADDR, 0x55);
         }
         EEPROM_Write_Disable();
         return true;
@@ -1367,11 +1901,11 @@ bool Roll_Operations::Read_Roll_Up_Current(unsigned int *current)
     unsigned char CurrentBuffer[2];
     unsigned char CurrentCRC8;
 
-    CurrentBuffer[0] = AT24CXX_ReadOneByte(ROLL_UP_CURRENT_HIGH_ADDR);
-    CurrentBuffer[1] = AT24CXX_ReadOneByte(ROLL_UP_CURRENT_LOW_ADDR);
+    CurrentBuffer[0] = Param_Read(ROLL_UP_CURRENT_HIGH_ADDR);
+    CurrentBuffer[1] = Param_Read(ROLL_UP_CURRENT_LOW_ADDR);
 
     CurrentCRC8 = GetCrc8(CurrentBuffer, sizeof(CurrentBuffer));
-    if (CurrentCRC8 != AT24CXX_ReadOneByte(ROLL_UP_CURRENT_VERIFY_ADDR))
+    if (CurrentCRC8 != Param_Read(ROLL_UP_CURRENT_VERIFY_ADDR))
         return false;
     else
     {
@@ -1395,7 +1929,7 @@ bool Roll_Operations::Save_Roll_Down_Current(unsigned int current)
     int CurrentDiffer;
 
     /*采集的电流值与保存的电流值在正负100mA之间，视为相等，不重复保存*/
-    CurrentTemp = ((AT24CXX_ReadOneByte(ROLL_DOWN_CURRENT_HIGH_ADDR) << 8) | AT24CXX_ReadOneByte(ROLL_DOWN_CURRENT_LOW_ADDR));
+    CurrentTemp = ((Param_Read(ROLL_DOWN_CURRENT_HIGH_ADDR) << 8) | Param_Read(ROLL_DOWN_CURRENT_LOW_ADDR));
     CurrentDiffer = (int)CurrentTemp - (int)current;
 
     if ((CurrentDiffer <= 100) && (CurrentDiffer>= 0))
@@ -1409,19 +1943,19 @@ bool Roll_Operations::Save_Roll_Down_Current(unsigned int current)
     CurrentVerify = GetCrc8(&CurrentBuffer[0], sizeof(CurrentBuffer));
 
     EEPROM_Write_Enable();
-    AT24CXX_WriteOneByte(ROLL_DOWN_CURRENT_HIGH_ADDR, CurrentBuffer[0]);
-    AT24CXX_WriteOneByte(ROLL_DOWN_CURRENT_LOW_ADDR,  CurrentBuffer[1]);
-    AT24CXX_WriteOneByte(ROLL_DOWN_CURRENT_VERIFY_ADDR, CurrentVerify);    
+    Param_Write(ROLL_DOWN_CURRENT_HIGH_ADDR, CurrentBuffer[0]);
+    Param_Write(ROLL_DOWN_CURRENT_LOW_ADDR,  CurrentBuffer[1]);
+    Param_Write(ROLL_DOWN_CURRENT_VERIFY_ADDR, CurrentVerify);    
 
-    CurrentBuffer[0] = AT24CXX_ReadOneByte(ROLL_DOWN_CURRENT_HIGH_ADDR);
-    CurrentBuffer[1] = AT24CXX_ReadOneByte(ROLL_DOWN_CURRENT_LOW_ADDR);
+    CurrentBuffer[0] = Param_Read(ROLL_DOWN_CURRENT_HIGH_ADDR);
+    CurrentBuffer[1] = Param_Read(ROLL_DOWN_CURRENT_LOW_ADDR);
     CurrentVerifyTemp = GetCrc8(&CurrentBuffer[0], sizeof(CurrentBuffer));
 
-    if (AT24CXX_ReadOneByte(ROLL_DOWN_CURRENT_VERIFY_ADDR) == CurrentVerifyTemp)
+    if (Param_Read(ROLL_DOWN_CURRENT_VERIFY_ADDR) == CurrentVerifyTemp)
     {
-        if (AT24CXX_ReadOneByte(SAVE_DOWN_CURRENT_FLAG_ADDR) != 0x55)
+        if (Param_Read(SAVE_DOWN_CURRENT_FLAG_ADDR) != 0x55)
         {
-            AT24CXX_WriteOneByte(SAVE_DOWN_CURRENT_FLAG_ADDR, 0x55);
+            Param_Write(SAVE_DOWN_CURRENT_FLAG_ADDR, 0x55);
         }
         EEPROM_Write_Disable();
         return true;
@@ -1443,11 +1977,11 @@ bool Roll_Operations::Read_Roll_Down_Current(unsigned int *current)
     unsigned char CurrentBuffer[2];
     unsigned char CurrentCRC8;
 
-    CurrentBuffer[0] = AT24CXX_ReadOneByte(ROLL_DOWN_CURRENT_HIGH_ADDR);
-    CurrentBuffer[1] = AT24CXX_ReadOneByte(ROLL_DOWN_CURRENT_LOW_ADDR);
+    CurrentBuffer[0] = Param_Read(ROLL_DOWN_CURRENT_HIGH_ADDR);
+    CurrentBuffer[1] = Param_Read(ROLL_DOWN_CURRENT_LOW_ADDR);
 
     CurrentCRC8 = GetCrc8(CurrentBuffer, sizeof(CurrentBuffer));
-    if (CurrentCRC8 != AT24CXX_ReadOneByte(ROLL_DOWN_CURRENT_VERIFY_ADDR))
+    if (CurrentCRC8 != Param_Read(ROLL_DOWN_CURRENT_VERIFY_ADDR))
         return false;
     else
     {
@@ -1467,8 +2001,8 @@ bool Roll_Operations::Verify_Current_Flag(void)
 {
     unsigned char UpFlag = 0, DownFlag = 0;
     bool BoolVal;
-    UpFlag = AT24CXX_ReadOneByte(SAVE_UP_CURRENT_FLAG_ADDR);
-    DownFlag = AT24CXX_ReadOneByte(SAVE_DOWN_CURRENT_FLAG_ADDR);
+    UpFlag = Param_Read(SAVE_UP_CURRENT_FLAG_ADDR);
+    DownFlag = Param_Read(SAVE_DOWN_CURRENT_FLAG_ADDR);
 
     UpFlag == 0x55 ? (DownFlag == 0x55 ? BoolVal = true : BoolVal = false) : BoolVal = false;
 
@@ -1482,12 +2016,12 @@ bool Roll_Operations::Verify_Current_Flag(void)
  */
 bool Roll_Operations::Clear_Current_Flag(void)
 {
-    if (AT24CXX_ReadOneByte(SAVE_UP_CURRENT_FLAG_ADDR) == 0x00 && AT24CXX_ReadOneByte(SAVE_DOWN_CURRENT_FLAG_ADDR) == 0x00)
+    if (Param_Read(SAVE_UP_CURRENT_FLAG_ADDR) == 0x00 && Param_Read(SAVE_DOWN_CURRENT_FLAG_ADDR) == 0x00)
         return true;
 
     EEPROM_Write_Enable();
-    AT24CXX_WriteOneByte(SAVE_UP_CURRENT_FLAG_ADDR, 0x00);
-    AT24CXX_WriteOneByte(SAVE_DOWN_CURRENT_FLAG_ADDR, 0x00);
+    Param_Write(SAVE_UP_CURRENT_FLAG_ADDR, 0x00);
+    Param_Write(SAVE_DOWN_CURRENT_FLAG_ADDR, 0x00);
     EEPROM_Write_Disable();
     return true;
 }
@@ -1503,24 +2037,24 @@ bool Roll_Operations::Current_Self_Check(void)
     unsigned char CurrentVerify, CurrentVerifyTemp;
 
     /*自检开棚电流值*/
-    if (AT24CXX_ReadOneByte(SAVE_UP_CURRENT_FLAG_ADDR) == 0x55)
+    if (Param_Read(SAVE_UP_CURRENT_FLAG_ADDR) == 0x55)
     {
-        CurrentBuffer[0] = AT24CXX_ReadOneByte(ROLL_UP_CURRENT_HIGH_ADDR);
-        CurrentBuffer[1] = AT24CXX_ReadOneByte(ROLL_UP_CURRENT_LOW_ADDR);    
+        CurrentBuffer[0] = Param_Read(ROLL_UP_CURRENT_HIGH_ADDR);
+        CurrentBuffer[1] = Param_Read(ROLL_UP_CURRENT_LOW_ADDR);    
 
         CurrentVerify = GetCrc8(CurrentBuffer, sizeof(CurrentBuffer));
-        CurrentVerifyTemp = AT24CXX_ReadOneByte(ROLL_UP_CURRENT_VERIFY_ADDR);
+        CurrentVerifyTemp = Param_Read(ROLL_UP_CURRENT_VERIFY_ADDR);
 
         if (CurrentVerify != CurrentVerifyTemp)  return false;
     }
     /*自检关棚电流值*/
-    if (AT24CXX_ReadOneByte(SAVE_DOWN_CURRENT_FLAG_ADDR) == 0x55)
+    if (Param_Read(SAVE_DOWN_CURRENT_FLAG_ADDR) == 0x55)
     {
-        CurrentBuffer[0] = AT24CXX_ReadOneByte(ROLL_DOWN_CURRENT_HIGH_ADDR);
-        CurrentBuffer[1] = AT24CXX_ReadOneByte(ROLL_DOWN_CURRENT_LOW_ADDR);    
+        CurrentBuffer[0] = Param_Read(ROLL_DOWN_CURRENT_HIGH_ADDR);
+        CurrentBuffer[1] = Param_Read(ROLL_DOWN_CURRENT_LOW_ADDR);    
 
         CurrentVerify = GetCrc8(CurrentBuffer, sizeof(CurrentBuffer));
-        CurrentVerifyTemp = AT24CXX_ReadOneByte(ROLL_DOWN_CURRENT_VERIFY_ADDR);
+        CurrentVerifyTemp = Param_Read(ROLL_DOWN_CURRENT_VERIFY_ADDR);
 
         if (CurrentVerify != CurrentVerifyTemp)  return false;
     }
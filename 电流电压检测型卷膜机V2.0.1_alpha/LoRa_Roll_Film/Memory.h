@@ -81,6 +81,64 @@
 #define EP_LORA_ADDR_VERIFY_ADDR                87
 #define EP_LORA_ADDR_SAVED_FLAG_ADDR            88
 
+/*卷膜机工作组位图（256个工作组，每位表示是否属于该组）保存地址*/
+#define GROUP_BITMAP_LEN                        32
+#define GROUP_BITMAP_BASE_ADDR                  89
+#define GROUP_BITMAP_END_ADDR                   120
+#define GROUP_BITMAP_NUM_ADDR                   121
+#define GROUP_BITMAP_VERIFY_ADDR                122
+#define GROUP_BITMAP_FLAG_ADDR                  123
+
+/*A019定时卷膜时间段表保存地址。每个时间段：执行方式1 + 开度1 + 开始时间4 + 结束时间4 + CRC8 1*/
+#define SCHEDULE_NUM                            8
+#define SCHEDULE_DATA_LEN                       10
+#define SCHEDULE_SLOT_LEN                       (SCHEDULE_DATA_LEN + 1)
+#define SCHEDULE_BASE_ADDR                      124
+#define SCHEDULE_END_ADDR                       211
+#define SCHEDULE_FLAG_ADDR                      212
+
+/*卷膜过程中E016实时电流上报间隔（S，0不上报）保存地址*/
+#define CURRENT_REPORT_INTERVAL_ADDR            213
+#define CURRENT_REPORT_INTERVAL_VERIFY_ADDR     214
+
+/*状态上报方式保存地址：上报方式1 + 开度死区1 + 电流死区1 + 电压死区1 + CRC8 1*/
+#define STATUS_REPORT_CONFIG_LEN                4
+#define STATUS_REPORT_CONFIG_BASE_ADDR          215
+#define STATUS_REPORT_CONFIG_END_ADDR           218
+#define STATUS_REPORT_CONFIG_VERIFY_ADDR        219
+
+/*群发指令回执时隙保存地址：时隙宽度1（10ms） + 时隙个数2 + 本机时隙号2（0xFFFF按SN码计算） + CRC8 1*/
+#define REPLY_SLOT_CONFIG_LEN                   5
+#define REPLY_SLOT_CONFIG_BASE_ADDR             220
+#define REPLY_SLOT_CONFIG_END_ADDR              224
+#define REPLY_SLOT_CONFIG_VERIFY_ADDR           225
+
+/*上行确认保存地址：确认方式1 + 最多重发次数1 + 第一次等待确认时间1（100ms） + CRC8 1*/
+#define UPLINK_ACK_CONFIG_LEN                   3
+#define UPLINK_ACK_CONFIG_BASE_ADDR             226
+#define UPLINK_ACK_CONFIG_END_ADDR              228
+#define UPLINK_ACK_CONFIG_VERIFY_ADDR           229
+
+/*重复指令缓存时间窗口保存地址：窗口时长2（S，高字节在前） + CRC8 1*/
+#define CMD_CACHE_WINDOW_LEN                    2
+#define CMD_CACHE_WINDOW_BASE_ADDR              230
+#define CMD_CACHE_WINDOW_END_ADDR               231
+#define CMD_CACHE_WINDOW_VERIFY_ADDR            232
+
+/*LoRa按地址收发方式保存地址：方式1 + CRC8 1*/
+#define LORA_ADDR_MODE_LEN                      1
+#define LORA_ADDR_MODE_ADDR                     233
+#define LORA_ADDR_MODE_VERIFY_ADDR              234
+
+/*RAM镜像覆盖的EEPROM参数区：从SN码标志位到LoRa按地址收发方式*/
+#define PARAM_MIRROR_BASE_ADDR                  SN_OPERATION_FLAG_ADDR
+#define PARAM_MIRROR_END_ADDR                   LORA_ADDR_MODE_VERIFY_ADDR
+#define PARAM_MIRROR_LEN                        (PARAM_MIRROR_END_ADDR - PARAM_MIRROR_BASE_ADDR + 1)
+#define PARAM_MIRROR_LOAD_TRY_NUM               3
+
+/*带CRC8校验的参数块的校验初始值。从0开始时没有写过的全0参数块校验码也是0，会被当成有效参数*/
+#define PARAM_BLOCK_CRC_SEED                    0x55
+
 /*使用芯片自带备份寄存器的宏定义地址*/
 /*上一次开度值保存地址（0 - 100）*/
 #define BKP_MOTOR_LAST_OPENING_ADDR             1
@@ -94,6 +152,12 @@
 #define BKP_MOTOR_REALTIME_OPENING_ADDR         5 
 /*实时开度值CRC8保存地址*/
 #define BKP_MOTOR_REALTIME_OPENING_CRC_ADDR     6    
+/*RTC漂移补偿：上一次校时的时间（高16位、低16位）*/
+#define BKP_RTC_BASE_TIME_HIGH_ADDR             7
+#define BKP_RTC_BASE_TIME_LOW_ADDR              8
+/*RTC漂移补偿值（ppb，高16位、低16位）*/
+#define BKP_RTC_DRIFT_HIGH_ADDR                 9
+#define BKP_RTC_DRIFT_LOW_ADDR                  10
 
 /*
  @brief     : 上拉该引脚，禁止EEPROM写操作
@@ -118,6 +182,27 @@ inline void EEPROM_Write_Enable(void)
 class EEPROM_Operations : protected AT24Cxx{
 public:
     void EEPROM_GPIO_Config(void);
+
+    bool Param_Mirror_Load(void);
+    bool Param_Mirror_Verify(void);
+    unsigned long Param_Mirror_Reload_Times(void) {return ParamMirrorReloadTimes;}
+    bool Param_Mirror_Valid(void) {return ParamMirrorValidFlag;}
+    unsigned long Param_Write_Times(void) {return ParamWriteTimes;}
+
+protected:
+    unsigned char Param_Read(unsigned int addr);
+    void Param_Write(unsigned int addr, unsigned char dat);
+    bool Param_Block_Write(unsigned int base_addr, const unsigned char *data, unsigned char len, unsigned int verify_addr);
+    bool Param_Block_Read(unsigned int base_addr, unsigned char *data, unsigned char len, unsigned int verify_addr);
+    static unsigned char Param_Block_Crc(const unsigned char *data, unsigned char len);
+
+private:
+    /*参数区的RAM镜像，所有派生类共用一份*/
+    static unsigned char ParamMirror[PARAM_MIRROR_LEN];
+    static unsigned char ParamMirrorCRC;         //镜像本身的CRC8，用来发现RAM被改写
+    static bool ParamMirrorValidFlag;            //镜像已经从EEPROM加载
+    static unsigned long ParamMirrorReloadTimes; //后台校验发现不一致而重新加载的次数
+    static unsigned long ParamWriteTimes;        //写参数的次数，用来判断缓存的参数是否需要重新读取
 };
 
 class SN_Operations : public EEPROM_Operations{
@@ -154,6 +239,9 @@ public:
     bool Verify_LoRa_Addr_Flag(void);
     bool Read_LoRa_Addr(unsigned char *addr);
     bool Save_LoRa_Addr(unsigned char *addr);
+
+    bool Save_LoRa_Addr_Mode(unsigned char mode);
+    unsigned char Read_LoRa_Addr_Mode(void);
 };
 
 class Soft_Hard_Vertion : public EEPROM_Operations{
@@ -185,6 +273,19 @@ public:
     bool Verify_Group_Number_Flag(void);
     bool Clear_Group_Number(void);
 
+    bool Save_Group_Bitmap(const unsigned char *bitmap);
+    bool Read_Group_Bitmap(unsigned char *bitmap);
+    bool Check_Group_Bitmap(void);
+    bool Verify_Group_Bitmap_Flag(void);
+    bool Rebuild_Group_Bitmap(void);
+    bool Rebuild_Group_Number(void);
+    unsigned char Read_Group_Bitmap_Num(void) {return Param_Read(GROUP_BITMAP_NUM_ADDR);}
+    bool Is_Group_Member(unsigned char group) {return (Param_Read(GROUP_BITMAP_BASE_ADDR + (group >> 3)) >> (group & 0x07)) & 0x01;}
+
+    bool Save_Schedule(unsigned char index, const unsigned char *schedule);
+    bool Read_Schedule(unsigned char index, unsigned char *schedule);
+    bool Verify_Schedule_Flag(void);
+
     bool Save_Area_Number(unsigned char area_num);
     unsigned char Read_Area_Number(void);
     bool Check_Area_Number(void);
@@ -196,6 +297,21 @@ public:
     unsigned char Read_Roll_High_Current_Limit_Value(void);
     unsigned char Read_Roll_Report_Status_Interval_Value(void);
 
+    bool Save_Current_Report_Interval(unsigned char interval);
+    unsigned char Read_Current_Report_Interval(void);
+
+    bool Save_Status_Report_Config(const unsigned char *config);
+    bool Read_Status_Report_Config(unsigned char *config);
+
+    bool Save_Reply_Slot_Config(const unsigned char *config);
+    bool Read_Reply_Slot_Config(unsigned char *config);
+
+    bool Save_Uplink_Ack_Config(const unsigned char *config);
+    bool Read_Uplink_Ack_Config(unsigned char *config);
+
+    bool Save_Cmd_Cache_Window(const unsigned char *window);
+    bool Read_Cmd_Cache_Window(unsigned char *window);
+
     bool Save_Roll_Voltage(unsigned int voltage);
     bool Read_Roll_Voltage(unsigned int *voltage);
 
@@ -32,6 +32,9 @@ volatile bool gForceRollWorkingFlag = false;    //正在强制卷膜标志位
 volatile unsigned int gRollingTime = 0;         //实时卷膜时间
 volatile bool gRollingTimeVarFlag = false;
 
+volatile bool gRetargetEnableFlag = false;      //开度卷膜过程中，允许直接修改目标开度
+volatile unsigned char gRetargetOpening = 0xFF; //卷膜过程中收到的新目标开度，0xFF表示没有
+
 volatile unsigned char gCurrentOverNum = 0;   //电流超阈值计数次数
 
 volatile unsigned int gLowCurrentTime = 0;    //电流过低计数时间
@@ -558,9 +561,29 @@ void Motor_Operations::Finish_Rolling(void)
   gResetRollWorkingFlag = false;
   gOpeningWorkingFlag = false;
   gForceRollWorkingFlag = false;
+  gRetargetEnableFlag = false;
   Start_Self_Check_Timing();
 }
 
+/*
+ @brief   : 超过指令规定的工作时长（A023），按强制停止处理并上报状态。
+            开度卷膜、强制开关棚、重置行程的每个卷膜循环里都要调用
+ @para    : 1.卷膜动作
+            2.实时开度，开度卷膜时保存
+ @return  : true：已经停止，调用者直接返回；false：没有超时
+ */
+bool Motor_Operations::Work_Time_Stop(Roll_Action act, unsigned char realtime_opening)
+{
+  if (WorkTimeLimit == 0 || millis() - WorkStartTime < (unsigned long)WorkTimeLimit * 1000) return false;
+
+  Serial.println("Reach work time limit, stop rolling... <Work_Time_Stop>");
+  WorkTimeLimit = 0;
+  gStopWorkFlag = true;
+  Force_Stop_Work(act, realtime_opening);
+  Message_Receipt.Working_Parameter_Receipt(true, 1);
+  return true;
+}
+
 /*
  @brief   : 强制结束电机卷膜。当从服务器接收到强制停止工作指令时执行该函数
  @para    : Open or Close
@@ -634,6 +657,9 @@ bool Motor_Operations::Verify_Reset_OK(unsigned char *current_opening, bool firs
   MyDelayMs(1000);
   iwdg_feed();
 
+  /*停稳期间可能在接收中断里收到了强制停止，不再通电，交给调用者的 Force_Stop_Work 处理*/
+  if (gStopWorkFlag) return false;
+
   if (is_first_stage)
   {
     if (first_A_direction_flag)
@@ -656,6 +682,7 @@ bool Motor_Operations::Verify_Reset_OK(unsigned char *current_opening, bool firs
 
   do{
       iwdg_feed();        
+      if (gStopWorkFlag) return false;
 
       if ((Current_Detection() < 100))
       {
@@ -681,6 +708,8 @@ bool Motor_Operations::Verify_Reset_OK(unsigned char *current_opening, bool firs
   MyDelayMs(1000);
   iwdg_feed();
 
+  if (gStopWorkFlag) return false;
+
   if (is_first_stage)
   {
     if (first_A_direction_flag)
@@ -703,6 +732,8 @@ bool Motor_Operations::Verify_Reset_OK(unsigned char *current_opening, bool firs
 
   do{
       iwdg_feed();
+      if (gStopWorkFlag) return false;
+
       if (is_first_stage)
       {
         if (first_A_direction_flag)
@@ -800,7 +831,7 @@ bool Motor_Operations::Trace_Opening(void)
 
           Roll_Operation.Save_Last_Opening_Value(ManualOpening);
           Roll_Operation.Save_Current_Opening_Value(ManualOpening);
-          Roll_Operation.Save_RealTime_Opening_Value(ManualOpening);
+          Save_RealTime_Opening(ManualOpening);
           Set_Motor_Status(MANUAL_ROLL_OK);
           Message_Receipt.Working_Parameter_Receipt(false, 1);
         }
@@ -864,20 +895,27 @@ bool Motor_Operations::Force_Open_or_Close(unsigned char opening_value)
       if (OpenFlag)
       {
         if (Detect_Motor_Limit(&RecentOpening, Open, Reset_Roll, 0, 0)) break;
+        if (Work_Time_Stop(Force_Open)) return true;
         if (Force_Stop_Work(Force_Open) == true) return true;
         if (Motor_Current_Status(CurrentThreshold, SavedCurrent, CurrentStatus) == true) return false;
       }
       else if (CloseFlag)
       {
         if (Detect_Motor_Limit(&RecentOpening, Close, Reset_Roll, 0, 0)) break;
+        if (Work_Time_Stop(Force_Close)) return true;
         if (Force_Stop_Work(Force_Close) == true) return true;
         if (Motor_Current_Status(CurrentThreshold, SavedCurrent, CurrentStatus) == true) return false;
       }
+      Report_Current_Stream();
+      Refresh_Telemetry();
       LoRa_Command_Analysis.Receive_LoRa_Cmd();
 
   }while (1);
 
-  if(Verify_Reset_OK(&RecentOpening, IsFirst_A_Direction, true))
+  bool VerifyOkFlag = Verify_Reset_OK(&RecentOpening, IsFirst_A_Direction, true);
+  if (Force_Stop_Work(OpenFlag ? Force_Open : Force_Close)) return true;
+
+  if (VerifyOkFlag)
   {
     Serial.println("Verify force roll OK...");
     Finish_Rolling();
@@ -907,7 +945,7 @@ bool Motor_Operations::Force_Open_or_Close(unsigned char opening_value)
 
   Roll_Operation.Save_Last_Opening_Value(RecentOpening); // Save current opening to the current path
   Roll_Operation.Save_Current_Opening_Value(RecentOpening);
-  Roll_Operation.Save_RealTime_Opening_Value(RecentOpening);
+  Save_RealTime_Opening(RecentOpening);
   Set_Motor_Status(ROLL_OK);
   Message_Receipt.Working_Parameter_Receipt(true, 2);
   gForceRollWorkingFlag = false;
@@ -1001,15 +1039,22 @@ bool Motor_Operations::Reset_Motor_Route(void)
         if (Detect_Motor_Overtime(Open)) return false;
         if (Motor_Current_Status(CurrentThreshold, SavedCurrent, CurrentStatus)) return false;
       }
+      if (Work_Time_Stop(Reset_Roll)) return true;
       if (Force_Stop_Work(Reset_Roll)) return true;
 
       Collect_Current(&CurrentCollectNum, &CurrentValue, &CurrentValueTemp, &CurrentCalibration);
 
+      Report_Current_Stream();
+
+      Refresh_Telemetry();
       LoRa_Command_Analysis.Receive_LoRa_Cmd();
 
   }while (1);
 
-  if(Verify_Reset_OK(&RecentOpening, IsFirst_A_Direction, true))
+  bool VerifyOkFlag = Verify_Reset_OK(&RecentOpening, IsFirst_A_Direction, true);
+  if (Force_Stop_Work(Reset_Roll)) return true;
+
+  if (VerifyOkFlag)
   {
     Serial.println("Verify reset OK...");
     Finish_Rolling();
@@ -1049,6 +1094,9 @@ bool Motor_Operations::Reset_Motor_Route(void)
     MyDelayMs(1000);
     iwdg_feed();
 
+    /*停稳期间可能在接收中断里收到了强制停止，不再通电*/
+    if (Force_Stop_Work(Reset_Roll)) return true;
+
     CurrentStatus = Motor_Current_Init(&CurrentThreshold, &SavedCurrent, Close);
   
     if (ResetFirstDIRFlag)
@@ -1074,11 +1122,15 @@ bool Motor_Operations::Reset_Motor_Route(void)
           if (Motor_Current_Status(CurrentThreshold, SavedCurrent, CurrentStatus) == true) return false;
         }
   
+        if (Work_Time_Stop(Reset_Roll)) return true;
         if (Force_Stop_Work(Reset_Roll)) return true;
 
         Calculate_Voltage(&VoltageCollectNum, &VoltageValue, &VoltageValueTemp, &VoltageCalibration);
         Collect_Current(&CurrentCollectNum, &CurrentValue, &CurrentValueTemp, &CurrentCalibration);
 
+        Report_Current_Stream();
+
+        Refresh_Telemetry();
         LoRa_Command_Analysis.Receive_LoRa_Cmd();
 
     }while (1); 
@@ -1087,7 +1139,10 @@ bool Motor_Operations::Reset_Motor_Route(void)
     if (gRollingTime % 2 != 0) gRollingTime += 1;
     unsigned int SavedRollingTime = gRollingTime;
 
-    if(Verify_Reset_OK(&RecentOpening, IsFirst_A_Direction, false))
+    VerifyOkFlag = Verify_Reset_OK(&RecentOpening, IsFirst_A_Direction, false);
+    if (Force_Stop_Work(Reset_Roll)) return true;
+
+    if (VerifyOkFlag)
     {
       Serial.println("Verify reset OK...");
       Finish_Rolling();
@@ -1135,7 +1190,7 @@ bool Motor_Operations::Reset_Motor_Route(void)
 
     Roll_Operation.Save_Last_Opening_Value(RecentOpening); // Save current opening to the current path
     Roll_Operation.Save_Current_Opening_Value(RecentOpening);
-    Roll_Operation.Save_RealTime_Opening_Value(RecentOpening);
+    Save_RealTime_Opening(RecentOpening);
     Roll_Operation.Set_Route_Save_Flag();
     Set_Motor_Status(RESET_ROLLOK);
     Message_Receipt.Working_Parameter_Receipt(true, 2);
@@ -1281,6 +1336,9 @@ bool Motor_Operations::Motor_Coiling(void)
     Stop_Self_Check_Timing(); //停止自检计时
     Start_Roll_Timing();  //开始卷膜计时
 
+    gRetargetOpening = 0xFF;
+    gRetargetEnableFlag = true;   //卷膜过程中收到新的开度，合并到本次卷膜
+
     do{
         iwdg_feed();
 
@@ -1294,6 +1352,8 @@ bool Motor_Operations::Motor_Coiling(void)
           }
         }
 
+        if (Work_Time_Stop(Opening_Roll, OpeningTemp)) return true;
+
         if (OpenFlag)
         {
           if(Detect_Motor_Limit(&RecentOpening, Open, Opening_Roll, RollOpening, RealRollTime)) break;
@@ -1325,7 +1385,7 @@ bool Motor_Operations::Motor_Coiling(void)
              *假如卷膜开度是50%，实际会出现卷膜完成后显示51%，这里过滤这1%
              */
             if (OpeningTemp % 10 >= 1) OpeningTemp -= 1;
-            Roll_Operation.Save_RealTime_Opening_Value(OpeningTemp);
+            Save_RealTime_Opening(OpeningTemp);
             Roll_Operation.Save_Last_Opening_Value(OpeningTemp);
           }
           else if (CloseFlag)
@@ -1333,7 +1393,7 @@ bool Motor_Operations::Motor_Coiling(void)
             iwdg_feed();
             OpeningTemp = LastOpening - (gRollingTime / (float)TotalOpeningTime * 100);
             if (OpeningTemp % 10 == 1) OpeningTemp -= 1;
-            Roll_Operation.Save_RealTime_Opening_Value(OpeningTemp);
+            Save_RealTime_Opening(OpeningTemp);
             Roll_Operation.Save_Last_Opening_Value(OpeningTemp); 
           }
 
@@ -1352,10 +1412,89 @@ bool Motor_Operations::Motor_Coiling(void)
           Message_Receipt.Working_Parameter_Receipt(false, 1);
         }
 
+        Report_Current_Stream();
+
+        Refresh_Telemetry();
         LoRa_Command_Analysis.Receive_LoRa_Cmd();
 
+        /*
+         *卷膜过程中收到了新的目标开度（Opening_Command 保存），合并到本次卷膜里，最后只回执一次ROLL_OK。
+         *与当前方向相同，直接延长或缩短本次卷膜时间；方向相反，先停住电机，从当前开度反向卷膜。
+         */
+        if (gRetargetOpening <= 100)
+        {
+          unsigned char NewOpening = gRetargetOpening;
+          unsigned char NowOpening;
+          unsigned char MovedOpening = gRollingTime / (float)TotalOpeningTime * 100;
+
+          gRetargetOpening = 0xFF;
+
+          /*按已经卷膜的时间算出当前开度*/
+          if (OpenFlag)
+            NowOpening = (LastOpening + MovedOpening > 100) ? 100 : (LastOpening + MovedOpening);
+          else
+            NowOpening = (MovedOpening > LastOpening) ? 0 : (LastOpening - MovedOpening);
+
+          Serial.print("Retarget opening <Motor_Coiling>: "); Serial.print(NowOpening);
+          Serial.print(" -> "); Serial.println(NewOpening);
+
+          if ((OpenFlag && NewOpening >= NowOpening) || (CloseFlag && NewOpening <= NowOpening))
+          {
+            /*同方向，保留电压动态调节已经修正的时间*/
+            int AdjustTime = (int)RealRollTime - (int)RollTimeTemp;
+
+            RecentOpening = NewOpening;
+            RollOpening = OpenFlag ? (RecentOpening - LastOpening) : (LastOpening - RecentOpening);
+            RollTimeTemp = RollOpening * 0.01 * TotalOpeningTime + 0.5;
+            RealRollTime = ((int)RollTimeTemp + AdjustTime < 0) ? 0 : (RollTimeTemp + AdjustTime);
+          }
+          else
+          {
+            /*反方向，当前开度作为新的起点*/
+            Direction_Selection(Stop);
+            Stop_Roll_Timing();
+            Save_RealTime_Opening(NowOpening);
+            Roll_Operation.Save_Last_Opening_Value(NowOpening);
+            MyDelayMs(RETARGET_REVERSE_DELAY);
+            iwdg_feed();
+
+            LastOpening = NowOpening;
+            RecentOpening = NewOpening;
+            OpeningTemp = NowOpening;
+            OpenFlag = !OpenFlag;
+            CloseFlag = !CloseFlag;
+
+            if (OpenFlag)
+            {
+              RollOpening = RecentOpening - LastOpening;
+              Current_Status = Motor_Current_Init(&Current_Threshold, &Saved_Current, Open);
+            }
+            else
+            {
+              RollOpening = LastOpening - RecentOpening;
+              Current_Status = Motor_Current_Init(&Current_Threshold, &Saved_Current, Close);
+            }
+            RealRollTime = RollOpening * 0.01 * TotalOpeningTime + 0.5;
+            RollTimeTemp = RealRollTime;
+
+            LastRollTime = 0;
+            IntervalLastTime = 0;
+            DyTimeNum = 0;
+            gLowCurrentTime = 0;
+            IsFirst_A_Direction = OpenFlag;
+
+            /*停稳期间可能在接收中断里收到了强制停止，不再通电，交给下一轮 Force_Stop_Work 处理*/
+            if (!gStopWorkFlag)
+              Motor_Operation.Direction_Selection(OpenFlag ? A : B);
+            Start_Roll_Timing();
+          }
+          Serial.print("Retarget need time <Motor_Coiling> = "); Serial.println(RealRollTime);
+        }
+
     }while (1);
 
+    gRetargetEnableFlag = false;
+
     if (OpenFlag)
     {
       Serial.print("Opening rolling time <Motor_Coiling>= "); Serial.println(gRollingTime);
@@ -1369,7 +1508,10 @@ bool Motor_Operations::Motor_Coiling(void)
 
     if (RecentOpening == 0 || RecentOpening == 100 || gAdjustOpeningFlag == true)
     {
-      if(Verify_Reset_OK(&RecentOpening, IsFirst_A_Direction, true))
+      bool VerifyOkFlag = Verify_Reset_OK(&RecentOpening, IsFirst_A_Direction, true);
+      if (Force_Stop_Work(Opening_Roll, RecentOpening)) return true;
+
+      if (VerifyOkFlag)
       {
         Serial.println("Verify opening roll OK...");
         Finish_Rolling();
@@ -1405,7 +1547,7 @@ bool Motor_Operations::Motor_Coiling(void)
     iwdg_feed();
 
     Roll_Operation.Save_Last_Opening_Value(RecentOpening);
-    Roll_Operation.Save_RealTime_Opening_Value(RecentOpening);
+    Save_RealTime_Opening(RecentOpening);
     Set_Motor_Status(ROLL_OK);
     Message_Receipt.Working_Parameter_Receipt(true, 2);
     LED_RUNNING;
@@ -1448,7 +1590,31 @@ unsigned int Motor_Operations::Current_Detection(void)
       }
     }
   }
-  return (CurrentValueBuff[Length / 2 + 1] * V_RESOLUTION * 20 + 0.5); //  voltage / 0.05
+  unsigned int Current = CurrentValueBuff[Length / 2 + 1] * V_RESOLUTION * 20 + 0.5; //  voltage / 0.05
+
+  /*卷膜过程中各处检测电流的采样顺便送进滤波，E016上报时直接用滤波后的值，不再单独采集*/
+  FilteredCurrent = (int)FilteredCurrent + (((int)Current - (int)FilteredCurrent) >> CURRENT_FILTER_SHIFT);
+
+  /*控制流程用来判断的电流就是回执上报的电流*/
+  Telemetry.Current = Current;
+  CurrentSampleTime = millis();
+  return Current;
+}
+
+/*
+ @brief   : 卷膜过程中按设置的间隔上报E016实时电流。在各个卷膜循环里调用
+ @param   : 无
+ @return  : 无
+ */
+void Motor_Operations::Report_Current_Stream(void)
+{
+  unsigned char Interval = Roll_Operation.Read_Current_Report_Interval();
+
+  if (Interval == 0 || gRollingTime == 0) return;
+  if (millis() - CurrentReportTime < Interval * 1000UL) return;
+
+  CurrentReportTime = millis();
+  Message_Receipt.Current_Stream_Receipt(FilteredCurrent, gRollingTime);
 }
 
 int Motor_Operations::Voltage_Detection(void)
@@ -1493,9 +1659,90 @@ int Motor_Operations::Voltage_Detection(void)
   }
 
   DifferValue = ((VoltageValueBuffCH1[Length / 2 + 1] * V_RESOLUTION * 11) - (VoltageValueBuffCH2[Length / 2 + 1] * V_RESOLUTION * 11));
+
+  Telemetry.Voltage = (DifferValue < 0) ? -DifferValue : DifferValue;
+  VoltageSampleTime = millis();
   return DifferValue;
 }
 
+/*
+ @brief   : 保存实时开度，同时更新遥测快照。快照里的开度按保存后读回的值，与回执原来读取的相同
+ @param   : 实时开度
+ @return  : 无
+ */
+void Motor_Operations::Save_RealTime_Opening(unsigned char opening)
+{
+  Roll_Operation.Save_RealTime_Opening_Value(opening);
+  Telemetry.Opening = Roll_Operation.Read_RealTime_Opening_Value();
+}
+
+/*
+ @brief   : 重新读取遥测快照中的参数部分（阈值、上报间隔、LoRa通信模式）
+ @param   : 无
+ @return  : 无
+ */
+void Motor_Operations::Refresh_Telemetry_Param(void)
+{
+  TelemetryParamTimes = Roll_Operation.Param_Write_Times();
+
+  Telemetry.LowVoltageLimit = Roll_Operation.Read_Roll_Low_Voltage_Limit_Value();
+  Telemetry.HighCurrentLimit = Roll_Operation.Read_Roll_High_Current_Limit_Value();
+  Telemetry.ReportInterval = Roll_Operation.Read_Roll_Report_Status_Interval_Value();
+  Telemetry.LoRaComMode = LoRa_Para_Config.Read_LoRa_Com_Mode();
+}
+
+/*
+ @brief   : 刷新遥测快照，在主循环和各个卷膜循环里调用。
+            卷膜时控制流程已经在频繁采集电流，只补采超过间隔没有采集的项；
+            电机状态变化时（开始、结束、异常）完整采集一次，记下停机后的电流、电压；
+            停机时不再采集ADC，回执上报最后一次采集的值
+ @param   : 无
+ @return  : 无
+ */
+void Motor_Operations::Refresh_Telemetry(void)
+{
+  unsigned long Now = millis();
+  unsigned char Status = Read_Motor_Status();
+  bool Changed = !TelemetryValidFlag || Status != TelemetryMotorStatus;
+  bool Rolling = Status == ROLLING || Status == RESET_ROLLING || gStartTraceOpeningFlag;
+
+  if (Changed || (Rolling && Now - CurrentSampleTime >= TELEMETRY_REFRESH_INTERVAL))
+    Current_Detection();
+
+  if (Changed || (Rolling && Now - VoltageSampleTime >= TELEMETRY_REFRESH_INTERVAL))
+    Voltage_Detection();
+
+  TelemetryMotorStatus = Status;
+
+  /*开度在手动卷膜、重置行程等处也会被清除，按间隔重新读取。开度在备份寄存器里，不需要采集ADC*/
+  if (Changed || Now - OpeningSampleTime >= TELEMETRY_REFRESH_INTERVAL)
+  {
+    Telemetry.Opening = Roll_Operation.Read_RealTime_Opening_Value();
+    OpeningSampleTime = Now;
+  }
+
+  if (!TelemetryValidFlag || TelemetryParamTimes != Roll_Operation.Param_Write_Times())
+    Refresh_Telemetry_Param();
+
+  TelemetryValidFlag = true;
+}
+
+/*
+ @brief   : 读取遥测快照。参数被修改过时先重新读取参数部分，不采集ADC；
+            开机后还没有刷新过时完整采集一次
+ @param   : 无
+ @return  : 遥测快照
+ */
+const Telemetry_Snapshot &Motor_Operations::Telemetry_Data(void)
+{
+  if (!TelemetryValidFlag)
+    Refresh_Telemetry();
+  else if (TelemetryParamTimes != Roll_Operation.Param_Write_Times())
+    Refresh_Telemetry_Param();
+
+  return Telemetry;
+}
+
 void Motor_Operations::Calculate_Voltage(unsigned int *voltage_collect_num, unsigned long *voltage_value, int *voltage_value_temp, unsigned int *voltage_calib)
 {
   if ((gRollingTime % CURRENT_COLLECTION_FREQ == 0) && (gRollingTimeVarFlag == true))
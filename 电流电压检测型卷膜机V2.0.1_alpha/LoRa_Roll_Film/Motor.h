@@ -43,6 +43,15 @@
 
 #define OPENING_THRESHOLD               10
 
+/*实时电流滤波系数：新采样占 1/2^CURRENT_FILTER_SHIFT*/
+#define CURRENT_FILTER_SHIFT            2
+
+/*卷膜时遥测快照中电流、电压的最长采样间隔（ms），控制流程没有采样时按这个间隔补采。停机时不补采*/
+#define TELEMETRY_REFRESH_INTERVAL      1000
+
+/*开度卷膜中途反向时，电机停稳的等待时间（ms）*/
+#define RETARGET_REVERSE_DELAY          500
+
 /*
   *当读取的电压压差为负数，说明电机往是开棚方向
   *当读取的电压压差的绝对值和保存的电压值相减
@@ -80,11 +89,28 @@ extern volatile bool gOpeningWorkingFlag;
 extern volatile bool gForceRollWorkingFlag;
 extern volatile unsigned int gRollingTime;   
 extern volatile bool gRollingTimeVarFlag;
+extern volatile bool gRetargetEnableFlag;
+extern volatile unsigned char gRetargetOpening;
 
 extern volatile bool gManualUpDetectFlag;  
 extern volatile bool gManualDownDetectFlag;  
 extern volatile bool gManualKeyExceptionFlag;
 
+/*
+ * 遥测快照。控制流程每次采集电流、电压和保存实时开度时同时更新，
+ * 卷膜时没有采样的项按固定间隔补采，电机状态变化时补采一次，停机时保留最后的值；
+ * 回执只复制快照，不再现场采集ADC、读参数。
+ */
+struct Telemetry_Snapshot{
+  unsigned char Opening;          //实时开度，0xFF表示数据损坏
+  unsigned int Current;           //最后一次采集的电流（mA）
+  unsigned int Voltage;           //最后一次采集的两路电压差的绝对值（mV）
+  unsigned char LowVoltageLimit;  //最小电压阈值
+  unsigned char HighCurrentLimit; //最大电流阈值
+  unsigned char ReportInterval;   //状态上报间隔系数
+  unsigned char LoRaComMode;      //LoRa通信模式
+};
+
 class Motor_Operations{
 public:
   void Motor_GPIO_Config(void);
@@ -102,13 +128,36 @@ public:
   bool Motor_Coiling(void);
   void Finish_Rolling(void);
   bool Force_Stop_Work(Roll_Action act, unsigned char realtime_opening);
+  bool Work_Time_Stop(Roll_Action act, unsigned char realtime_opening = 0);
 
   unsigned int Current_Detection(void);
+  unsigned int Filtered_Current(void) {return FilteredCurrent;}
+  void Report_Current_Stream(void);
   int Voltage_Detection(void);
 
+  void Refresh_Telemetry(void);
+  const Telemetry_Snapshot &Telemetry_Data(void);
+
   bool Trace_Opening(void);
 
+  void Set_Work_Time_Limit(unsigned int seconds) {WorkTimeLimit = seconds; WorkStartTime = millis();}
+
 private:
+  unsigned int WorkTimeLimit;   //指令规定的卷膜工作时长上限（S），0表示不限。先重置行程再卷膜时两段一起计时
+  unsigned long WorkStartTime;  //开始计算工作时长的时间（ms）
+  unsigned int FilteredCurrent; //每次采集电流后滤波得到的电流值（mA）
+  unsigned long CurrentReportTime;  //上一次E016实时电流上报的时间（ms）
+
+  Telemetry_Snapshot Telemetry;
+  bool TelemetryValidFlag;            //快照已经完整采集过一次
+  unsigned long CurrentSampleTime;    //快照中电流的采集时间（ms）
+  unsigned long VoltageSampleTime;    //快照中电压的采集时间（ms）
+  unsigned long TelemetryParamTimes;  //快照中参数读取时的写参数次数
+  unsigned char TelemetryMotorStatus; //快照最后一次采集ADC时的电机状态
+  unsigned long OpeningSampleTime;    //快照中开度的读取时间（ms）
+
+  void Refresh_Telemetry_Param(void);
+  void Save_RealTime_Opening(unsigned char opening);
 
   bool Detect_Motor_Limit(unsigned char *current_opening, Limit_Detection dec, Roll_Action act, unsigned char roll_opening, unsigned int real_roll_time);
   bool Detect_Motor_Overtime(Limit_Detection act);
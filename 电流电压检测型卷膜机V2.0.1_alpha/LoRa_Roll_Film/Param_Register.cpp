@@ -0,0 +1,392 @@
+/************************************************************************************
+ *
+ * 参数寄存器表（A024）。以前调试一台卷膜机要分别下发A013、A012、A022、A011，每条都要等回执，
+ * 现在一帧指令可以读或写一组寄存器，所有结果在一帧回执里返回。
+ * 寄存器的读写调用Memory.h中原来的保存、读取函数，不直接改写EEPROM。
+ * 头文件中提供了各个类的公共接口。
+ *
+*************************************************************************************/
+
+#include "Param_Register.h"
+#include "User_CRC8.h"
+#include "Schedule.h"
+#include "receipt.h"
+#include "Command_Analysis.h"
+#include "Cmd_Cache.h"
+#include "LoRa.h"
+
+Param_Register_Map Param_Register;
+
+/*寄存器描述表在头文件里定义，这里只给出存储，查找时按地址取表项*/
+constexpr Param_Register_Map::Register_Descriptor Param_Register_Map::RegisterTable[];
+constexpr unsigned char Param_Register_Map::REGISTER_TABLE_NUM;
+
+/*
+ @brief   : 编译时检查寄存器描述表是否按寄存器号递增排列，并且每一项的寄存器号区间互不重叠
+ @param   : 从第几项开始检查
+ @return  : true or false
+ */
+constexpr bool Param_Register_Map::Register_Table_Sorted(unsigned char index)
+{
+  return (index + 1 >= REGISTER_TABLE_NUM) ? true :
+         (RegisterTable[index].RegID + RegisterTable[index].Num <= RegisterTable[index + 1].RegID && Register_Table_Sorted(index + 1));
+}
+
+/*
+ @brief   : 查找寄存器描述
+ @param   : 寄存器号
+ @return  : 寄存器描述，没有这个寄存器返回NULL
+ */
+const Param_Register_Map::Register_Descriptor *Param_Register_Map::Find_Register(unsigned char reg)
+{
+  static_assert(Register_Table_Sorted(0), "RegisterTable must be sorted by register number");
+
+  for (unsigned char i = 0; i < REGISTER_TABLE_NUM; i++)
+  {
+    if (reg >= RegisterTable[i].RegID && reg < RegisterTable[i].RegID + RegisterTable[i].Num)
+      return &RegisterTable[i];
+  }
+  return NULL;
+}
+
+/*
+ @brief   : 读取寄存器长度
+ @param   : 寄存器号
+ @return  : 长度（byte），没有这个寄存器返回0
+ */
+unsigned char Param_Register_Map::Register_Length(unsigned char reg)
+{
+  const Register_Descriptor *Descriptor = Find_Register(reg);
+  return (Descriptor == NULL) ? 0 : Descriptor->Len;
+}
+
+/*
+ @brief   : 读一个寄存器
+ @param   : 1.寄存器号
+            2.读出的数据，长度为Register_Length()
+ @return  : 读取结果
+ */
+Register_Status Param_Register_Map::Read_Register(unsigned char reg, unsigned char *data)
+{
+  const Register_Descriptor *Descriptor = Find_Register(reg);
+
+  if (Descriptor == NULL) return REG_UNKNOWN;
+
+  if ((this->*Descriptor->Read)(reg - Descriptor->RegID, data))
+    return REG_OK;
+  else
+    return REG_NO_DATA;
+}
+
+/*
+ @brief   : 写一个寄存器
+ @param   : 1.寄存器号
+            2.要写入的数据，长度为Register_Length()
+ @return  : 写入结果
+ */
+Register_Status Param_Register_Map::Write_Register(unsigned char reg, const unsigned char *data)
+{
+  const Register_Descriptor *Descriptor = Find_Register(reg);
+
+  if (Descriptor == NULL) return REG_UNKNOWN;
+  if (Descriptor->Write == NULL) return REG_READ_ONLY;
+
+  if ((this->*Descriptor->Write)(reg - Descriptor->RegID, data))
+    return REG_OK;
+  else
+    return REG_INVALID;
+}
+
+/*
+ @brief   : 读取带CRC8校验的一段参数
+ @param   : 1.起始地址
+            2.长度
+            3.校验码地址
+            4.读出的数据
+ @return  : true or false
+ */
+bool Param_Register_Map::Read_Checked(unsigned int base_addr, unsigned char len, unsigned int verify_addr, unsigned char *data)
+{
+  for (unsigned char i = 0; i < len; i++)
+    data[i] = Param_Read(base_addr + i);
+
+  return (GetCrc8(data, len) == Param_Read(verify_addr));
+}
+
+bool Param_Register_Map::Read_SN_Code(unsigned char index, unsigned char *data)
+{
+  return SN.Read_SN_Code(data);
+}
+
+/*写入SN码与A013相同：同时保存备份SN码，并置位已注册标志*/
+bool Param_Register_Map::Write_SN_Code(unsigned char index, const unsigned char *data)
+{
+  unsigned char SN_Code[9];
+
+  memcpy(SN_Code, data, sizeof(SN_Code));
+  if (!SN.Save_SN_Code(SN_Code) || !SN.Save_BKP_SN_Code(SN_Code))
+    return false;
+  return SN.Set_SN_Access_Network_Flag();
+}
+
+bool Param_Register_Map::Read_Area_Number(unsigned char index, unsigned char *data)
+{
+  if (!Roll_Operation.Check_Area_Number()) return false;
+  data[0] = Roll_Operation.Read_Area_Number();
+  return true;
+}
+
+bool Param_Register_Map::Write_Area_Number(unsigned char index, const unsigned char *data)
+{
+  return Roll_Operation.Save_Area_Number(data[0]);
+}
+
+bool Param_Register_Map::Read_Group_Number(unsigned char index, unsigned char *data)
+{
+  return Roll_Operation.Read_Group_Number(data);
+}
+
+/*写入工作组号与A012相同：同时重新生成工作组位图*/
+bool Param_Register_Map::Write_Group_Number(unsigned char index, const unsigned char *data)
+{
+  unsigned char GroupNumber[5];
+
+  memcpy(GroupNumber, data, sizeof(GroupNumber));
+  return (Roll_Operation.Save_Group_Number(GroupNumber) && Roll_Operation.Rebuild_Group_Bitmap());
+}
+
+bool Param_Register_Map::Read_Group_Bitmap(unsigned char index, unsigned char *data)
+{
+  return Roll_Operation.Read_Group_Bitmap(data);
+}
+
+/*写入工作组位图：同时把前5个工作组保存为原来的工作组号*/
+bool Param_Register_Map::Write_Group_Bitmap(unsigned char index, const unsigned char *data)
+{
+  return (Roll_Operation.Save_Group_Bitmap(data) && Roll_Operation.Rebuild_Group_Number());
+}
+
+bool Param_Register_Map::Read_Work_Limit(unsigned char index, unsigned char *data)
+{
+  if (Param_Read(SAVE_ROLL_THRESHOLD_FLAG_ADDR) != 0x55) return false;
+
+  for (unsigned char i = 0; i < 5; i++)
+    data[i] = Param_Read(ROLL_THRESHOLD_VALUE_BASE_ADDR + i);
+  return true;
+}
+
+bool Param_Register_Map::Write_Work_Limit(unsigned char index, const unsigned char *data)
+{
+  unsigned char Threshold[5];
+
+  memcpy(Threshold, data, sizeof(Threshold));
+  return Roll_Operation.Save_Roll_Work_Voltage_and_Report_Interval(Threshold);
+}
+
+bool Param_Register_Map::Read_Current_Report(unsigned char index, unsigned char *data)
+{
+  data[0] = Roll_Operation.Read_Current_Report_Interval();
+  return true;
+}
+
+bool Param_Register_Map::Write_Current_Report(unsigned char index, const unsigned char *data)
+{
+  return Roll_Operation.Save_Current_Report_Interval(data[0]);
+}
+
+bool Param_Register_Map::Read_LoRa_Com_Mode(unsigned char index, unsigned char *data)
+{
+  data[0] = LoRa_Para_Config.Read_LoRa_Com_Mode();
+  return true;
+}
+
+/*通信模式有变化时，回执发送完后重新配置LoRa模块（与A011相同）*/
+bool Param_Register_Map::Write_LoRa_Com_Mode(unsigned char index, const unsigned char *data)
+{
+  if (data[0] == LoRa_Para_Config.Read_LoRa_Com_Mode()) return true;
+
+  if (!LoRa_Para_Config.Save_LoRa_Com_Mode(data[0])) return false;
+  LoRaReinitFlag = true;
+  return true;
+}
+
+bool Param_Register_Map::Read_LoRa_Addr(unsigned char index, unsigned char *data)
+{
+  return LoRa_Para_Config.Read_LoRa_Addr(data);
+}
+
+bool Param_Register_Map::Read_Roll_Time(unsigned char index, unsigned char *data)
+{
+  return Read_Checked(ROLL_TIME_HIGH_ADDR, 2, ROLL_TIME_VERIFY_ADDR, data);
+}
+
+/*下标0为开棚电流，1为关棚电流*/
+bool Param_Register_Map::Read_Roll_Current(unsigned char index, unsigned char *data)
+{
+  if (index == 0)
+    return Read_Checked(ROLL_UP_CURRENT_HIGH_ADDR, 2, ROLL_UP_CURRENT_VERIFY_ADDR, data);
+  else
+    return Read_Checked(ROLL_DOWN_CURRENT_HIGH_ADDR, 2, ROLL_DOWN_CURRENT_VERIFY_ADDR, data);
+}
+
+bool Param_Register_Map::Read_Roll_Voltage(unsigned char index, unsigned char *data)
+{
+  return Read_Checked(ROLL_VOLTAGE_HIGH_ADDR, 2, ROLL_VOLTAGE_VERIFY_ADDR, data);
+}
+
+bool Param_Register_Map::Read_Opening(unsigned char index, unsigned char *data)
+{
+  data[0] = Roll_Operation.Read_RealTime_Opening_Value();
+  return true;
+}
+
+bool Param_Register_Map::Read_Version(unsigned char index, unsigned char *data)
+{
+  data[0] = SOFT_VERSION;
+  data[1] = HARD_VERSION;
+  return true;
+}
+
+/*没有协商过时按完整的E014上报，死区为0*/
+bool Param_Register_Map::Read_Status_Report(unsigned char index, unsigned char *data)
+{
+  if (!Roll_Operation.Read_Status_Report_Config(data))
+    memset(data, 0, STATUS_REPORT_CONFIG_LEN);
+  return true;
+}
+
+/*切换上报方式或修改死区后，下一帧E017从绝对值开始*/
+bool Param_Register_Map::Write_Status_Report(unsigned char index, const unsigned char *data)
+{
+  if (data[0] > STATUS_REPORT_COMPACT) return false;
+
+  if (!Roll_Operation.Save_Status_Report_Config(data)) return false;
+  Message_Receipt.Restart_Compact_Status();
+  return true;
+}
+
+/*没有保存过的时间段按关闭处理，与开机加载时相同*/
+bool Param_Register_Map::Read_Schedule(unsigned char index, unsigned char *data)
+{
+  if (!Roll_Operation.Read_Schedule(index, data))
+    memset(data, 0, SCHEDULE_DATA_LEN);
+  return true;
+}
+
+/*写入时间段后重新设置定时卷膜闹钟（与A019相同）*/
+bool Param_Register_Map::Write_Schedule(unsigned char index, const unsigned char *data)
+{
+  Schedule_Entry Entry;
+
+  Entry.Mode = data[0];
+  Entry.Opening = data[1];
+  Entry.Start = ((unsigned long)data[2] << 24) | ((unsigned long)data[3] << 16) | ((unsigned long)data[4] << 8) | data[5];
+  Entry.End = ((unsigned long)data[6] << 24) | ((unsigned long)data[7] << 16) | ((unsigned long)data[8] << 8) | data[9];
+
+  if (Entry.Mode > SCHEDULE_ONCE || Entry.Opening > 100 || (Entry.Mode == SCHEDULE_ONCE && Entry.End <= Entry.Start))
+    return false;
+
+  return Roll_Schedule.Set(index, Entry);
+}
+
+/*没有设置过时全为0，群发指令仍然随机等待*/
+bool Param_Register_Map::Read_Reply_Slot(unsigned char index, unsigned char *data)
+{
+  if (!Roll_Operation.Read_Reply_Slot_Config(data))
+    memset(data, 0, REPLY_SLOT_CONFIG_LEN);
+  return true;
+}
+
+/*时隙宽度或个数为0表示关闭时隙回执；时隙宽度不能小于一包回执的发送时间；指定的时隙号必须在时隙个数以内*/
+bool Param_Register_Map::Write_Reply_Slot(unsigned char index, const unsigned char *data)
+{
+  unsigned int SlotNum = (data[1] << 8) | data[2];
+  unsigned int SlotIndex = (data[3] << 8) | data[4];
+
+  if (data[0] != 0 && SlotNum != 0 && data[0] < REPLY_SLOT_WIDTH_MIN)
+    return false;
+
+  if (data[0] != 0 && SlotNum != 0 && SlotIndex != REPLY_SLOT_BY_SN && SlotIndex >= SlotNum)
+    return false;
+
+  return Roll_Operation.Save_Reply_Slot_Config(data);
+}
+
+/*没有设置过时全为0，按原来的固定次数发送*/
+bool Param_Register_Map::Read_Uplink_Ack(unsigned char index, unsigned char *data)
+{
+  if (!Roll_Operation.Read_Uplink_Ack_Config(data))
+    memset(data, 0, UPLINK_ACK_CONFIG_LEN);
+  return true;
+}
+
+/*打开确认时等待确认时间不能为0*/
+bool Param_Register_Map::Write_Uplink_Ack(unsigned char index, const unsigned char *data)
+{
+  if (data[0] > UPLINK_ACK_ON || data[1] > UPLINK_ACK_RETRY_MAX) return false;
+  if (data[0] == UPLINK_ACK_ON && data[2] == 0) return false;
+
+  return Roll_Operation.Save_Uplink_Ack_Config(data);
+}
+
+/*现场测量强制停止延时：不需要重新编译，读出次数和最长延时，高字节在前*/
+bool Param_Register_Map::Read_Fast_Stop(unsigned char index, unsigned char *data)
+{
+  unsigned long Num = LoRa_Command_Analysis.Fast_Stop_Num();
+  unsigned long Latency = LoRa_Command_Analysis.Fast_Stop_Max_Latency();
+
+  for (unsigned char i = 0; i < 4; i++)
+  {
+    data[i] = Num >> (24 - 8 * i);
+    data[4 + i] = Latency >> (24 - 8 * i);
+  }
+  return true;
+}
+
+/*只能写入全0，清零后重新统计*/
+bool Param_Register_Map::Write_Fast_Stop(unsigned char index, const unsigned char *data)
+{
+  for (unsigned char i = 0; i < FAST_STOP_STAT_LEN; i++)
+  {
+    if (data[i] != 0) return false;
+  }
+
+  LoRa_Command_Analysis.Clear_Fast_Stop_Statistics();
+  return true;
+}
+
+/*没有设置过时读出默认窗口，高字节在前*/
+bool Param_Register_Map::Read_Cmd_Cache_Window(unsigned char index, unsigned char *data)
+{
+  if (!Roll_Operation.Read_Cmd_Cache_Window(data))
+  {
+    data[0] = highByte(CMD_CACHE_WINDOW_DEFAULT);
+    data[1] = lowByte(CMD_CACHE_WINDOW_DEFAULT);
+  }
+  return true;
+}
+
+/*窗口不能超过上限，太长时服务器有意重复下发的指令也会被当成重发*/
+bool Param_Register_Map::Write_Cmd_Cache_Window(unsigned char index, const unsigned char *data)
+{
+  if (((data[0] << 8) | data[1]) > CMD_CACHE_WINDOW_MAX) return false;
+
+  return Roll_Operation.Save_Cmd_Cache_Window(data);
+}
+
+bool Param_Register_Map::Read_LoRa_Addr_Mode(unsigned char index, unsigned char *data)
+{
+  data[0] = LoRa_Para_Config.Read_LoRa_Addr_Mode();
+  return true;
+}
+
+/*收发方式有变化时，回执仍按原来的方式发送，发送完后重新配置LoRa模块*/
+bool Param_Register_Map::Write_LoRa_Addr_Mode(unsigned char index, const unsigned char *data)
+{
+  if (data[0] != LORA_ADDR_MODE_OFF && data[0] != LORA_ADDR_MODE_ON) return false;
+  if (data[0] == LoRa_Para_Config.Read_LoRa_Addr_Mode()) return true;
+
+  if (!LoRa_Para_Config.Save_LoRa_Addr_Mode(data[0])) return false;
+  LoRaReinitFlag = true;
+  return true;
+}
@@ -0,0 +1,139 @@
+#ifndef _PARAM_REGISTER_H
+#define _PARAM_REGISTER_H
+
+#include <Arduino.h>
+#include "Memory.h"
+
+/*寄存器号*/
+#define REG_SN_CODE               0x01  //SN码，9 byte
+#define REG_AREA_NUMBER           0x02  //区域号，1 byte
+#define REG_GROUP_NUMBER          0x03  //工作组号，5 byte
+#define REG_GROUP_BITMAP          0x04  //工作组位图，32 byte
+#define REG_WORK_LIMIT            0x05  //低电压阈值2 + 电流阈值2 + 状态上报间隔1，与A022相同
+#define REG_CURRENT_REPORT        0x06  //E016实时电流上报间隔（S），1 byte
+#define REG_LORA_COM_MODE         0x07  //LoRa通信模式，0xF0节点，0xF1网关
+#define REG_LORA_ADDR             0x08  //LoRa地址，8 byte，只读
+#define REG_ROLL_TIME             0x09  //卷膜总行程时长（S），2 byte，只读
+#define REG_ROLL_UP_CURRENT       0x0A  //开棚工作电流（mA），2 byte，只读
+#define REG_ROLL_DOWN_CURRENT     0x0B  //关棚工作电流（mA），2 byte，只读
+#define REG_ROLL_VOLTAGE          0x0C  //卷膜工作电压（mV），2 byte，只读
+#define REG_OPENING               0x0D  //实时开度，1 byte，只读
+#define REG_VERSION               0x0E  //软件版本1 + 硬件版本1，只读
+#define REG_STATUS_REPORT         0x0F  //状态上报方式1 + 开度死区1（%） + 电流死区1（10mA） + 电压死区1（100mV）
+#define REG_SCHEDULE_BASE         0x10  //定时卷膜时间段1 - 8，每个10 byte，与EEPROM中的格式相同
+#define REG_REPLY_SLOT            0x18  //群发回执时隙宽度1（10ms） + 时隙个数2 + 本机时隙号2（0xFFFF按SN码计算）
+#define REG_UPLINK_ACK            0x19  //上行确认方式1 + 最多重发次数1 + 第一次等待确认时间1（100ms）
+#define REG_FAST_STOP             0x1A  //接收泵强制停止次数4 + 最长停止延时4（us），写入全0清零
+#define REG_CMD_CACHE_WINDOW      0x1B  //重复指令缓存时间窗口（S），2 byte，0不去重
+#define REG_LORA_ADDR_MODE        0x1C  //LoRa收发方式，0x00透传，0x01按地址收发（带硬件帧头）
+
+#define FAST_STOP_STAT_LEN        8
+
+/*读写一个寄存器的结果*/
+enum Register_Status{
+  REG_OK = 0,         //成功
+  REG_UNKNOWN,        //没有这个寄存器
+  REG_READ_ONLY,      //只读寄存器不能写
+  REG_INVALID,        //写入的值不合法，或者保存失败
+  REG_NO_DATA,        //没有保存过或数据损坏
+  REG_NO_ROOM         //回执帧已经放不下
+};
+
+/*
+ * 参数寄存器表。把Memory.h中保存的各个参数按寄存器号统一读写，
+ * 读写时仍然调用原来的保存、读取函数，校验码和标志位与单独的设置指令完全一致。
+ */
+class Param_Register_Map : public EEPROM_Operations{
+public:
+  unsigned char Register_Length(unsigned char reg);
+  Register_Status Read_Register(unsigned char reg, unsigned char *data);
+  Register_Status Write_Register(unsigned char reg, const unsigned char *data);
+  bool LoRa_Reinit_Pending(void) {return LoRaReinitFlag;}
+  void Clear_LoRa_Reinit(void) {LoRaReinitFlag = false;}
+
+private:
+  /*寄存器描述：连续Num个寄存器共用一组读写函数，用下标区分*/
+  struct Register_Descriptor{
+    unsigned char RegID;
+    unsigned char Num;
+    unsigned char Len;
+    bool (Param_Register_Map::*Read)(unsigned char index, unsigned char *data);
+    bool (Param_Register_Map::*Write)(unsigned char index, const unsigned char *data);  //只读寄存器为NULL
+  };
+
+  static constexpr bool Register_Table_Sorted(unsigned char index);
+  const Register_Descriptor *Find_Register(unsigned char reg);
+
+  bool Read_Checked(unsigned int base_addr, unsigned char len, unsigned int verify_addr, unsigned char *data);
+
+  bool Read_SN_Code(unsigned char index, unsigned char *data);
+  bool Write_SN_Code(unsigned char index, const unsigned char *data);
+  bool Read_Area_Number(unsigned char index, unsigned char *data);
+  bool Write_Area_Number(unsigned char index, const unsigned char *data);
+  bool Read_Group_Number(unsigned char index, unsigned char *data);
+  bool Write_Group_Number(unsigned char index, const unsigned char *data);
+  bool Read_Group_Bitmap(unsigned char index, unsigned char *data);
+  bool Write_Group_Bitmap(unsigned char index, const unsigned char *data);
+  bool Read_Work_Limit(unsigned char index, unsigned char *data);
+  bool Write_Work_Limit(unsigned char index, const unsigned char *data);
+  bool Read_Current_Report(unsigned char index, unsigned char *data);
+  bool Write_Current_Report(unsigned char index, const unsigned char *data);
+  bool Read_LoRa_Com_Mode(unsigned char index, unsigned char *data);
+  bool Write_LoRa_Com_Mode(unsigned char index, const unsigned char *data);
+  bool Read_LoRa_Addr(unsigned char index, unsigned char *data);
+  bool Read_Roll_Time(unsigned char index, unsigned char *data);
+  bool Read_Roll_Current(unsigned char index, unsigned char *data);
+  bool Read_Roll_Voltage(unsigned char index, unsigned char *data);
+  bool Read_Opening(unsigned char index, unsigned char *data);
+  bool Read_Version(unsigned char index, unsigned char *data);
+  bool Read_Status_Report(unsigned char index, unsigned char *data);
+  bool Write_Status_Report(unsigned char index, const unsigned char *data);
+  bool Read_Schedule(unsigned char index, unsigned char *data);
+  bool Write_Schedule(unsigned char index, const unsigned char *data);
+  bool Read_Reply_Slot(unsigned char index, unsigned char *data);
+  bool Write_Reply_Slot(unsigned char index, const unsigned char *data);
+  bool Read_Uplink_Ack(unsigned char index, unsigned char *data);
+  bool Write_Uplink_Ack(unsigned char index, const unsigned char *data);
+  bool Read_Fast_Stop(unsigned char index, unsigned char *data);
+  bool Write_Fast_Stop(unsigned char index, const unsigned char *data);
+  bool Read_Cmd_Cache_Window(unsigned char index, unsigned char *data);
+  bool Write_Cmd_Cache_Window(unsigned char index, const unsigned char *data);
+  bool Read_LoRa_Addr_Mode(unsigned char index, unsigned char *data);
+  bool Write_LoRa_Addr_Mode(unsigned char index, const unsigned char *data);
+
+  bool LoRaReinitFlag;  //LoRa通信模式被修改，回执发送完后需要重新配置LoRa模块
+
+private:
+  /*
+   * 寄存器描述表，必须按寄存器号从小到大排列、区间互不重叠（编译时检查）。
+   * 新增参数只需要在表里加一行，表项个数由表本身得出。
+   */
+  static constexpr Register_Descriptor RegisterTable[] = {
+    /* 寄存器号          | 个数         | 长度               | 读函数                                   | 写函数 */
+    {REG_SN_CODE,         1,            9,                  &Param_Register_Map::Read_SN_Code,        &Param_Register_Map::Write_SN_Code},
+    {REG_AREA_NUMBER,     1,            1,                  &Param_Register_Map::Read_Area_Number,    &Param_Register_Map::Write_Area_Number},
+    {REG_GROUP_NUMBER,    1,            5,                  &Param_Register_Map::Read_Group_Number,   &Param_Register_Map::Write_Group_Number},
+    {REG_GROUP_BITMAP,    1,            GROUP_BITMAP_LEN,   &Param_Register_Map::Read_Group_Bitmap,   &Param_Register_Map::Write_Group_Bitmap},
+    {REG_WORK_LIMIT,      1,            5,                  &Param_Register_Map::Read_Work_Limit,     &Param_Register_Map::Write_Work_Limit},
+    {REG_CURRENT_REPORT,  1,            1,                  &Param_Register_Map::Read_Current_Report, &Param_Register_Map::Write_Current_Report},
+    {REG_LORA_COM_MODE,   1,            1,                  &Param_Register_Map::Read_LoRa_Com_Mode,  &Param_Register_Map::Write_LoRa_Com_Mode},
+    {REG_LORA_ADDR,       1,            8,                  &Param_Register_Map::Read_LoRa_Addr,      NULL},
+    {REG_ROLL_TIME,       1,            2,                  &Param_Register_Map::Read_Roll_Time,      NULL},
+    {REG_ROLL_UP_CURRENT, 2,            2,                  &Param_Register_Map::Read_Roll_Current,   NULL},
+    {REG_ROLL_VOLTAGE,    1,            2,                  &Param_Register_Map::Read_Roll_Voltage,   NULL},
+    {REG_OPENING,         1,            1,                  &Param_Register_Map::Read_Opening,        NULL},
+    {REG_VERSION,         1,            2,                  &Param_Register_Map::Read_Version,        NULL},
+    {REG_STATUS_REPORT,   1,            STATUS_REPORT_CONFIG_LEN, &Param_Register_Map::Read_Status_Report, &Param_Register_Map::Write_Status_Report},
+    {REG_SCHEDULE_BASE,   SCHEDULE_NUM, SCHEDULE_DATA_LEN,  &Param_Register_Map::Read_Schedule,       &Param_Register_Map::Write_Schedule},
+    {REG_REPLY_SLOT,      1,            REPLY_SLOT_CONFIG_LEN, &Param_Register_Map::Read_Reply_Slot,   &Param_Register_Map::Write_Reply_Slot},
+    {REG_UPLINK_ACK,      1,            UPLINK_ACK_CONFIG_LEN, &Param_Register_Map::Read_Uplink_Ack,   &Param_Register_Map::Write_Uplink_Ack},
+    {REG_FAST_STOP,       1,            FAST_STOP_STAT_LEN, &Param_Register_Map::Read_Fast_Stop,      &Param_Register_Map::Write_Fast_Stop},
+    {REG_CMD_CACHE_WINDOW, 1,           CMD_CACHE_WINDOW_LEN, &Param_Register_Map::Read_Cmd_Cache_Window, &Param_Register_Map::Write_Cmd_Cache_Window},
+    {REG_LORA_ADDR_MODE,  1,            LORA_ADDR_MODE_LEN, &Param_Register_Map::Read_LoRa_Addr_Mode, &Param_Register_Map::Write_LoRa_Addr_Mode},
+  };
+  static constexpr unsigned char REGISTER_TABLE_NUM = sizeof(RegisterTable) / sizeof(RegisterTable[0]);
+};
+
+extern Param_Register_Map Param_Register;
+
+#endif
@@ -1,5 +1,6 @@
 #include "Private_RTC.h"
 #include "User_Clock.h"
+#include "Memory.h"
 
 /*RCT object*/
 RTClock Date(RTCSEL_LSE); 
@@ -9,40 +10,222 @@ date Private_RTC;
 
 /*
  @brief   : 更新本机RTC
- @param   : 新的RTC
+ @param   : 新的RTC（世纪、年、月、日、时、分、秒）
  @return  : 无
  */
 void date::Update_RTC(unsigned char *buffer)
 {
     RtcTime.year = buffer[0] * 100 + buffer[1];
-    RtcTime.month = buffer[2];
-    RtcTime.day = buffer[3];
+    RtcTime.month = buffer[2] - 1;    //osal_ConvertUTCSecs 的月和日从0开始
+    RtcTime.day = buffer[3] - 1;
     RtcTime.hour = buffer[4];
     RtcTime.minutes = buffer[5];
     RtcTime.seconds = buffer[6];
 
-    UTCTime CurrentSec = osal_ConvertUTCSecs(&RtcTime);
-    bkp_enable_writes();
-    Date.setTime(CurrentSec);
-    bkp_disable_writes();
+    Set_Time(osal_ConvertUTCSecs(&RtcTime));
 }
 
 /*
- @brief   : 得到本机的RTC
- @param   : RTC缓存
+ @brief   : 得到本机的RTC（已经过漂移补偿）
+ @param   : RTC缓存（世纪、年、月、日、时、分、秒）
  @return  : 无
  */
 void date::Get_RTC(unsigned char *buffer)
 {
   UTCTime CurrentSec = 0;
-  CurrentSec = Date.getTime();
+  CurrentSec = Get_Time();
   osal_ConvertUTCTime(&RtcTime, CurrentSec);
 
-  buffer[0] = RtcTime.year / 1000;
-  buffer[1] = RtcTime.year % 1000;
-  buffer[2] = RtcTime.month;
-  buffer[3] = RtcTime.day;
+  buffer[0] = RtcTime.year / 100;
+  buffer[1] = RtcTime.year % 100;
+  buffer[2] = RtcTime.month + 1;
+  buffer[3] = RtcTime.day + 1;
   buffer[4] = RtcTime.hour;
   buffer[5] = RtcTime.minutes;
   buffer[6] = RtcTime.seconds;
+}
+
+/*
+ @brief   : 校时。和上一次校时相隔足够久时，用本机走时与服务器时间的差估计LSE晶振的漂移，
+            之后读时间时按漂移补偿，两次校时之间可以隔很久
+ @param   : 服务器时间（RTC秒数）
+ @return  : 无
+ */
+void date::Set_Time(UTCTime time)
+{
+  UTCTime BaseTime;
+  long DriftPpb;
+
+  Read_Drift_Param(&BaseTime, &DriftPpb);
+
+  UTCTime LocalTime = Compensate(Date.getTime(), BaseTime, DriftPpb);
+  if (Time_Valid(LocalTime) && Time_Valid(BaseTime) && time > BaseTime && time - BaseTime >= RTC_DRIFT_MIN_INTERVAL)
+  {
+    /*本机走快了误差为正，补偿值要减小*/
+    long long Error = (long long)LocalTime - (long long)time;
+    long long Measure = DriftPpb - Error * 1000000000LL / (long long)(time - BaseTime);
+
+    if (Measure >= -RTC_DRIFT_MAX_PPB && Measure <= RTC_DRIFT_MAX_PPB)
+      DriftPpb += (long)((Measure - DriftPpb) / (1 << RTC_DRIFT_GAIN_SHIFT));
+    else
+      Serial.println("Time changed too much, skip drift estimation... <Set_Time>");
+
+    Serial.print("RTC error(s): "); Serial.print((long)Error);
+    Serial.print(", drift(ppb): "); Serial.print(DriftPpb);
+    Serial.println(" <Set_Time>");
+  }
+
+  bkp_enable_writes();
+  Date.setTime(time);
+  bkp_disable_writes();
+  Save_Drift_Param(time, DriftPpb);
+}
+
+/*
+ @brief   : 得到本机的RTC秒数（已经过漂移补偿）
+ @param   : 无
+ @return  : 从2000年1月1日0时开始的秒数
+ */
+UTCTime date::Get_Time(void)
+{
+  UTCTime BaseTime;
+  long DriftPpb;
+
+  Read_Drift_Param(&BaseTime, &DriftPpb);
+  return Compensate(Date.getTime(), BaseTime, DriftPpb);
+}
+
+/*
+ @brief   : 得到回执里用的4字节时间戳（RTC秒数，高字节在前），RTC没有校准过时为0
+ @param   : 时间戳缓存（4 byte）
+ @return  : 无
+ */
+void date::Get_Timestamp(unsigned char *buffer)
+{
+  UTCTime CurrentSec = Get_Time();
+
+  if (!Time_Valid(CurrentSec))
+    CurrentSec = 0;
+
+  buffer[0] = CurrentSec >> 24;
+  buffer[1] = CurrentSec >> 16;
+  buffer[2] = CurrentSec >> 8;
+  buffer[3] = CurrentSec;
+}
+
+/*
+ @brief   : 得到当前的LSE晶振漂移补偿值
+ @param   : 无
+ @return  : 漂移补偿值（ppb，正数表示晶振走慢了）
+ */
+long date::Drift_Ppb(void)
+{
+  UTCTime BaseTime;
+  long DriftPpb;
+
+  Read_Drift_Param(&BaseTime, &DriftPpb);
+  return DriftPpb;
+}
+
+/*
+ @brief   : 按漂移补偿值把RTC计数器的时间换算成实际时间
+ @param   : 1.RTC计数器的时间
+            2.上一次校时的时间
+            3.漂移补偿值（ppb）
+ @return  : 实际时间
+ */
+UTCTime date::Compensate(UTCTime raw_time, UTCTime base_time, long drift_ppb)
+{
+  if (drift_ppb == 0 || !Time_Valid(base_time))
+    return raw_time;
+
+  long long Elapsed = (long long)raw_time - (long long)base_time;
+  return raw_time + (long)(Elapsed * drift_ppb / 1000000000LL);
+}
+
+/*
+ @brief   : 读取备份寄存器里的上一次校时时间和漂移补偿值。备份寄存器和RTC一样由电池供电，掉电不丢失
+ @param   : 1.上一次校时的时间
+            2.漂移补偿值（ppb）
+ @return  : 无
+ */
+void date::Read_Drift_Param(UTCTime *base_time, long *drift_ppb)
+{
+  *base_time = ((UTCTime)bkp_read(BKP_RTC_BASE_TIME_HIGH_ADDR) << 16) | bkp_read(BKP_RTC_BASE_TIME_LOW_ADDR);
+  *drift_ppb = (long)(((unsigned long)bkp_read(BKP_RTC_DRIFT_HIGH_ADDR) << 16) | bkp_read(BKP_RTC_DRIFT_LOW_ADDR));
+}
+
+/*
+ @brief   : 保存校时时间和漂移补偿值到备份寄存器
+ @param   : 1.校时的时间
+            2.漂移补偿值（ppb）
+ @return  : 无
+ */
+void date::Save_Drift_Param(UTCTime base_time, long drift_ppb)
+{
+  bkp_enable_writes();
+  bkp_write(BKP_RTC_BASE_TIME_HIGH_ADDR, base_time >> 16);
+  bkp_write(BKP_RTC_BASE_TIME_LOW_ADDR, base_time & 0xFFFF);
+  bkp_write(BKP_RTC_DRIFT_HIGH_ADDR, (unsigned long)drift_ppb >> 16);
+  bkp_write(BKP_RTC_DRIFT_LOW_ADDR, (unsigned long)drift_ppb & 0xFFFF);
+  bkp_disable_writes();
+}
+
+/*
+ @brief   : 把协议里6个字节的时间（年-2000、月、日、时、分、秒）转换成RTC秒数
+ @param   : 1.时间，如 13 09 07 12 20 09 表示2019年9月7日18时32分9秒
+            2.转换后的秒数
+ @return  : true or false（时间不合法）
+ */
+bool date::Convert_Time(const unsigned char *buffer, UTCTime *time)
+{
+  UTCTimeStruct TimeTemp;
+
+  if (buffer[1] < 1 || buffer[1] > 12 || buffer[2] < 1 || buffer[2] > 31 || buffer[3] > 23 || buffer[4] > 59 || buffer[5] > 59)
+    return false;
+
+  TimeTemp.year = 2000 + buffer[0];
+  TimeTemp.month = buffer[1] - 1;   //osal_ConvertUTCSecs 的月和日从0开始
+  TimeTemp.day = buffer[2] - 1;
+  TimeTemp.hour = buffer[3];
+  TimeTemp.minutes = buffer[4];
+  TimeTemp.seconds = buffer[5];
+
+  *time = osal_ConvertUTCSecs(&TimeTemp);
+  return true;
+}
+
+/*
+ @brief   : 设置RTC闹钟，到时间后在RTC闹钟中断里调用处理函数
+ @param   : 1.闹钟时间（补偿后的RTC秒数）
+            2.中断处理函数
+ @return  : 无
+ */
+void date::Set_Alarm(UTCTime alarm_time, void (*handler)(void))
+{
+  UTCTime BaseTime;
+  long DriftPpb;
+
+  Read_Drift_Param(&BaseTime, &DriftPpb);
+
+  /*闹钟比较的是RTC计数器，按漂移补偿值反算，保证闹钟响时补偿后的时间不早于闹钟时间*/
+  UTCTime RawTime = alarm_time;
+  if (DriftPpb != 0 && Time_Valid(BaseTime))
+  {
+    long long Elapsed = (long long)alarm_time - (long long)BaseTime;
+    RawTime = BaseTime + (long)(Elapsed * 1000000000LL / (1000000000LL + DriftPpb));
+    while (Compensate(RawTime, BaseTime, DriftPpb) < alarm_time)
+      RawTime++;
+  }
+  Date.createAlarm(handler, RawTime);
+}
+
+/*
+ @brief   : 取消RTC闹钟
+ @param   : 无
+ @return  : 无
+ */
+void date::Remove_Alarm(void)
+{
+  Date.removeAlarm();
 }
\ No newline at end of file
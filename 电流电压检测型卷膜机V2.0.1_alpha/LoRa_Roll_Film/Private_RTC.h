@@ -2,11 +2,34 @@
 #define _PRIVATE_RTC_H
 
 #include <RTClock.h>
+#include "User_Clock.h"
+
+#define RTC_VALID_MIN_TIME  599616000UL  //2019-01-01 00:00:00，早于这个时间说明RTC还没有校准过
+#define SECONDS_PER_DAY     86400UL
+
+/*LSE晶振漂移估计*/
+#define RTC_DRIFT_MIN_INTERVAL  SECONDS_PER_DAY   //两次校时间隔太短，1秒的传输误差就会淹没漂移，不估计
+#define RTC_DRIFT_MAX_PPB       500000L           //超过500ppm不是晶振漂移，是时间被改过，不估计
+#define RTC_DRIFT_GAIN_SHIFT    1                 //每次只修正测量误差的一半，减小传输延时带来的抖动
 
 class date{
 public:
     void Update_RTC(unsigned char *buffer);
     void Get_RTC(unsigned char *buffer);
+
+    void Set_Time(UTCTime time);
+    UTCTime Get_Time(void);
+    void Get_Timestamp(unsigned char *buffer);
+    long Drift_Ppb(void);
+    bool Time_Valid(UTCTime time) {return (time >= RTC_VALID_MIN_TIME);}
+    bool Convert_Time(const unsigned char *buffer, UTCTime *time);
+    void Set_Alarm(UTCTime alarm_time, void (*handler)(void));
+    void Remove_Alarm(void);
+
+private:
+    void Read_Drift_Param(UTCTime *base_time, long *drift_ppb);
+    void Save_Drift_Param(UTCTime base_time, long drift_ppb);
+    UTCTime Compensate(UTCTime raw_time, UTCTime base_time, long drift_ppb);
 };
 
 extern date Private_RTC;
@@ -2,13 +2,19 @@
 #include "fun_periph.h"
 #include "Motor.h"
 #include "Security.h"
+#include "LoRa.h"
+#include "Ring_Buffer.h"
+#include "Command_Analysis.h"
+#include "Tx_Queue.h"
 #include <Arduino.h>
 
 /*Timer timing time*/
 #define TIMER_NUM             1000000L * 1 //1S
 #define CHECK_TIMER_NUM       1000000L
+#define LORA_RX_TIMER_NUM     1000L  //1ms，9600波特率下每毫秒约1个字节，远小于串口驱动的接收缓存
 
 volatile static unsigned int gSelfCheckNum;
+static bool gLoRaPumpRunFlag = false;             //LoRa收发泵是否在运行
 
 /*
  @brief   : 使用定时器2初始化卷膜行程计时参数
@@ -35,6 +41,20 @@ void Self_Check_Parameter_Timer_Init(void)
   Timer3.setCount(0);
 }
 
+/*
+ @brief   : 使用定时器1初始化LoRa串口接收泵，周期性地把串口驱动缓存里的字节搬进环形缓存。
+            初始化后处于暂停状态，由LoRa进入透传模式时开启。
+ @param   : 无
+ @return  : 无
+ */
+void LoRa_Rx_Timer_Init(void)
+{
+  Timer1.setPeriod(LORA_RX_TIMER_NUM); // in microseconds，1ms
+  Timer1.attachCompare1Interrupt(Timer1_Interrupt);
+  Timer1.setCount(0);
+  Timer1.pause();
+}
+
 /*
  @brief   : 开始卷膜计时
  @param   : 无
@@ -79,6 +99,33 @@ void Stop_Self_Check_Timing(void)
   Timer3.pause();
 }
 
+/*
+ @brief   : 开启LoRa串口接收泵
+ @param   : 无
+ @return  : 无
+ */
+void Start_LoRa_Rx_Pump(void)
+{
+  gLoRaPumpRunFlag = true;
+  Timer1.setCount(0);
+  Timer1.resume();
+}
+
+/*
+ @brief   : 停止LoRa串口接收泵。AT模式下需要直接读取串口回执，必须先停止接收泵。
+            接收泵同时也是发送泵，停止前先把发送队列里的回执发完，AT指令不会插到回执中间
+ @param   : 无
+ @return  : 无
+ */
+void Stop_LoRa_Rx_Pump(void)
+{
+  if (gLoRaPumpRunFlag)
+    LoRa_Tx_Queue.Flush(TX_FLUSH_TIMEOUT);
+
+  gLoRaPumpRunFlag = false;
+  Timer1.pause();
+}
+
 /*
  @brief   : 卷膜计时定时器2计时中断处理函数
  @param   : 无
@@ -103,4 +150,28 @@ void Timer3_Interrupt(void)
       gSelfCheckNum = 0;
       gCheckStoreParamFlag = true;
   }
+}
+
+/*
+ @brief   : LoRa接收泵定时器1中断处理函数，把串口收到的字节全部搬进环形缓存，
+            同时逐字节识别强制停止指令，识别到马上停止电机。
+            同时做发送泵，把发送队列里到时间的回执非阻塞地写入串口
+ @param   : 无
+ @return  : 无
+ */
+void Timer1_Interrupt(void)
+{
+  unsigned long TickTime = micros();  //统计强制停止延时的起点
+
+  if (LoRa_Serial.available() > 0)
+    LoRa_Tx_Queue.Channel_Activity();  //模块正在输出收到的数据，信道上有其他设备在发送
+
+  while (LoRa_Serial.available() > 0)
+  {
+    unsigned char c = LoRa_Serial.read();
+    LoRa_Rx_Buffer.Write_Byte(c);
+    LoRa_Command_Analysis.Fast_Stop_Detect(c, TickTime);
+  }
+
+  LoRa_Tx_Queue.Transmit_Pump();
 }
\ No newline at end of file
@@ -3,12 +3,16 @@
 
 void Roll_Timer_Init(void);
 void Self_Check_Parameter_Timer_Init(void);
+void LoRa_Rx_Timer_Init(void);
 void Start_Roll_Timing(void);
 void Start_Self_Check_Timing(void);
 void Stop_Roll_Timing(void);
 void Stop_Self_Check_Timing(void);
+void Start_LoRa_Rx_Pump(void);
+void Stop_LoRa_Rx_Pump(void);
 void Timer2_Interrupt(void);
 void Timer3_Interrupt(void);
+void Timer1_Interrupt(void);
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,113 @@
+/************************************************************************************
+ * 
+ * 单生产者/单消费者无锁环形缓存。定时器中断把LoRa串口收到的字节搬进缓存，主循环从缓存里
+ * 取字节组帧，两边互不等待。同时统计丢弃字节数、溢出次数和最高水位，方便根据网关实际的
+ * 数据密度调整缓存大小。
+ * 头文件中提供了各个类的公共接口。
+ * 
+*************************************************************************************/
+
+#include "Ring_Buffer.h"
+
+Ring_Buffer LoRa_Rx_Buffer;
+
+/*
+ @brief   : 写入一个字节（仅在中断里调用）
+ @param   : 要写入的字节
+ @return  : true or false（缓存已满，该字节被丢弃）
+ */
+bool Ring_Buffer::Write_Byte(unsigned char c)
+{
+  unsigned char Next = Head + 1;
+
+  if (Next == Tail)
+  {
+    DropBytes++;
+    if (!FullFlag)
+    {
+      FullFlag = true;
+      OverflowTimes++;
+    }
+    return false;
+  }
+  FullFlag = false;
+
+  Buffer[Head] = c;
+  Head = Next;
+
+  unsigned char Used = Head - Tail;
+  if (Used > PeakBytes)
+    PeakBytes = Used;
+
+  return true;
+}
+
+/*
+ @brief   : 读出一个字节（仅在主循环里调用）
+ @param   : 读出的字节
+ @return  : true or false（缓存为空）
+ */
+bool Ring_Buffer::Read_Byte(unsigned char *c)
+{
+  unsigned char CurrentTail = Tail;
+
+  if (CurrentTail == Head)
+    return false;
+
+  *c = Buffer[CurrentTail];
+  Tail = CurrentTail + 1;
+  return true;
+}
+
+/*
+ @brief   : 查看第offset个待读取的字节，但不取出（仅在主循环里调用）
+ @param   : 1.相对读下标的偏移
+            2.查看到的字节
+ @return  : true or false（缓存中没有这么多字节）
+ */
+bool Ring_Buffer::Peek_Byte(unsigned int offset, unsigned char *c)
+{
+  unsigned char CurrentTail = Tail;
+
+  if (offset >= (unsigned char)(Head - CurrentTail))
+    return false;
+
+  *c = Buffer[(unsigned char)(CurrentTail + offset)];
+  return true;
+}
+
+/*
+ @brief   : 丢弃num个待读取的字节，只移动读下标（仅在主循环里调用）
+ @param   : 丢弃的字节数
+ @return  : 无
+ */
+void Ring_Buffer::Skip(unsigned int num)
+{
+  unsigned char CurrentTail = Tail;
+  unsigned char Used = Head - CurrentTail;
+
+  if (num > Used)
+    num = Used;
+  Tail = CurrentTail + num;
+}
+
+/*
+ @brief   : 缓存中待读取的字节数
+ @param   : 无
+ @return  : 字节数
+ */
+unsigned int Ring_Buffer::Available(void)
+{
+  return (unsigned char)(Head - Tail);
+}
+
+/*
+ @brief   : 丢弃缓存中所有未读取的字节（仅在主循环里调用）
+ @param   : 无
+ @return  : 无
+ */
+void Ring_Buffer::Clear(void)
+{
+  Tail = Head;
+  FullFlag = false;
+}
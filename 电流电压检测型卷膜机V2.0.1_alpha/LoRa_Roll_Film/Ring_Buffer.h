@@ -0,0 +1,41 @@
+#ifndef _RING_BUFFER_H
+#define _RING_BUFFER_H
+
+#include <Arduino.h>
+
+/*缓存大小必须是2的幂，读写下标用unsigned char自然回绕，最多可存 RING_BUFFER_SIZE - 1 个字节*/
+#define RING_BUFFER_SIZE    256
+
+/*
+ * 单生产者/单消费者无锁环形缓存。
+ * Write_Byte() 只允许在中断里调用（生产者），Read_Byte() 只允许在主循环里调用（消费者）。
+ * Peek_Byte()、Skip()、Clear() 只读取或移动读下标，属于消费者操作，也只在主循环里调用。
+ */
+class Ring_Buffer{
+public:
+  bool Write_Byte(unsigned char c);
+  bool Read_Byte(unsigned char *c);
+  bool Peek_Byte(unsigned int offset, unsigned char *c);
+  void Skip(unsigned int num);
+  unsigned int Available(void);
+  void Clear(void);
+
+  unsigned long Drop_Bytes(void)    {return DropBytes;}
+  unsigned long Overflow_Times(void){return OverflowTimes;}
+  unsigned int Peak_Bytes(void)     {return PeakBytes;}
+
+private:
+  volatile unsigned char Buffer[RING_BUFFER_SIZE];
+  volatile unsigned char Head;   //生产者写下标
+  volatile unsigned char Tail;   //消费者读下标
+  volatile bool FullFlag;        //缓存是否处于溢出状态
+
+  volatile unsigned long DropBytes;     //因缓存满被丢弃的字节数
+  volatile unsigned long OverflowTimes; //缓存溢出的次数（连续丢字节只算一次）
+  volatile unsigned int PeakBytes;      //缓存使用的最高水位
+};
+
+/*LoRa串口接收缓存*/
+extern Ring_Buffer LoRa_Rx_Buffer;
+
+#endif
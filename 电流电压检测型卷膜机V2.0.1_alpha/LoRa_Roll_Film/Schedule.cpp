@@ -0,0 +1,212 @@
+/************************************************************************************
+ *
+ * 本机定时卷膜（A019）。以前每个定时开关棚都要服务器在同一分钟给整个农场下发指令，是信道最
+ * 拥挤的时候。现在服务器只需要下发一次时间段，本机按RTC时间自己卷膜，完成后只回执结果。
+ * 每个时间段的下一次动作时间直接算出，不需要逐分钟轮询，由RTC闹钟中断触发。
+ * 头文件中提供了各个类的公共接口。
+ *
+*************************************************************************************/
+
+#include "Schedule.h"
+#include "Private_RTC.h"
+
+Schedule_Engine Roll_Schedule;
+
+volatile bool gScheduleAlarmFlag = false;   //RTC闹钟到时间，需要执行定时卷膜标志位
+
+/*
+ @brief   : RTC闹钟中断处理函数
+ @param   : 无
+ @return  : 无
+ */
+static void Schedule_Alarm_Interrupt(void)
+{
+  gScheduleAlarmFlag = true;
+}
+
+/*
+ @brief   : 从EEPROM读出时间段表。没有保存过或损坏的时间段按关闭处理
+ @param   : 无
+ @return  : 无
+ */
+void Schedule_Engine::Load(void)
+{
+  unsigned char Data[SCHEDULE_DATA_LEN];
+
+  for (unsigned char i = 0; i < SCHEDULE_NUM; i++)
+  {
+    if (!Roll_Operation.Read_Schedule(i, Data))
+    {
+      Entry[i].Mode = SCHEDULE_OFF;
+      continue;
+    }
+
+    Entry[i].Mode = Data[0];
+    Entry[i].Opening = Data[1];
+    Entry[i].Start = ((unsigned long)Data[2] << 24) | ((unsigned long)Data[3] << 16) | ((unsigned long)Data[4] << 8) | Data[5];
+    Entry[i].End = ((unsigned long)Data[6] << 24) | ((unsigned long)Data[7] << 16) | ((unsigned long)Data[8] << 8) | Data[9];
+  }
+}
+
+/*
+ @brief   : 设置一个时间段，保存到EEPROM后重新设置闹钟
+ @param   : 1.时间段下标（0 - SCHEDULE_NUM-1）
+            2.时间段
+ @return  : true or false
+ */
+bool Schedule_Engine::Set(unsigned char index, const Schedule_Entry &entry)
+{
+  unsigned char Data[SCHEDULE_DATA_LEN];
+
+  if (index >= SCHEDULE_NUM)
+    return false;
+
+  Data[0] = entry.Mode;
+  Data[1] = entry.Opening;
+  for (unsigned char i = 0; i < 4; i++)
+  {
+    Data[2 + i] = entry.Start >> (24 - i * 8);
+    Data[6 + i] = entry.End >> (24 - i * 8);
+  }
+
+  if (!Roll_Operation.Save_Schedule(index, Data))
+    return false;
+
+  Entry[index] = entry;
+  Arm();
+  return true;
+}
+
+/*
+ @brief   : 按当前RTC时间设置下一次动作的闹钟。RTC没有校准过时不执行定时卷膜
+ @param   : 无
+ @return  : 无
+ */
+void Schedule_Engine::Arm(void)
+{
+  UTCTime Now = Private_RTC.Get_Time();
+
+  if (!Private_RTC.Time_Valid(Now))
+  {
+    NextValidFlag = false;
+    Private_RTC.Remove_Alarm();
+    Serial.println("RTC not calibrated, schedule disabled... <Arm>");
+    return;
+  }
+  Arm_After(Now);
+}
+
+/*
+ @brief   : 在所有时间段里找出after之后最早的一次动作，设置闹钟。
+            主循环处理晚了、下一次动作时间已经过了，直接置位闹钟标志，不漏掉动作
+ @param   : 从这个时间之后开始找（不包括这个时间）
+ @return  : 无
+ */
+void Schedule_Engine::Arm_After(unsigned long after)
+{
+  unsigned long EventTime;
+  unsigned char Opening;
+
+  NextValidFlag = false;
+  for (unsigned char i = 0; i < SCHEDULE_NUM; i++)
+  {
+    if (!Next_Event(Entry[i], after, &EventTime, &Opening))
+      continue;
+
+    /*同一时间有多个动作时，下标小的时间段优先*/
+    if (!NextValidFlag || EventTime < NextTime)
+    {
+      NextValidFlag = true;
+      NextTime = EventTime;
+      NextOpening = Opening;
+    }
+  }
+
+  if (!NextValidFlag)
+  {
+    Private_RTC.Remove_Alarm();
+    return;
+  }
+
+  Serial.print("Next schedule time: "); Serial.print(NextTime);
+  Serial.print(", opening: "); Serial.print(NextOpening);
+  Serial.println(" <Arm_After>");
+
+  if (NextTime <= Private_RTC.Get_Time())
+    gScheduleAlarmFlag = true;
+  else
+    Private_RTC.Set_Alarm(NextTime, Schedule_Alarm_Interrupt);
+}
+
+/*
+ @brief   : 计算一个时间段在after之后的下一次动作，直接由时间算出，不需要逐分钟查找
+ @param   : 1.时间段
+            2.从这个时间之后开始找（不包括这个时间）
+            3.动作时间
+            4.动作的开度
+ @return  : true or false（该时间段已经没有动作）
+ */
+bool Schedule_Engine::Next_Event(const Schedule_Entry &entry, unsigned long after, unsigned long *event_time, unsigned char *opening)
+{
+  if (entry.Mode == SCHEDULE_DAILY)
+  {
+    unsigned long DayBase = after - after % SECONDS_PER_DAY;
+    unsigned long StartTime = DayBase + entry.Start % SECONDS_PER_DAY;
+    unsigned long EndTime = DayBase + entry.End % SECONDS_PER_DAY;
+
+    if (StartTime <= after) StartTime += SECONDS_PER_DAY;
+    if (EndTime <= after) EndTime += SECONDS_PER_DAY;
+
+    if (StartTime <= EndTime)
+    {
+      *event_time = StartTime;
+      *opening = entry.Opening;
+    }
+    else
+    {
+      *event_time = EndTime;
+      *opening = SCHEDULE_END_OPENING;
+    }
+    return true;
+  }
+  else if (entry.Mode == SCHEDULE_ONCE)
+  {
+    if (entry.Start > after)
+    {
+      *event_time = entry.Start;
+      *opening = entry.Opening;
+      return true;
+    }
+    if (entry.End > after)
+    {
+      *event_time = entry.End;
+      *opening = SCHEDULE_END_OPENING;
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ @brief   : 在主循环里调用。闹钟到时间后取出这次动作的开度，并设置下一次动作的闹钟
+ @param   : 这次动作的开度
+ @return  : true：需要卷膜；false：没有到时间
+ */
+bool Schedule_Engine::Fetch_Event(unsigned char *opening)
+{
+  if (!gScheduleAlarmFlag) return false;
+  gScheduleAlarmFlag = false;
+
+  if (!NextValidFlag) return false;
+
+  /*RTC被修改过，闹钟时间已经不对，重新设置*/
+  if (Private_RTC.Get_Time() < NextTime)
+  {
+    Arm();
+    return false;
+  }
+
+  *opening = NextOpening;
+  Arm_After(NextTime);
+  return true;
+}
@@ -0,0 +1,48 @@
+#ifndef _SCHEDULE_H
+#define _SCHEDULE_H
+
+#include <Arduino.h>
+#include "Memory.h"
+
+/*执行方式*/
+#define SCHEDULE_OFF          0x00  //关闭自动执行
+#define SCHEDULE_DAILY        0x01  //每天执行
+#define SCHEDULE_ONCE         0x02  //仅对该区间执行一次
+
+#define SCHEDULE_END_OPENING  0     //时间段结束时的开度：关棚
+
+/*一个定时卷膜时间段：开始时间卷到设定开度，结束时间关棚*/
+struct Schedule_Entry{
+  unsigned char Mode;
+  unsigned char Opening;
+  unsigned long Start;      //RTC秒数，每天执行时只用其中的时分秒
+  unsigned long End;
+};
+
+/*
+ * 本机定时卷膜。时间段表保存在EEPROM里，RAM里另有一份。
+ * 每个时间段的下一次动作时间直接由当前时间算出，取最早的一个设置RTC闹钟，
+ * 闹钟中断置位标志，主循环里执行卷膜并设置下一个闹钟。
+ */
+class Schedule_Engine{
+public:
+  void Load(void);
+  bool Set(unsigned char index, const Schedule_Entry &entry);
+  void Arm(void);
+  bool Fetch_Event(unsigned char *opening);
+
+private:
+  bool Next_Event(const Schedule_Entry &entry, unsigned long after, unsigned long *event_time, unsigned char *opening);
+  void Arm_After(unsigned long after);
+
+  Schedule_Entry Entry[SCHEDULE_NUM];
+  bool NextValidFlag;             //是否有下一次动作
+  unsigned long NextTime;         //下一次动作的时间
+  unsigned char NextOpening;      //下一次动作的开度
+};
+
+extern Schedule_Engine Roll_Schedule;
+
+extern volatile bool gScheduleAlarmFlag;
+
+#endif
@@ -64,6 +64,13 @@ void Check_Store_Parameter(void)
     }
     SelfCheckTryNum = 0;
 
+    /*工作组位图损坏，按已经自检通过的工作组号重新生成*/
+    if (!Roll_Operation.Verify_Group_Bitmap_Flag() || !Roll_Operation.Check_Group_Bitmap())
+    {
+        Serial.println("Group bitmap check ERROR !!! Rebuild from group number... <Check_Store_Parameter>");
+        Roll_Operation.Rebuild_Group_Bitmap();
+    }
+
     while (!Roll_Operation.Check_Area_Number())
     {
         Serial.println("Area number check ERROR !!! Applying area number to server... <Check_Store_Parameter>");
@@ -95,8 +102,11 @@ void Check_Store_Param_And_LoRa(void)
         LED_SELF_CHECK_ERROR;
 
         Check_LoRa_Parameter();
+        EEPROM_Operation.Param_Mirror_Verify();
         Check_Store_Parameter();
 
+        LoRa_Command_Analysis.Print_Rx_Statistics();
+
         Start_Self_Check_Timing();
         LED_RUNNING;
         Serial.println("All parameters check SUCCESS... <Check_Store_Parameter>");
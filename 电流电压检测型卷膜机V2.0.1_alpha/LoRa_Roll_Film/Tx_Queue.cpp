@@ -0,0 +1,456 @@
+/************************************************************************************
+ *
+ * LoRa发送队列。以前每条回执都要在发送函数里随机等待最长约1.7S、发送后再等待200ms，
+ * 卷膜过程中发回执时电流和限位检测都停在那里。现在回执组好帧后带上最早发送时间放入队列，
+ * 由1ms定时器中断按非阻塞方式写入串口，组一帧回执只需要几十微秒。
+ * 头文件中提供了各个类的公共接口。
+ *
+*************************************************************************************/
+
+#include "Tx_Queue.h"
+#include <libmaple/usart.h>
+#include <libmaple/iwdg.h>
+#include "LoRa.h"
+#include "fun_periph.h"
+
+/*槽状态*/
+#define SLOT_FREE       0
+#define SLOT_FILLING    1
+#define SLOT_READY      2
+#define SLOT_SENDING    3
+
+/*新的帧替换队列里同种还没有发送的帧*/
+#define LATEST_WINS(kind)   ((kind) == TX_KIND_STATUS || (kind) == TX_KIND_CURRENT)
+/*可以和其他帧合并成一包发送*/
+#define COMBINABLE(kind)    ((kind) != TX_KIND_OTHER)
+
+Transmit_Queue LoRa_Tx_Queue;
+
+/*
+ @brief   : 将一帧数据放入发送队列，马上返回（仅在主循环里调用）
+ @param   : 1.数据
+            2.数据长度
+            3.至少等待多久再发送（ms），用于回执的随机等待
+ @return  : true or false（队列已满，该帧被丢弃）
+ */
+bool Transmit_Queue::Push(const unsigned char *data, unsigned char len, unsigned long wait_ms)
+{
+  if (len == 0 || len > FRAME_MAX_LEN) return false;
+
+  signed char Index = Reserve();
+  if (Index < 0) return false;
+
+  memcpy(Slot[Index].Data, data, len);
+  Commit(Index, len, wait_ms, 1, TX_KIND_OTHER);
+  return true;
+}
+
+/*
+ @brief   : 占用一个空闲槽用来直接组帧（仅在主循环里调用）。组帧期间发送泵不会发送这个槽
+ @param   : 无
+ @return  : 槽下标，队列已满返回-1
+ */
+signed char Transmit_Queue::Reserve(void)
+{
+  for (unsigned char i = 0; i < TX_QUEUE_SIZE; i++)
+  {
+    if (Slot[i].State != SLOT_FREE) continue;
+
+    Slot[i].State = SLOT_FILLING;
+    Slot[i].AckFlag = false;
+    Slot[i].FixedFlag = false;
+    return i;
+  }
+
+  DropNum++;
+  Serial.println("LoRa Tx queue full, frame dropped !!! <Reserve>");
+  return -1;
+}
+
+/*
+ @brief   : 组帧完成，交给发送泵发送（仅在主循环里调用）
+ @param   : 1.Reserve()得到的槽下标
+            2.帧长度
+            3.至少等待多久再发送（ms），用于回执的随机等待
+            4.发送次数，每次之间保持发送间隔
+            5.回执种类。同种还没有发送的旧状态被替换；
+              和发送时间相差不超过TX_COMBINE_WINDOW的其他可合并帧对齐到其中最早的时间，一起发送
+ @return  : 无
+ */
+void Transmit_Queue::Commit(signed char index, unsigned char len, unsigned long wait_ms, unsigned char times, unsigned char kind)
+{
+  if (index < 0 || index >= TX_QUEUE_SIZE || Slot[index].State != SLOT_FILLING) return;
+
+  if (len == 0 || len > FRAME_MAX_LEN || times == 0)
+  {
+    Cancel(index);
+    return;
+  }
+
+  unsigned long SendTime = millis() + wait_ms;
+
+  /*关中断修改，发送泵看到等待发送状态时，发送时间等一定已经完整；正在发送的帧不会被替换*/
+  noInterrupts();
+  if (COMBINABLE(kind))
+  {
+    unsigned long OwnTime = SendTime;
+    for (unsigned char i = 0; i < TX_QUEUE_SIZE; i++)
+    {
+      if (i == index || Slot[i].State != SLOT_READY || !COMBINABLE(Slot[i].Kind)) continue;
+
+      if (LATEST_WINS(kind) && Slot[i].Kind == kind)
+      {
+        Slot[i].State = SLOT_FREE;
+        ReplaceNum++;
+        continue;
+      }
+
+      /*本帧的时间在时隙里时不提前，只让别的帧对齐过来*/
+      if (!Slot[index].FixedFlag && labs((long)(Slot[i].SendTime - OwnTime)) <= TX_COMBINE_WINDOW
+        && (long)(Slot[i].SendTime - SendTime) < 0)
+        SendTime = Slot[i].SendTime;
+    }
+    /*时间相近、可以移动的帧对齐到同一时间，到时一起发送；相差较远的帧仍按各自的时间发送*/
+    for (unsigned char i = 0; i < TX_QUEUE_SIZE; i++)
+    {
+      if (i == index || Slot[i].State != SLOT_READY || !COMBINABLE(Slot[i].Kind) || !Movable(i)) continue;
+
+      if (labs((long)(Slot[i].SendTime - SendTime)) <= TX_COMBINE_WINDOW)
+        Slot[i].SendTime = SendTime;
+    }
+  }
+
+  Slot[index].Length = len;
+  Slot[index].RepeatNum = times;
+  Slot[index].Kind = kind;
+  Slot[index].SentFlag = false;
+  Slot[index].SendTime = SendTime;
+  Slot[index].Sequence = SequenceNum++;
+  Slot[index].State = SLOT_READY;
+  interrupts();
+}
+
+/*
+ @brief   : 设置组好的帧需要服务器确认，在Commit()之前调用（仅在主循环里调用）。
+            Commit()的发送次数为1 + 最多重发次数，收到确认后不再重发
+ @param   : 1.Reserve()得到的槽下标
+            2.上行序号
+            3.第一次等待确认的时间（ms）
+ @return  : 无
+ */
+void Transmit_Queue::Expect_Ack(signed char index, unsigned char seq, unsigned int timeout)
+{
+  if (index < 0 || index >= TX_QUEUE_SIZE || Slot[index].State != SLOT_FILLING) return;
+
+  Slot[index].AckFlag = true;
+  Slot[index].AckSeq = seq;
+  Slot[index].Backoff = timeout;
+}
+
+/*
+ @brief   : 该帧的发送时间在群发回执时隙里，合并时不能移动，在Commit()之前调用（仅在主循环里调用）
+ @param   : 1.Reserve()得到的槽下标
+            2.时隙周期（ms），再次发送时加上整数个周期，仍在本机时隙里
+ @return  : 无
+ */
+void Transmit_Queue::Fix_Send_Time(signed char index, unsigned long period)
+{
+  if (index < 0 || index >= TX_QUEUE_SIZE || Slot[index].State != SLOT_FILLING || period == 0) return;
+
+  Slot[index].FixedFlag = true;
+  Slot[index].SlotPeriod = period;
+}
+
+/*
+ @brief   : 收到服务器的上行确认，不再重发该帧（仅在主循环里调用）。
+            正在发送的帧发完后释放
+ @param   : 上行序号
+ @return  : true or false（没有在等待确认的该序号帧，确认来晚了或重复确认）
+ */
+bool Transmit_Queue::Ack(unsigned char seq)
+{
+  bool AckOkFlag = false;
+
+  noInterrupts();
+  for (unsigned char i = 0; i < TX_QUEUE_SIZE; i++)
+  {
+    if (!Slot[i].AckFlag || Slot[i].AckSeq != seq) continue;
+
+    if (Slot[i].State == SLOT_READY)
+      Slot[i].State = SLOT_FREE;
+    else if (Slot[i].State == SLOT_SENDING)
+      Slot[i].RepeatNum = 1;
+    else
+      continue;
+
+    Slot[i].AckFlag = false;
+    AckNum++;
+    AckOkFlag = true;
+  }
+  interrupts();
+
+  return AckOkFlag;
+}
+
+/*
+ @brief   : 放弃Reserve()得到的槽（仅在主循环里调用）
+ @param   : 槽下标
+ @return  : 无
+ */
+void Transmit_Queue::Cancel(signed char index)
+{
+  if (index < 0 || index >= TX_QUEUE_SIZE || Slot[index].State != SLOT_FILLING) return;
+  Slot[index].State = SLOT_FREE;
+}
+
+/*
+ @brief   : 队列里是否有某种还没有发送完的回执（仅在主循环里调用）
+ @param   : 回执种类
+ @return  : true or false
+ */
+bool Transmit_Queue::Pending(unsigned char kind)
+{
+  for (unsigned char i = 0; i < TX_QUEUE_SIZE; i++)
+  {
+    if (Slot[i].State == SLOT_READY && Slot[i].Kind == kind) return true;
+  }
+  return false;
+}
+
+/*
+ @brief   : 找出已经到发送时间的帧，发送时间早的优先，相同时先入先出（仅在中断里调用）
+ @param   : 1.当前时间（ms）
+            2.是否只找能合并到本包里的帧
+            3.是否只找时隙里的帧
+ @return  : 槽下标，没有返回-1
+ */
+signed char Transmit_Queue::Find_Due_Frame(unsigned long now, bool combine_only, bool fixed_only)
+{
+  signed char Index = -1;
+
+  for (unsigned char i = 0; i < TX_QUEUE_SIZE; i++)
+  {
+    if (Slot[i].State != SLOT_READY || (long)(now - Slot[i].SendTime) < 0) continue;
+    if (fixed_only && !Slot[i].FixedFlag) continue;
+    if (combine_only && (!COMBINABLE(Slot[i].Kind) || BurstBytes + Slot[i].Length > TX_COMBINE_MAX_LEN)) continue;
+
+    if (Index < 0 || (long)(Slot[i].SendTime - Slot[Index].SendTime) < 0
+      || (Slot[i].SendTime == Slot[Index].SendTime && (long)(Slot[i].Sequence - Slot[Index].Sequence) < 0))
+      Index = i;
+  }
+  return Index;
+}
+
+/*
+ @brief   : 开始发送一帧（仅在中断里调用）
+ @param   : 槽下标
+ @return  : 无
+ */
+void Transmit_Queue::Start_Frame(unsigned char index)
+{
+  SendingIndex = index;
+  SentBytes = 0;
+  SendingFlag = true;
+  Slot[index].State = SLOT_SENDING;
+}
+
+/*
+ @brief   : 退避用的随机数，xorshift32（仅在中断里调用）。
+            种子由SN码生成，同一区域的设备退避时间各不相同
+ @param   : 无
+ @return  : 随机数
+ */
+unsigned long Transmit_Queue::Backoff_Random(void)
+{
+  if (BackoffSeed == 0) BackoffSeed = micros() | 1;
+
+  BackoffSeed ^= BackoffSeed << 13;
+  BackoffSeed ^= BackoffSeed >> 17;
+  BackoffSeed ^= BackoffSeed << 5;
+  return BackoffSeed;
+}
+
+/*
+ @brief   : 开始发送一包前先听信道（仅在中断里调用）。
+            LoRa模块在透传模式下没有信道忙的引脚，查询需要进入AT模式、停止收发泵，
+            这里用接收泵最近有没有收到字节作为信道忙的指示。
+            信道忙时在 [1, 2^n] 个退避单位里随机推迟，n为连续退避次数，最多LBT_BACKOFF_EXP_MAX。
+            一包连续退避超过LBT_DEFER_MAX次或LBT_DEFER_TIME_MAX时间后直接发送
+ @param   : 当前时间（ms）
+ @return  : true or false（信道忙或正在退避，这次不发送）
+ */
+bool Transmit_Queue::Listen_Before_Talk(unsigned long now)
+{
+  if (BackoffFlag)
+  {
+    if ((long)(now - BackoffEndTime) < 0) return false;
+    BackoffFlag = false;
+  }
+
+  if ((long)(now - LastRxTime) >= LBT_QUIET_TIME)
+  {
+    DeferTimes = 0;
+    return true;
+  }
+
+  if (DeferTimes >= LBT_DEFER_MAX || (DeferTimes > 0 && (long)(now - DeferStartTime) >= LBT_DEFER_TIME_MAX))
+  {
+    ForceNum++;
+    DeferTimes = 0;
+    return true;
+  }
+
+  if (DeferTimes == 0) DeferStartTime = now;
+  DeferTimes++;
+  DeferNum++;
+  if (DeferTimes > DeferMax) DeferMax = DeferTimes;
+
+  unsigned char Exp = (DeferTimes > LBT_BACKOFF_EXP_MAX) ? LBT_BACKOFF_EXP_MAX : DeferTimes;
+  BackoffEndTime = now + LBT_BACKOFF_UNIT + Backoff_Random() % ((unsigned long)LBT_BACKOFF_UNIT << Exp);
+  /*最后一次退避到总时间上限为止，保证Flush()等得到*/
+  if ((long)(BackoffEndTime - (DeferStartTime + LBT_DEFER_TIME_MAX)) > 0)
+    BackoffEndTime = DeferStartTime + LBT_DEFER_TIME_MAX;
+  BackoffFlag = true;
+  return false;
+}
+
+/*
+ @brief   : 发送泵，在1ms的LoRa接收泵定时器中断里调用。
+            只把串口能马上接收的字节写进去，不等待；9600波特率下每毫秒约能发送1个字节
+ @param   : 无
+ @return  : 无
+ */
+void Transmit_Queue::Transmit_Pump(void)
+{
+  unsigned long Now = millis();
+
+  if (!SendingFlag)
+  {
+    if (GapFlag)
+    {
+      if ((long)(Now - GapEndTime) < 0) return;
+      GapFlag = false;
+      Some_Peripheral.Start_LED();
+    }
+
+    signed char Index = Find_Due_Frame(Now, false);
+    if (Index < 0) return;
+    /*
+     *时隙里的帧由时隙保证互不冲突，不听信道，退避会把它推到其他设备的时隙里；
+     *别的帧在退避时，到时间的时隙帧照常发送。同一包里后面合并的帧紧接着写入，不再听信道
+     */
+    if (!Slot[Index].FixedFlag && !Listen_Before_Talk(Now))
+    {
+      Index = Find_Due_Frame(Now, false, true);
+      if (Index < 0) return;
+    }
+
+    Start_Frame(Index);
+    /*按地址收发时模块按硬件帧头里的地址发送，每一包前面加一次，合并进来的帧不再加*/
+    HeadRemain = LoRa_MHL9LF.Address_Mode() ? LORA_HW_HEAD_LEN : 0;
+    BurstBytes = HeadRemain;
+    Some_Peripheral.Stop_LED();
+  }
+
+  if (HeadRemain > 0)
+  {
+    HeadRemain -= usart_tx(LoRa_Serial.c_dev(), LoRa_MHL9LF.Tx_Hw_Head() + LORA_HW_HEAD_LEN - HeadRemain, HeadRemain);
+    if (HeadRemain > 0) return;
+  }
+
+  Tx_Frame *Frame = &Slot[SendingIndex];
+  SentBytes += usart_tx(LoRa_Serial.c_dev(), &Frame->Data[SentBytes], Frame->Length - SentBytes);
+
+  if (SentBytes >= Frame->Length)
+  {
+    BurstBytes += Frame->Length;
+    if (Frame->SentFlag && Frame->AckFlag) RetransmitNum++;
+    Frame->SentFlag = true;
+
+    /*
+     *还要再发送的帧在发送间隔过后再发，不会合并到同一包里。
+     *等待确认的帧在确认超时后才重发，超时时间每次加倍，最长TX_ACK_BACKOFF_MAX
+     */
+    if (--Frame->RepeatNum > 0)
+    {
+      unsigned long Delay = SEND_DATA_DELAY;
+      if (Frame->AckFlag)
+      {
+        Delay = Frame->Backoff;
+        Frame->Backoff = (Frame->Backoff * 2 > TX_ACK_BACKOFF_MAX) ? TX_ACK_BACKOFF_MAX : Frame->Backoff * 2;
+      }
+
+      /*时隙里的帧推到间隔之后的第一个本机时隙：本次时隙时间 + k × 时隙周期*/
+      if (Frame->FixedFlag)
+      {
+        unsigned long Late = Now + Delay - Frame->SendTime;
+        Frame->SendTime += ((Late + Frame->SlotPeriod - 1) / Frame->SlotPeriod) * Frame->SlotPeriod;
+      }
+      else
+        Frame->SendTime = Now + Delay;
+      Frame->State = SLOT_READY;
+    }
+    else
+    {
+      if (Frame->AckFlag) AckFailNum++;
+      Frame->State = SLOT_FREE;
+    }
+    SendingFlag = false;
+
+    /*同时到发送时间的可合并帧紧接着写入串口，不留间隔，LoRa模块作为一包发送*/
+    if (COMBINABLE(Frame->Kind))
+    {
+      signed char Next = Find_Due_Frame(Now, true);
+      if (Next >= 0)
+      {
+        CombineNum++;
+        Start_Frame(Next);
+        return;
+      }
+    }
+
+    GapFlag = true;
+    GapEndTime = Now + SEND_DATA_DELAY;
+  }
+}
+
+/*
+ @brief   : 发送队列是否已经全部发完（包括最后一帧之后的发送间隔）。
+            正在组帧的槽、已经发送过正在等待确认的帧不算，后者在接收泵重新启动后继续按超时重发
+ @param   : 无
+ @return  : true or false
+ */
+bool Transmit_Queue::Idle(void)
+{
+  if (SendingFlag || GapFlag) return false;
+
+  for (unsigned char i = 0; i < TX_QUEUE_SIZE; i++)
+  {
+    if (Slot[i].State == SLOT_SENDING) return false;
+    if (Slot[i].State == SLOT_READY && !(Slot[i].AckFlag && Slot[i].SentFlag)) return false;
+  }
+  return true;
+}
+
+/*
+ @brief   : 等待发送队列全部发完（仅在主循环里调用）。
+            进入AT模式前必须先调用，否则AT指令会插在回执帧中间发出去。发送泵需要在运行
+ @param   : 最长等待时间（ms）
+ @return  : true or false（超时，还没发送的帧留在队列里）
+ */
+bool Transmit_Queue::Flush(unsigned long timeout)
+{
+  unsigned long StartTime = millis();
+
+  while (!Idle())
+  {
+    /*正在发送的帧一定要发完，超时只放弃还没开始发送的帧*/
+    if (!SendingFlag && millis() - StartTime >= timeout)
+    {
+      Serial.println("LoRa Tx queue flush timeout !!! <Flush>");
+      return false;
+    }
+    iwdg_feed();
+  }
+  return true;
+}
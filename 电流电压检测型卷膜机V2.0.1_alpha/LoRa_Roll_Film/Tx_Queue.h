@@ -0,0 +1,122 @@
+#ifndef _TX_QUEUE_H
+#define _TX_QUEUE_H
+
+#include <Arduino.h>
+#include "Command_Analysis.h"
+
+#define TX_QUEUE_SIZE       6     //发送队列容量（帧数）
+#define SEND_DATA_DELAY     200   //LoRa模块发送完一帧数据后的间隔时间（ms）
+#define TX_FLUSH_TIMEOUT    5000  //等待发送队列发完的最长时间（ms），大于最长的随机等待时间（约1.7S）加上最长的信道忙退避时间LBT_DEFER_TIME_MAX
+#define TX_COMBINE_MAX_LEN  96    //连续发送合并成一包的最大字节数，在LoRa模块单包长度以内
+#define TX_COMBINE_WINDOW   100   //发送时间相差在这个范围内的可合并帧才对齐到同一时间，合并成一包（ms）
+#define TX_ACK_BACKOFF_MAX  8000  //等待确认重发的最长间隔（ms）
+
+/*发送前先听信道：LoRa模块正在往串口输出收到的数据，说明信道上有其他设备在发送*/
+#define LBT_QUIET_TIME      30    //最后收到一个字节后，多久没有新的字节才认为信道空闲（ms）
+#define LBT_BACKOFF_UNIT    50    //信道忙退避的基本时间（ms）
+#define LBT_BACKOFF_EXP_MAX 5     //退避窗口最多加倍的次数，最大窗口50 << 5 = 1600ms
+#define LBT_DEFER_MAX       8     //连续退避的最多次数，之后不再等待，直接发送，避免一直发不出去
+#define LBT_DEFER_TIME_MAX  2000  //一包连续退避的最长总时间（ms），到时间后直接发送。8次退避最长约8.3S，不限制时会超过TX_FLUSH_TIMEOUT
+
+/*回执种类，决定队列里还没有发送的帧能否被替换、能否合并发送*/
+#define TX_KIND_OTHER       0     //不替换、不合并
+#define TX_KIND_GENERAL     1     //通用回执，可以和状态合并成一包
+#define TX_KIND_STATUS      2     //工作状态E014/E017，新的替换还没有发送的旧状态，可以合并
+#define TX_KIND_CURRENT     3     //实时电流E016，新的替换旧的，可以合并
+
+/*队列中的一帧待发送数据*/
+struct Tx_Frame{
+  unsigned char Data[FRAME_MAX_LEN];
+  unsigned char Length;
+  volatile unsigned char State;   //槽状态：空闲、正在组帧、等待发送、正在发送
+  unsigned char RepeatNum;        //还要发送的次数，同一帧多次发送时不用复制
+  unsigned char Kind;             //回执种类
+  bool AckFlag;                   //是否在等待服务器确认，确认后不再重发
+  unsigned char AckSeq;           //上行序号
+  bool SentFlag;                  //已经发送过一次，正在等待确认或重发
+  bool FixedFlag;                 //发送时间由群发回执时隙决定，合并时不能移动，发送前不听信道
+  unsigned long SlotPeriod;       //时隙周期（时隙个数 × 时隙宽度，ms），重发时只落在本机时隙里
+  unsigned int Backoff;           //下一次重发前等待确认的时间（ms），每重发一次加倍
+  unsigned long SendTime;         //最早的发送时间（ms）
+  unsigned long Sequence;         //入队序号，发送时间相同时先入先出
+};
+
+/*
+ * LoRa发送队列。主循环里组好回执帧后放入队列马上返回，不再等待随机时间和发送间隔；
+ * 1ms的LoRa接收泵定时器中断同时做发送泵，到了发送时间的帧按非阻塞方式逐字节写入串口，
+ * 每帧之间保持SEND_DATA_DELAY的间隔。
+ * 回执可以先Reserve()一个槽，直接在槽里组帧，再Commit()，不需要另外的缓存。
+ * 同种状态回执只保留最新的一帧；通用回执和状态回执的发送时间相差不超过TX_COMBINE_WINDOW时，
+ * 对齐到同一时间连续写入串口，中间不留发送间隔，LoRa模块把它们作为一包发出去。
+ * 群发回执时隙里的帧、等待确认重发的帧不移动发送时间，只让别的帧对齐到它们。
+ * 时隙里的帧不听信道，再次发送和确认超时重发都推到后面某个周期的本机时隙。
+ * 需要确认的帧发送后等待服务器确认，超时按加倍的间隔重发，收到确认或次数用完后释放。
+ * 每包开始发送前先听信道，接收泵最近收到过字节时认为信道忙，按随机的指数退避时间推迟，
+ * 整个区域同时回复群发指令时减少互相碰撞。
+ * Push()、Reserve()、Commit()、Cancel()、Flush()只在主循环里调用，Transmit_Pump()只在定时器中断里调用。
+ */
+class Transmit_Queue{
+public:
+  bool Push(const unsigned char *data, unsigned char len, unsigned long wait_ms);
+  signed char Reserve(void);
+  unsigned char *Slot_Data(signed char index) {return Slot[index].Data;}
+  void Commit(signed char index, unsigned char len, unsigned long wait_ms, unsigned char times, unsigned char kind);
+  void Cancel(signed char index);
+  void Expect_Ack(signed char index, unsigned char seq, unsigned int timeout);
+  void Fix_Send_Time(signed char index, unsigned long period);
+  bool Ack(unsigned char seq);
+  void Transmit_Pump(void);
+  bool Flush(unsigned long timeout);
+  bool Idle(void);
+  bool Pending(unsigned char kind);
+  void Channel_Activity(void) {LastRxTime = millis();}
+  void Seed_Backoff(unsigned long seed) {BackoffSeed = seed | 1;}
+
+  unsigned long Drop_Num(void) {return DropNum;}
+  unsigned long Replace_Num(void) {return ReplaceNum;}
+  unsigned long Combine_Num(void) {return CombineNum;}
+  unsigned long Retransmit_Num(void) {return RetransmitNum;}
+  unsigned long Ack_Num(void) {return AckNum;}
+  unsigned long Ack_Fail_Num(void) {return AckFailNum;}
+  unsigned long Defer_Num(void) {return DeferNum;}
+  unsigned long Force_Num(void) {return ForceNum;}
+  unsigned long Defer_Max(void) {return DeferMax;}
+
+private:
+  signed char Find_Due_Frame(unsigned long now, bool combine_only, bool fixed_only = false);
+  bool Movable(unsigned char index) {return !Slot[index].FixedFlag && !(Slot[index].SentFlag && Slot[index].AckFlag);}
+  void Start_Frame(unsigned char index);
+  bool Listen_Before_Talk(unsigned long now);
+  unsigned long Backoff_Random(void);
+
+  Tx_Frame Slot[TX_QUEUE_SIZE];
+  unsigned long SequenceNum;
+  unsigned long DropNum;                  //队列满被丢弃的帧数
+  unsigned long ReplaceNum;               //被新状态替换、没有发送的帧数
+  volatile unsigned long CombineNum;      //合并到前一帧同一包里发送的帧数
+  volatile unsigned long RetransmitNum;   //没有收到确认而重发的次数
+  unsigned long AckNum;                   //收到确认的帧数
+  volatile unsigned long AckFailNum;      //重发次数用完仍没有收到确认的帧数
+  volatile unsigned long DeferNum;        //信道忙推迟发送的次数
+  volatile unsigned long ForceNum;        //连续退避次数用完，信道忙仍然发送的包数
+  volatile unsigned char DeferMax;        //一包发送前连续退避的最多次数
+
+  volatile bool SendingFlag;              //是否有帧正在发送
+  volatile unsigned char SendingIndex;    //正在发送的槽
+  volatile unsigned char SentBytes;       //正在发送的帧已经写入串口的字节数
+  volatile unsigned char HeadRemain;      //按地址收发时，本包的硬件帧头还没有写入串口的字节数
+  volatile unsigned char BurstBytes;      //本包已经连续写入串口的字节数
+  volatile bool GapFlag;                  //刚发送完一帧，正在等待发送间隔
+  volatile unsigned long GapEndTime;      //发送间隔结束的时间
+
+  volatile unsigned long LastRxTime;      //接收泵最后一次收到字节的时间
+  unsigned long BackoffSeed;              //退避随机数状态，在中断里生成，不用库函数random()
+  bool BackoffFlag;                       //信道忙，正在退避
+  unsigned long BackoffEndTime;           //退避结束的时间
+  unsigned char DeferTimes;               //当前这包已经连续退避的次数
+  unsigned long DeferStartTime;           //当前这包第一次退避的时间
+};
+
+extern Transmit_Queue LoRa_Tx_Queue;
+
+#endif
@@ -40,4 +40,24 @@ unsigned char GetCrc8(unsigned char * data, int length)
    //Serial.println();
    return cFcs;
  
-}
\ No newline at end of file
+}
+
+/*
+ @brief   : 逐字节累加计算CRC8，结果与GetCrc8()相同。
+            用于数据不在连续缓存里（如环形缓存）的场合，初始值为0。
+ @param   : 1.上一次的CRC8值
+            2.新的一个字节
+ @return  : 新的CRC8值
+ */
+unsigned char Crc8_Update(unsigned char crc, unsigned char data)
+{
+   crc ^= data;
+   for (unsigned char j = 0; j < 8; j++)
+   {
+      if (crc & 1)
+         crc = (unsigned char)((crc >> 1) ^ AL2_FCS_COEF);
+      else
+         crc >>= 1;
+   }
+   return crc;
+}
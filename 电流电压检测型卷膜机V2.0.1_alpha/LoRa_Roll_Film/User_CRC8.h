@@ -6,5 +6,6 @@ typedef unsigned short WORD;
 
 
 unsigned char GetCrc8(unsigned char * data, int length);
+unsigned char Crc8_Update(unsigned char crc, unsigned char data);
 
 #endif /*_USER_CRC_H_ */
\ No newline at end of file
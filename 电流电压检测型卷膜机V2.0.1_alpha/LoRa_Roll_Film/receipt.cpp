@@ -1,48 +1,190 @@
 #include "receipt.h"
-#include "User_CRC8.h"
 #include <libmaple/iwdg.h>
 #include "LoRa.h"
 #include "Motor.h"
 #include "Memory.h"
 #include "Command_Analysis.h"
 #include "public.h"
+#include "Private_RTC.h"
+#include "BCD_CON.h"
+#include "Tx_Queue.h"
+#include "Frame_Writer.h"
 
 Receipt Message_Receipt;
 
 #define CLEAR_BUFFER_FLAG   0 //是否清除服务器数据
 
-#define SEND_DATA_DELAY     200 //发送完一帧数据后延时时间（ms）
-
 unsigned char gMotorStatus = MotorFactoryMode;  //每次开机默认状态未初始化
 
-unsigned char gLoRaCSQ[2] = {0};  //接收LoRa发送和接收的信号强度
+
+/*
+ * 各回执帧的布局：帧ID、数据长度，以及按帧格式逐项相加的字段长度。
+ * Layout_Frame_Writer在编译时检查两者是否一致。
+ */
+struct E011_Layout{
+  static constexpr unsigned int FrameID = 0xE011;
+  static constexpr unsigned char DataLen = 0x24;
+  /*设备类型2 + 群发标志1 + 区域号1 + 工作组号5 + SN码9 + 路数1 + 采集间隔2 + RTC 7 + 预留8*/
+  static constexpr unsigned char FieldLen = 2 + 1 + 1 + 5 + 9 + 1 + 2 + 7 + 8;
+};
+
+struct E012_Layout{
+  static constexpr unsigned int FrameID = 0xE012;
+  static constexpr unsigned char DataLen = 0x05;
+  /*设备类型2 + 群发标志1 + 区域号1 + 路数1*/
+  static constexpr unsigned char FieldLen = 2 + 1 + 1 + 1;
+};
+
+struct E013_Layout{
+  static constexpr unsigned int FrameID = 0xE013;
+  static constexpr unsigned char DataLen = 0x05;
+  /*设备类型2 + 群发标志1 + 区域号1 + 路数1*/
+  static constexpr unsigned char FieldLen = 2 + 1 + 1 + 1;
+};
+
+struct E014_Layout{
+  static constexpr unsigned int FrameID = 0xE014;
+  static constexpr unsigned char DataLen = 0x1A;
+  /*设备类型2 + 群发标志1 + 区域号1 + 路数1 + 设备状态1 + 电压2 + 信号强度2 + 预留16*/
+  static constexpr unsigned char FieldLen = 2 + 1 + 1 + 1 + 1 + 2 + 2 + 16;
+};
+
+struct E015_Layout{
+  static constexpr unsigned int FrameID = 0xE015;
+  static constexpr unsigned char DataLen = 0x0E;
+  /*设备类型2 + 群发标志1 + 区域号1 + 路数1 + 回执状态1 + 预留8*/
+  static constexpr unsigned char FieldLen = 2 + 1 + 1 + 1 + 1 + 8;
+};
+
+struct E016_Layout{
+  static constexpr unsigned int FrameID = 0xE016;
+  static constexpr unsigned char DataLen = 0x14;
+  /*设备类型2 + 群发标志1 + 区域号1 + 工作组号1 + 路数1 + 电流3 + 已工作时间3 + 预留8，与协议2.4相同*/
+  static constexpr unsigned char FieldLen = 2 + 1 + 1 + 1 + 1 + 3 + 3 + 8;
+};
 
 /*
  @brief   : 清除服务器上一次接收的LoRa数据缓存
- @param   : 无
+ @param   : 随机等待时间（us），与后面的回执相同
  @return  : 无
 */
-void Receipt::Clear_Server_LoRa_Buffer(void)
+void Receipt::Clear_Server_LoRa_Buffer(unsigned long int wait_us)
 {
   /*发送一帧帧尾，让服务器认为接收到了完成数据，清空缓存*/
   unsigned char Buffer[6] = {0x0D, 0x0A, 0x0D, 0x0A, 0x0D, 0x0A};
-  LoRa_Serial.write(Buffer, 6);
-  delay(SEND_DATA_DELAY);
+  LoRa_Tx_Queue.Push(Buffer, 6, wait_us / 1000);
 }
 
 /*
- @brief   : 随机生成回执消息的回执发送微秒延时
- @param   : 随机延时（ms）
+ @brief   : 补上校验码和帧尾，打印后交给LoRa发送队列，马上返回。发送间隔由发送队列保证
+ @param   : 1.已经写好数据的回执帧
+            2.随机等待时间（us），到时间后才发送
+            3.发送次数
+            4.回执种类，队列里同种还没有发送的旧状态被替换，发送时间相近的通用回执和状态合并成一包发送
+ @return  : true or false（队列已满或帧长度不对，该帧没有放入队列）
+*/
+bool Receipt::Send_Frame(Frame_Writer &writer, unsigned long int wait_us, unsigned char times, unsigned char kind)
+{
+  unsigned char AckConfig[UPLINK_ACK_CONFIG_LEN];
+  bool AckFlag = Uplink_Ack_Config(kind, AckConfig);
+  bool FixedFlag = SlotWaitFlag;
+
+  SlotWaitFlag = false;
+
+  /*确认模式下在数据末尾加上行序号，组帧时已经按Uplink_Trailer_Len()留出长度*/
+  if (AckFlag) writer.Put_Byte(UplinkSeq);
+
+  if (!writer.Finish()) return false;
+
+  Print_Debug(writer.Frame(), writer.Length());
+  /*时隙里的回执不能被合并提前或推后，否则会和其他设备的时隙重叠*/
+  if (FixedFlag) writer.Fix_Send_Time(SlotPeriod);
+  if (AckFlag)
+  {
+    /*不再按固定次数盲发，没有收到确认时按加倍的超时重发*/
+    writer.Expect_Ack(UplinkSeq, AckConfig[2] * UPLINK_ACK_TIMEOUT_UNIT);
+    writer.Send(wait_us, 1 + AckConfig[1], kind);
+    UplinkSeq++;
+  }
+  else
+    writer.Send(wait_us, times, kind);
+  return true;
+}
+
+/*
+ @brief   : 读取上行确认方式，判断这种回执是否需要服务器确认。只有通用回执和状态回执需要确认
+ @param   : 1.回执种类
+            2.确认方式1 + 最多重发次数1 + 第一次等待确认时间1（100ms）
+ @return  : true or false
+ */
+bool Receipt::Uplink_Ack_Config(unsigned char kind, unsigned char *config)
+{
+  if (kind != TX_KIND_GENERAL && kind != TX_KIND_STATUS) return false;
+
+  return (Roll_Operation.Read_Uplink_Ack_Config(config) && config[0] == UPLINK_ACK_ON);
+}
+
+/*
+ @brief   : 这种回执数据末尾的上行序号长度，组帧时加到数据长度里
+ @param   : 回执种类
+ @return  : 长度（byte）
+ */
+unsigned char Receipt::Uplink_Trailer_Len(unsigned char kind)
+{
+  unsigned char AckConfig[UPLINK_ACK_CONFIG_LEN];
+  return Uplink_Ack_Config(kind, AckConfig) ? UPLINK_SEQ_LEN : 0;
+}
+
+/*
+ @brief   : 生成回执消息的回执发送微秒延时。
+            群发指令在服务器设置了回执时隙时，按本机时隙等待，所有设备在时隙个数 × 时隙宽度内回执完，互不冲突；
+            否则随机等待
+ @param   : 延时（us）
  @return  : 无
  */
 void Receipt::Receipt_Random_Wait_Value(unsigned long int *random_value)
 {
+  SlotWaitFlag = (gMassCommandFlag && Reply_Slot_Wait_Value(random_value, &SlotPeriod));
+  if (SlotWaitFlag) return;
+
   unsigned char RandomSeed;
   SN.Read_Random_Seed(&RandomSeed); //读取随机数种子
   /*RandomSeed * 1ms, 1.5S + RandomSeed * 0.1ms, 200ms*/
   *random_value = random(RandomSeed * 1000, 1500000) + random(RandomSeed *100, 200000);
 }
 
+/*
+ @brief   : 按群发回执时隙计算回执等待时间。
+            服务器指定了时隙号（如按工作组内的序号分配）时直接使用，互不冲突；
+            没有指定时用SN码末两字节（出厂流水号）对时隙个数取余，流水号连续的设备不会冲突
+ @param   : 1.等待时间（us）
+            2.时隙周期（ms），所有设备回执一轮的时间
+ @return  : true or false（没有设置回执时隙）
+ */
+bool Receipt::Reply_Slot_Wait_Value(unsigned long int *wait_value, unsigned long *period)
+{
+  unsigned char Config[REPLY_SLOT_CONFIG_LEN];
+
+  if (!Roll_Operation.Read_Reply_Slot_Config(Config)) return false;
+
+  unsigned char SlotWidth = Config[0];
+  unsigned int SlotNum = (Config[1] << 8) | Config[2];
+  unsigned int SlotIndex = (Config[3] << 8) | Config[4];
+
+  if (SlotWidth == 0 || SlotNum == 0) return false;
+
+  if (SlotIndex == REPLY_SLOT_BY_SN || SlotIndex >= SlotNum)
+  {
+    unsigned char SN_Code[9];
+    if (!SN.Read_SN_Code(SN_Code)) return false;
+    SlotIndex = ((SN_Code[7] << 8) | SN_Code[8]) % SlotNum;
+  }
+
+  *wait_value = (unsigned long)SlotIndex * SlotWidth * REPLY_SLOT_UNIT * 1000;
+  *period = (unsigned long)SlotNum * SlotWidth * REPLY_SLOT_UNIT;
+  return true;
+}
+
 /*
  @brief   : 上报本设备通用设置参数,包括区域号、SN码、子设备路数、工作组号、采集间隔等（本机 ---> 服务器）
             该回执帧也用作设备第一次申请注册服务器。
@@ -55,63 +197,43 @@ void Receipt::Report_General_Parameter(void)
   //Frame head | Frame ID | Data Length | Device type ID | mass flag | Area number   | workgroup | SN code | channel | collect interval  |  RTC   |   allocate  |  CRC8   |  Frame end
   //  1 byte       2 byte      1 byte          2 byte       1 byte       1 byte          5 byte     9 byte    1 byte      2 byte           7 byte      8 byte     1 byte      6 byte
   
-  unsigned char ReportFrame[64] = {0};
-  unsigned char FrameLength = 0; 
   unsigned char DataTemp[10];
   unsigned long int RandomSendInterval = 0;
     
   Receipt_Random_Wait_Value(&RandomSendInterval);
-  delayMicroseconds(RandomSendInterval);
-  iwdg_feed();
 
 #if CLEAR_BUFFER_FLAG
-  Clear_Server_LoRa_Buffer();
+  Clear_Server_LoRa_Buffer(RandomSendInterval);
 #endif
 
-  ReportFrame[FrameLength++] = 0xFE; //帧头
-  ReportFrame[FrameLength++] = 0xE0; //帧ID
-  ReportFrame[FrameLength++] = 0x11;  
-  ReportFrame[FrameLength++] = 0x24; //帧有效数据长度
-  /*设备类型*/
-  ReportFrame[FrameLength++] = highByte(DEVICE_TYPE_ID);
-  ReportFrame[FrameLength++] = lowByte(DEVICE_TYPE_ID);
-  /*是否是群发*/
-  gMassCommandFlag == true ? ReportFrame[FrameLength++] = 0x55 : ReportFrame[FrameLength++] = 0x00;
-  /*区域号*/
-  ReportFrame[FrameLength++] = Roll_Operation.Read_Area_Number();
+  Layout_Frame_Writer<E011_Layout> Frame;
+  /*设备类型、群发标志、区域号*/
+  Frame.Put_Device_Head();
   /*组号*/
   Roll_Operation.Read_Group_Number(&DataTemp[0]);
-  for (unsigned char i = 0; i < 5; i++)
-    ReportFrame[FrameLength++] = DataTemp[i];
+  Frame.Put_Bytes(DataTemp, 5);
   /*SN码*/
   SN.Read_SN_Code(&DataTemp[0]);
-  for (unsigned char i = 0; i < 9; i++)
-    ReportFrame[FrameLength++] = DataTemp[i];
+  Frame.Put_Bytes(DataTemp, 9);
   /*路数*/
-  ReportFrame[FrameLength++] = 0x01; //卷膜机默认只有一路
+  Frame.Put_Byte(0x01); //卷膜机默认只有一路
   /*采集状态间隔*/
-  ReportFrame[FrameLength++] = 0x00; 
-  ReportFrame[FrameLength++] = 0x00; 
-  /*RTC*/
-  for (unsigned char i = 0; i < 7; i++)
-    ReportFrame[FrameLength++] = 0x00; 
+  Frame.Put_Zero(2);
+  /*RTC，BCD码，如20 19 09 24 13 24 14。RTC没有校准过时全为0*/
+  if (Private_RTC.Time_Valid(Private_RTC.Get_Time()))
+  {
+    Private_RTC.Get_RTC(&DataTemp[0]);
+    for (unsigned char i = 0; i < 7; i++)
+      Frame.Put_Byte(ByteTOBcd(DataTemp[i]));
+  }
+  else
+    Frame.Put_Zero(7);
   /*预留的8个字节*/
-  for (unsigned char i = 0; i < 8; i++)  
-    ReportFrame[FrameLength++] = 0x00;
-  /*CRC8*/
-  ReportFrame[FrameLength++] = GetCrc8(&ReportFrame[4], 0x24);
-  /*帧尾*/
-  for (unsigned char i = 0; i < 6; i++)
-    i % 2 == 0 ? ReportFrame[FrameLength++] = 0x0D : ReportFrame[FrameLength++] = 0x0A;
+  Frame.Put_Zero(8);
 
+  Record.SentFlags |= RECEIPT_SENT_REPORT;
   Serial.println("Report general parameter...");
-  /*打印要发送的数据帧*/
-  Print_Debug(&ReportFrame[0], FrameLength);
-
-  Some_Peripheral.Stop_LED();
-  LoRa_Serial.write(&ReportFrame[0], FrameLength);  
-  delay(SEND_DATA_DELAY);
-  Some_Peripheral.Start_LED();
+  Send_Frame(Frame, RandomSendInterval, 1, TX_KIND_OTHER);
 }
 
 /*
@@ -125,46 +247,22 @@ void Receipt::Request_Set_Group_Number(void)
   //Frame head | Frame ID | Data Length | Device type ID | mass flag | Area number  | Device channel |  CRC8  |  Frame end
   //  1 byte        2 byte      1 byte          2 byte       1 byte       1 byte          1 byte       1 byte     6 byte
   
-  unsigned char RequestFrame[20] = {0};
-  unsigned char FrameLength = 0;
-  unsigned char RandomSeed;
   unsigned long int RandomSendInterval = 0;
     
   Receipt_Random_Wait_Value(&RandomSendInterval);
-  delayMicroseconds(RandomSendInterval);
-  iwdg_feed();
 
 #if CLEAR_BUFFER_FLAG
-  Clear_Server_LoRa_Buffer();
+  Clear_Server_LoRa_Buffer(RandomSendInterval);
 #endif
 
-  RequestFrame[FrameLength++] = 0xFE; //帧头
-  RequestFrame[FrameLength++] = 0xE0; //帧ID
-  RequestFrame[FrameLength++] = 0x12;
-  RequestFrame[FrameLength++] = 0x05; //帧有效数据长度
-  /*设备ID*/
-  RequestFrame[FrameLength++] = highByte(DEVICE_TYPE_ID); 
-  RequestFrame[FrameLength++] = lowByte(DEVICE_TYPE_ID);
-  /*是否是群发*/
-  gMassCommandFlag == true ? RequestFrame[FrameLength++] = 0x55 : RequestFrame[FrameLength++] = 0x00;
-  /*区域号*/
-  RequestFrame[FrameLength++] = Roll_Operation.Read_Area_Number();  
+  Layout_Frame_Writer<E012_Layout> Frame;
+  /*设备类型、群发标志、区域号*/
+  Frame.Put_Device_Head();
   /*设备路数*/
-  RequestFrame[FrameLength++] = 0x01; 
-  /*CRC8*/
-  RequestFrame[FrameLength++] = GetCrc8(&RequestFrame[4], 0x05);
-  /*帧尾*/
-  for (unsigned char i = 0; i < 6; i++)
-    i % 2 == 0 ? RequestFrame[FrameLength++] = 0x0D : RequestFrame[FrameLength++] = 0x0A;
+  Frame.Put_Byte(0x01); 
 
   Serial.println("Requeset SN code to access network...");
-  /*打印要发送的数据帧*/
-  Print_Debug(&RequestFrame[0], FrameLength);
-
-  Some_Peripheral.Stop_LED();
-  LoRa_Serial.write(&RequestFrame[0], FrameLength);
-  delay(SEND_DATA_DELAY); 
-  Some_Peripheral.Start_LED(); 
+  Send_Frame(Frame, RandomSendInterval, 1, TX_KIND_OTHER);
 }
 
 /*
@@ -178,139 +276,283 @@ void Receipt::Request_Device_SN_and_Channel(void)
   //Frame head | Frame ID | Data Length | Device type ID |  mass flag |  Area number | Device channel |  CRC8  |  Frame end
   //  1 byte        2 byte      1 byte          2 byte        1 byte      1 byte          1 byte       1 byte     6 byte
 
-  unsigned char RequestFrame[20] = {0};
-  unsigned char FrameLength = 0;
-  unsigned char RandomSeed;
   unsigned long int RandomSendInterval = 0;
     
   Receipt_Random_Wait_Value(&RandomSendInterval);
-  delayMicroseconds(RandomSendInterval);
-  iwdg_feed();
 
 #if CLEAR_BUFFER_FLAG
-  Clear_Server_LoRa_Buffer();
+  Clear_Server_LoRa_Buffer(RandomSendInterval);
 #endif
 
-  RequestFrame[FrameLength++] = 0xFE; //帧头
-  RequestFrame[FrameLength++] = 0xE0; //帧ID
-  RequestFrame[FrameLength++] = 0x13;
-  RequestFrame[FrameLength++] = 0x05; //帧有效数据长度
-  /*设备ID*/
-  RequestFrame[FrameLength++] = highByte(DEVICE_TYPE_ID); 
-  RequestFrame[FrameLength++] = lowByte(DEVICE_TYPE_ID);
-  /*是否是群发*/
-  gMassCommandFlag == true ? RequestFrame[FrameLength++] = 0x55 : RequestFrame[FrameLength++] = 0x00;
-  /*区域号*/
-  RequestFrame[FrameLength++] = Roll_Operation.Read_Area_Number();  
+  Layout_Frame_Writer<E013_Layout> Frame;
+  /*设备类型、群发标志、区域号*/
+  Frame.Put_Device_Head();
   /*设备路数*/
-  RequestFrame[FrameLength++] = 0x01; 
-  /*CRC8*/
-  RequestFrame[FrameLength++] = GetCrc8(&RequestFrame[4], 0x05);
-  /*帧尾*/
-  for (unsigned char i = 0; i < 6; i++)
-    i % 2 == 0 ? RequestFrame[FrameLength++] = 0x0D : RequestFrame[FrameLength++] = 0x0A;
+  Frame.Put_Byte(0x01); 
 
   Serial.println("Requeset SN code to access network...");
-  /*打印要发送的数据帧*/
-  Print_Debug(&RequestFrame[0], FrameLength);
-
-  Some_Peripheral.Stop_LED();
-  LoRa_Serial.write(&RequestFrame[0], FrameLength);
-  delay(SEND_DATA_DELAY);
-  Some_Peripheral.Start_LED();
+  Send_Frame(Frame, RandomSendInterval, 1, TX_KIND_OTHER);
 }
 
 /*
- @brief   : 上报实时详细工作状态（本机 ---> 服务器）
- @param   : 上报次数
+ @brief   : 上报工作状态（本机 ---> 服务器）。卷膜机的状态变化、卷膜过程中的定时上报都调用这里。
+            服务器没有协商过紧凑上报时发送完整的E014；协商过后改发E017，状态没有变化、
+            各项变化都在死区以内时不上报，紧凑上报只发送一次
+ @param   : 1.是否随机等待
+            2.完整上报时的发送次数
  @return  : 无
  */
 void Receipt::Working_Parameter_Receipt(bool use_random_wait, unsigned char times)
+{
+  unsigned char Config[STATUS_REPORT_CONFIG_LEN];
+
+  if (Roll_Operation.Read_Status_Report_Config(Config) && Config[0] == STATUS_REPORT_COMPACT)
+    Compact_Status_Receipt(use_random_wait, Config);
+  else
+    Full_Working_Receipt(use_random_wait, times);
+}
+
+/*
+ @brief   : 取一次上报用的工作状态。开度、电流、电压从遥测快照复制，不现场采集ADC
+ @param   : 工作状态
+ @return  : 无
+ */
+void Receipt::Sample_Status(Status_Baseline *sample)
+{
+  const Telemetry_Snapshot &Telemetry = Motor_Operation.Telemetry_Data();
+
+  sample->Status  = Read_Motor_Status();
+  sample->Opening = Telemetry.Opening;
+  sample->Current = Telemetry.Current;
+  sample->Voltage = Telemetry.Voltage;
+}
+
+/*
+ @brief   : 上报完整的实时详细工作状态E014（本机 ---> 服务器）。
+            服务器查询状态、重复指令重发回执时总是发送完整状态
+ @param   : 1.是否随机等待
+            2.上报次数
+ @return  : 无
+ */
+void Receipt::Full_Working_Receipt(bool use_random_wait, unsigned char times)
 {  
   //  帧头     |    帧ID   |  数据长度   |    设备类型ID   | 群发标志位 | 所在执行区域号 | 设备路数       | 设备状态        | 电压     |  RSSI  |  CSQ    | 预留位  | 校验码  | 帧尾 
   //Frame head | Frame ID | Data Length | Device type ID | mass flag | Area number   | Device channel |  device status |  voltage |                              CRC8   | Frame end
   //  1 byte        2 byte      1 byte          2 byte       1 byte      1 byte             1 byte       1 byte           2 byte     1 byte  1 byte    16 byte   1 byte     6 byte
+  //  上行确认模式下校验码前多1字节上行序号
  
-  unsigned char ReceiptFrame[64] = {0};
-  unsigned char ReceiptLength = 0;
-  unsigned char RandomSeed;
+  unsigned char Timestamp[4];
   unsigned long int RandomSendInterval = 0;
 
-  iwdg_feed();
   if (use_random_wait) 
   {
     //随机等待一段时间后再发送，避免大量设备发送堵塞。
     Receipt_Random_Wait_Value(&RandomSendInterval);
-    delayMicroseconds(RandomSendInterval);
   }
-  iwdg_feed();
 
 #if CLEAR_BUFFER_FLAG
-  Clear_Server_LoRa_Buffer();
+  Clear_Server_LoRa_Buffer(RandomSendInterval);
 #endif
   
-  ReceiptFrame[ReceiptLength++] = 0xFE; //帧头
-  ReceiptFrame[ReceiptLength++] = 0xE0; //帧ID
-  ReceiptFrame[ReceiptLength++] = 0x14;
-  ReceiptFrame[ReceiptLength++] = 0x1A; //数据长度
-  /*设备类型*/
-  ReceiptFrame[ReceiptLength++] = highByte(DEVICE_TYPE_ID);
-  ReceiptFrame[ReceiptLength++] = lowByte(DEVICE_TYPE_ID);
-  /*验证服务器命令是否是群发*/
-  gMassCommandFlag == true ? ReceiptFrame[ReceiptLength++] = 0x55 : ReceiptFrame[ReceiptLength++] = 0x00;
-  /*区域ID*/
-  ReceiptFrame[ReceiptLength++] = Roll_Operation.Read_Area_Number();
+  Status_Baseline Sample;
+  Sample_Status(&Sample);
+  const Telemetry_Snapshot &Telemetry = Motor_Operation.Telemetry_Data();
+
+  Layout_Frame_Writer<E014_Layout> Frame(Uplink_Trailer_Len(TX_KIND_STATUS));
+  /*设备类型、群发标志、区域号*/
+  Frame.Put_Device_Head();
   /*设备路数*/
-  ReceiptFrame[ReceiptLength++] = 0x01;
+  Frame.Put_Byte(0x01);
   /*该设备当前电机状态*/
-  ReceiptFrame[ReceiptLength++] = Read_Motor_Status();
+  Frame.Put_Byte(Sample.Status);
   /*该设备电机当前电压值*/
-  int VolTemp = Motor_Operation.Voltage_Detection();
-  if (VolTemp < 0) VolTemp *= -1;
-  ReceiptFrame[ReceiptLength++] = highByte(VolTemp);
-  ReceiptFrame[ReceiptLength++] = lowByte(VolTemp);
+  Frame.Put_Word(Sample.Voltage);
   /*SNR 和 RSSI*/ 
-  ReceiptFrame[ReceiptLength++] = Type_Conv.Dec_To_Hex(gLoRaCSQ[0]);  //信号发送强度
-  ReceiptFrame[ReceiptLength++] = Type_Conv.Dec_To_Hex(gLoRaCSQ[1]);  //信号接收强度
+  Frame.Put_Byte(Type_Conv.Dec_To_Hex(LoRa_MHL9LF.CSQ_Value()[0]));  //信号发送强度
+  Frame.Put_Byte(Type_Conv.Dec_To_Hex(LoRa_MHL9LF.CSQ_Value()[1]));  //信号接收强度
 
   /*协议预留的16个字节(它们中的一些在该帧里用来表示电机实时信息)*/
-  ReceiptFrame[ReceiptLength++] = Roll_Operation.Read_RealTime_Opening_Value(); //电机实时开度
-  unsigned int Temp = Roll_Operation.Read_Roll_Low_Voltage_Limit_Value(); //读取最小电压阈值
-  ReceiptFrame[ReceiptLength++] = highByte(Temp);
-  ReceiptFrame[ReceiptLength++] = lowByte(Temp);
-  Temp = Roll_Operation.Read_Roll_High_Current_Limit_Value(); //读取最大电流阈值
-  ReceiptFrame[ReceiptLength++] = highByte(Temp);
-  ReceiptFrame[ReceiptLength++] = lowByte(Temp);
-  Temp = Motor_Operation.Current_Detection(); //得到电机当前电流值
-  ReceiptFrame[ReceiptLength++] = highByte(Temp);
-  ReceiptFrame[ReceiptLength++] = lowByte(Temp);
-  ReceiptFrame[ReceiptLength++] = Type_Conv.Dec_To_Hex(Roll_Operation.Read_Roll_Report_Status_Interval_Value()); //得到上报状态频率
+  Frame.Put_Byte(Sample.Opening); //电机实时开度
+  Frame.Put_Word(Telemetry.LowVoltageLimit); //最小电压阈值
+  Frame.Put_Word(Telemetry.HighCurrentLimit); //最大电流阈值
+  Frame.Put_Word(Sample.Current); //得到电机当前电流值
+  Frame.Put_Byte(Type_Conv.Dec_To_Hex(Telemetry.ReportInterval)); //上报状态频率
 
   /* 预留的后8个字节，第一个字节用来上传当前LoRa的通信模式 */
-  ReceiptFrame[ReceiptLength++] = LoRa_Para_Config.Read_LoRa_Com_Mode();
+  Frame.Put_Byte(Telemetry.LoRaComMode);
   /* 第二个字节用来表达软件版本，默认只有一位有效小数位 */
-  ReceiptFrame[ReceiptLength++] = SOFT_VERSION;
+  Frame.Put_Byte(SOFT_VERSION);
   /* 第三个字节用来表达硬件版本，默认只有一位有效小数位 */
-  ReceiptFrame[ReceiptLength++] = HARD_VERSION;
-  for (unsigned char i = 0; i < 5; i++)
-    ReceiptFrame[ReceiptLength++] = 0x00;
-  /*CRC8*/
-  ReceiptFrame[ReceiptLength++] = GetCrc8(&ReceiptFrame[4], 0x1A);
-  /*帧尾*/
-  for (unsigned char i = 0; i < 6; i++)
-    i % 2 == 0 ? ReceiptFrame[ReceiptLength++] = 0x0D : ReceiptFrame[ReceiptLength++] = 0x0A;
-
+  Frame.Put_Byte(HARD_VERSION);
+  /* 第四到第七个字节是时间戳，服务器按它排列上报的先后 */
+  Private_RTC.Get_Timestamp(Timestamp);
+  Frame.Put_Bytes(Timestamp, 4);
+  /* 第八个字节表示本机支持的状态上报方式，服务器据此决定是否协商E017紧凑上报 */
+  Frame.Put_Byte(STATUS_REPORT_CAPS);
+
+  Record.SentFlags |= RECEIPT_SENT_WORKING;
   Serial.println("LoRa parameter receipt...");
-  Print_Debug(&ReceiptFrame[0], ReceiptLength);
+  if (Send_Frame(Frame, RandomSendInterval, times, TX_KIND_STATUS))
+  {
+    /*完整状态都是绝对值，之后的E017从这里开始计算增量*/
+    Reported = Sample;
+    Reported.Valid = true;
+    CompactSinceKey = 0;
+    CompactQueued = false;
+  }
+}
 
-  for (unsigned char i = 0; i < times; i++)
+/*
+ @brief   : 判断一项状态的变化是否超过了上报死区
+ @param   : 1.与上次上报值的差值
+            2.死区（以unit为单位，0表示变化一个单位就上报）
+            3.单位
+ @return  : true or false
+ */
+static bool Exceed_Deadband(long diff, unsigned char deadband, unsigned int unit)
+{
+  unsigned long Threshold = (unsigned long)(deadband == 0 ? 1 : deadband) * unit;
+  return ((unsigned long)labs(diff) >= Threshold);
+}
+
+/*
+ @brief   : 把差值换算成一个字节的增量（以unit为单位，四舍五入）
+ @param   : 1.差值
+            2.单位
+            3.增量
+ @return  : true or false（超出一个字节的范围，只能发送绝对值）
+ */
+static bool Compact_Delta(long diff, unsigned int unit, signed char *delta)
+{
+  long Steps = (diff >= 0) ? (diff + unit / 2) / unit : -((-diff + unit / 2) / (long)unit);
+
+  if (Steps > 127 || Steps < -128) return false;
+  *delta = Steps;
+  return true;
+}
+
+/*
+ @brief   : 上报紧凑状态E017（本机 ---> 服务器）。只带变化超过死区的项，
+            开度、电流、电压按上次上报值的增量发送；第一帧、每COMPACT_KEY_FRAME_INTERVAL帧、
+            增量放不进一个字节时发送全部绝对值
+ @param   : 1.是否随机等待
+            2.上报方式和各项死区，见Read_Status_Report_Config()
+ @return  : 无
+ */
+void Receipt::Compact_Status_Receipt(bool use_random_wait, const unsigned char *config)
+{
+  //  帧头     |    帧ID   |  数据长度   |    设备类型ID   | 群发标志位 | 所在执行区域号 | 控制字节 | 设备状态       | 开度  | 电流     | 电压     | 校验码  | 帧尾 
+  //Frame head | Frame ID | Data Length | Device type ID |  mass flag |  Area number | control | device status | opening | current | voltage |  CRC8  | Frame end
+  //  1 byte        2 byte      1 byte          2 byte        1 byte      1 byte        1 byte      1 byte      0/1 byte  0/1/2 byte 0/1/2 byte  1 byte    6 byte
+  //控制字节：bit7-4 序号，bit3 绝对值，bit2 带电压，bit1 带电流，bit0 带开度。增量为有符号数，电流单位10mA，电压单位100mV
+  //上行确认模式下校验码前多1字节上行序号
+
+  Status_Baseline Now;
+  signed char Delta[3] = {0};
+  unsigned char Control = 0;
+  unsigned long int RandomSendInterval = 0;
+
+  Sample_Status(&Now);
+
+  long OpeningDiff = (long)Now.Opening - Reported.Opening;
+  long CurrentDiff = (long)Now.Current - Reported.Current;
+  long VoltageDiff = (long)Now.Voltage - Reported.Voltage;
+
+  bool KeyFrame = (!Reported.Valid || CompactSinceKey >= COMPACT_KEY_FRAME_INTERVAL);
+
+  if (!KeyFrame)
+  {
+    if (Exceed_Deadband(OpeningDiff, config[1], 1))                     Control |= COMPACT_HAS_OPENING;
+    if (Exceed_Deadband(CurrentDiff, config[2], COMPACT_CURRENT_UNIT))  Control |= COMPACT_HAS_CURRENT;
+    if (Exceed_Deadband(VoltageDiff, config[3], COMPACT_VOLTAGE_UNIT))  Control |= COMPACT_HAS_VOLTAGE;
+
+    if (Control == 0 && Now.Status == Reported.Status)
+    {
+      Serial.println("Status unchanged, skip report... <Compact_Status_Receipt>");
+      return;
+    }
+
+    if (((Control & COMPACT_HAS_OPENING) && !Compact_Delta(OpeningDiff, 1, &Delta[0]))
+      || ((Control & COMPACT_HAS_CURRENT) && !Compact_Delta(CurrentDiff, COMPACT_CURRENT_UNIT, &Delta[1]))
+      || ((Control & COMPACT_HAS_VOLTAGE) && !Compact_Delta(VoltageDiff, COMPACT_VOLTAGE_UNIT, &Delta[2])))
+      KeyFrame = true;
+  }
+
+  /*
+   *队列里还有没有发送的状态，新的一帧会替换它，服务器收不到它的增量，只能发送绝对值。
+   *被替换的是E017时沿用它的序号，服务器不会认为丢帧；它已经开始发送时服务器会收到两帧相同序号，后一帧是绝对值，不影响还原
+   */
+  bool ReplaceFlag = LoRa_Tx_Queue.Pending(TX_KIND_STATUS);
+  if (ReplaceFlag)
+  {
+    KeyFrame = true;
+    if (CompactQueued) CompactSeq--;
+  }
+
+  unsigned char DataLen = 4 + 1 + 1;  //设备类型2 + 群发标志1 + 区域号1 + 控制字节1 + 设备状态1
+  if (KeyFrame)
+  {
+    Control = COMPACT_ABSOLUTE | COMPACT_HAS_OPENING | COMPACT_HAS_CURRENT | COMPACT_HAS_VOLTAGE;
+    DataLen += 1 + 2 + 2;
+  }
+  else
+  {
+    if (Control & COMPACT_HAS_OPENING) DataLen++;
+    if (Control & COMPACT_HAS_CURRENT) DataLen++;
+    if (Control & COMPACT_HAS_VOLTAGE) DataLen++;
+  }
+  Control |= (CompactSeq & 0x0F) << COMPACT_SEQ_SHIFT;
+  DataLen += Uplink_Trailer_Len(TX_KIND_STATUS);
+
+  if (use_random_wait) 
+  {
+    //随机等待一段时间后再发送，避免大量设备发送堵塞。
+    Receipt_Random_Wait_Value(&RandomSendInterval);
+  }
+
+  Frame_Writer Frame(0xE017, DataLen);
+  /*设备类型、群发标志、区域号*/
+  Frame.Put_Device_Head();
+  Frame.Put_Byte(Control);
+  Frame.Put_Byte(Now.Status);
+  if (KeyFrame)
+  {
+    Frame.Put_Byte(Now.Opening);
+    Frame.Put_Word(Now.Current);
+    Frame.Put_Word(Now.Voltage);
+  }
+  else
+  {
+    if (Control & COMPACT_HAS_OPENING) Frame.Put_Byte(Delta[0]);
+    if (Control & COMPACT_HAS_CURRENT) Frame.Put_Byte(Delta[1]);
+    if (Control & COMPACT_HAS_VOLTAGE) Frame.Put_Byte(Delta[2]);
+  }
+
+  Record.SentFlags |= RECEIPT_SENT_WORKING;
+  Serial.println("Compact status receipt...");
+  if (!Send_Frame(Frame, RandomSendInterval, 1, TX_KIND_STATUS))  //没有发出去，下次仍然和上次上报值比较
   {
-    iwdg_feed();
-    Some_Peripheral.Stop_LED();
-    LoRa_Serial.write(&ReceiptFrame[0], ReceiptLength);
-    delayMicroseconds(SEND_DATA_DELAY * 1000);
-    Some_Peripheral.Start_LED();
+    if (ReplaceFlag && CompactQueued) CompactSeq++;
+    return;
   }
+  CompactQueued = true;
+
+  /*按服务器还原出的值更新上报基准，四舍五入的误差不会累积*/
+  if (KeyFrame)
+  {
+    Reported = Now;
+    Reported.Valid = true;
+    CompactSinceKey = 0;
+  }
+  else
+  {
+    if (Control & COMPACT_HAS_OPENING) Reported.Opening += Delta[0];
+    if (Control & COMPACT_HAS_CURRENT) Reported.Current += Delta[1] * COMPACT_CURRENT_UNIT;
+    if (Control & COMPACT_HAS_VOLTAGE) Reported.Voltage += Delta[2] * COMPACT_VOLTAGE_UNIT;
+    Reported.Status = Now.Status;
+    CompactSinceKey++;
+  }
+  CompactSeq++;
 }
 
 /*
@@ -325,62 +567,130 @@ void Receipt::General_Receipt(unsigned char status, unsigned char send_times)
   //  帧头     |    帧ID   |  数据长度   |    设备类型ID   | 群发标志位 | 所在执行区域号 |  设备路数      | 回执状态       |  预留位    | 校验码  |     帧尾 
   //Frame head | Frame ID | Data Length | Device type ID | mass flag | Area number | Device channel | receipt status |  allocate | CRC8    |  Frame end
   //  1 byte        2 byte      1 byte          2 byte       1 byte        1 byte          1 byte       1 byte          8 byte      1 byte     6 byte
+  //  上行确认模式下校验码前多1字节上行序号
   
-  unsigned char ReceiptFrame[25] = {0};
-  unsigned char ReceiptLength = 0;
-  unsigned char RandomSeed;
+  unsigned char Timestamp[4];
   unsigned long int RandomSendInterval = 0;
     
   Receipt_Random_Wait_Value(&RandomSendInterval);
-  delayMicroseconds(RandomSendInterval);
-  iwdg_feed();
 
-  /*读取LoRa模块的 SNR and RSSI，为了防止影响性能，只获取一次信号值*/
-  if (gLoRaCSQ[0] == 0 || gLoRaCSQ[1] == 0)
-    LoRa_MHL9LF.LoRa_AT(gLoRaCSQ, true, AT_CSQ_, 0);
+  /*SNR and RSSI 在配置LoRa参数时读取，这里只用保存的值*/
+  const unsigned char *CSQ = LoRa_MHL9LF.CSQ_Value();
 
 #if CLEAR_BUFFER_FLAG
-  Clear_Server_LoRa_Buffer();
+  Clear_Server_LoRa_Buffer(RandomSendInterval);
 #endif
 
-  ReceiptFrame[ReceiptLength++] = 0xFE; //帧头
-  ReceiptFrame[ReceiptLength++] = 0xE0; //帧ID
-  ReceiptFrame[ReceiptLength++] = 0x15;
-  ReceiptFrame[ReceiptLength++] = 0x0E; //帧有效数据长度
-  /*设备类型*/
-  ReceiptFrame[ReceiptLength++] = highByte(DEVICE_TYPE_ID);
-  ReceiptFrame[ReceiptLength++] = lowByte(DEVICE_TYPE_ID);
-  /*是否是群发*/
-  gMassCommandFlag == true ? ReceiptFrame[ReceiptLength++] = 0x55 : ReceiptFrame[ReceiptLength++] = 0x00;
-  /*区域号*/
-  ReceiptFrame[ReceiptLength++] = Roll_Operation.Read_Area_Number();
+  Layout_Frame_Writer<E015_Layout> Frame(Uplink_Trailer_Len(TX_KIND_GENERAL));
+  /*设备类型、群发标志、区域号*/
+  Frame.Put_Device_Head();
   /*路数*/
-  ReceiptFrame[ReceiptLength++] = 0x01; 
+  Frame.Put_Byte(0x01); 
   /*回执状态*/
-  ReceiptFrame[ReceiptLength++] = status;
+  Frame.Put_Byte(status);
   /*预留的8个字节*/
   /*SNR and RSSI*/
-  ReceiptFrame[ReceiptLength++] = Type_Conv.Dec_To_Hex(gLoRaCSQ[0]);  //发送信号强度
-  ReceiptFrame[ReceiptLength++] = Type_Conv.Dec_To_Hex(gLoRaCSQ[1]);  //接收信号强度
-  for (unsigned char i = 0; i < 6; i++)
-    ReceiptFrame[ReceiptLength++] = 0x00;
-  /*CRC8*/
-  ReceiptFrame[ReceiptLength++] = GetCrc8(&ReceiptFrame[4], 0x0E);
-  /*帧尾*/
-  for (unsigned char i = 0; i < 6; i++)
-    i % 2 == 0 ? ReceiptFrame[ReceiptLength++] = 0x0D : ReceiptFrame[ReceiptLength++] = 0x0A;
-
+  Frame.Put_Byte(Type_Conv.Dec_To_Hex(CSQ[0]));  //发送信号强度
+  Frame.Put_Byte(Type_Conv.Dec_To_Hex(CSQ[1]));  //接收信号强度
+  /*时间戳*/
+  Private_RTC.Get_Timestamp(Timestamp);
+  Frame.Put_Bytes(Timestamp, 4);
+  Frame.Put_Zero(2);
+
+  Record.SentFlags |= RECEIPT_SENT_GENERAL;
+  Record.GeneralStatus = status;
   Serial.println("Send General Receipt...");
-  Print_Debug(&ReceiptFrame[0], ReceiptLength);
+  Send_Frame(Frame, RandomSendInterval, send_times, TX_KIND_GENERAL);
+}
 
-  Some_Peripheral.Stop_LED();
-  for (unsigned char i = 0; i < send_times; i++)
-  {
-    iwdg_feed();
-    LoRa_Serial.write(ReceiptFrame, ReceiptLength);
-    delay(SEND_DATA_DELAY);
-  }
-  Some_Peripheral.Start_LED();
+/*
+ @brief   : 卷膜过程中上报实时电流（本机 ---> 服务器）。
+            卷膜时每隔几秒发一次，帧格式按协议2.4，不随机等待、不查询信号强度。
+            不记入回执记录，重复指令不重发
+ @param   : 1.滤波后的电流（mA）
+            2.本次已卷膜时间（S）
+ @return  : 无
+ */
+void Receipt::Current_Stream_Receipt(unsigned int current, unsigned long work_time)
+{
+  //  帧头     |    帧ID   |  数据长度   |    设备类型ID   | 群发标志位 | 所在执行区域号 | 工作组号   | 设备路数       |  电流    | 已工作时间    | 预留    | 校验码  |     帧尾 
+  //Frame head | Frame ID | Data Length | Device type ID |  mass flag |  Area number | workgroup | Device channel | current | working time | Allocate |  CRC8  |  Frame end
+  //  1 byte        2 byte      1 byte          2 byte        1 byte      1 byte        1 byte       1 byte       3 byte     3 byte       8 byte    1 byte     6 byte
+
+  unsigned char GroupNumber[5];
+  if (!Roll_Operation.Read_Group_Number(GroupNumber))
+    GroupNumber[0] = 0x00;
+
+  Layout_Frame_Writer<E016_Layout> Frame;
+  /*设备类型、群发标志、区域号*/
+  Frame.Put_Device_Head();
+  /*工作组号，本机属于多个组时取第一个*/
+  Frame.Put_Byte(GroupNumber[0]);
+  /*设备路数*/
+  Frame.Put_Byte(0x01); 
+  /*电流（mA）*/
+  Frame.Put_Byte(0x00);
+  Frame.Put_Word(current);
+  /*已工作时间（S）*/
+  Frame.Put_Byte((work_time >> 16) & 0xFF);
+  Frame.Put_Word(work_time & 0xFFFF);
+  /*预留8个字节*/
+  Frame.Put_Zero(8);
+
+  Serial.println("Current stream receipt...");
+  Send_Frame(Frame, 0, 1, TX_KIND_CURRENT);
+}
+
+/*
+ @brief   : 回执A024批量读写参数寄存器的结果（本机 ---> 服务器），所有寄存器的结果在一帧里
+ @param   : 1.操作：0x01读，0x02写
+            2.结果个数
+            3.结果列表，每项为寄存器号 + 结果（Register_Status），读成功时后面跟寄存器数据
+            4.结果列表长度
+ @return  : 无
+ */
+void Receipt::Register_Receipt(unsigned char operation, unsigned char reg_num, const unsigned char *result, unsigned char len)
+{
+  //  帧头     |    帧ID   |  数据长度   |    设备类型ID   | 群发标志位 | 所在执行区域号 | 设备路数       | 操作       | 结果个数 | 结果列表 | 校验码  |     帧尾 
+  //Frame head | Frame ID | Data Length | Device type ID |  mass flag |  Area number | Device channel | operation | reg num | result  |  CRC8  |  Frame end
+  //  1 byte        2 byte      1 byte          2 byte        1 byte      1 byte          1 byte         1 byte      1 byte    N byte    1 byte     6 byte
+
+  unsigned long int RandomSendInterval = 0;
+
+  Receipt_Random_Wait_Value(&RandomSendInterval);
+
+#if CLEAR_BUFFER_FLAG
+  Clear_Server_LoRa_Buffer(RandomSendInterval);
+#endif
+
+  /*结果列表长度不固定，按实际长度组帧*/
+  Frame_Writer Frame(0xE024, REGISTER_HEAD_LEN + len);
+  /*设备类型、群发标志、区域号*/
+  Frame.Put_Device_Head();
+  /*设备路数*/
+  Frame.Put_Byte(0x01); 
+  /*操作和结果*/
+  Frame.Put_Byte(operation);
+  Frame.Put_Byte(reg_num);
+  Frame.Put_Bytes(result, len);
+
+  Serial.println("Register receipt...");
+  Send_Frame(Frame, RandomSendInterval, 1, TX_KIND_OTHER);
+}
+
+/*
+ @brief   : 重发一条重复指令当时的回执，每种回执只发一次。工作状态回执按当前状态重新生成完整的E014
+ @param   : 缓存的回执记录
+ @return  : 无
+ */
+void Receipt::Replay_Record(const Receipt_Record &record)
+{
+  if (record.SentFlags & RECEIPT_SENT_GENERAL)
+    General_Receipt(record.GeneralStatus, 1);
+  if (record.SentFlags & RECEIPT_SENT_WORKING)
+    Full_Working_Receipt(true, 1);
+  if (record.SentFlags & RECEIPT_SENT_REPORT)
+    Report_General_Parameter();
 }
 
 /*
@@ -389,7 +699,7 @@ void Receipt::General_Receipt(unsigned char status, unsigned char send_times)
             2.数据长度s
  @return  : 无
  */
-void Receipt::Print_Debug(unsigned char *base_addr, unsigned char len)
+void Receipt::Print_Debug(const unsigned char *base_addr, unsigned char len)
 {
   for (unsigned char i = 0; i < len; i++)
   {
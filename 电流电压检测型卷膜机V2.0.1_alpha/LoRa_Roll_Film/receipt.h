@@ -2,6 +2,7 @@
 #define _RECEIPT_H
 
 #include <Arduino.h>
+#include "Frame_Writer.h"
 
 #define DEVICE_TYPE_ID  0xC001
 
@@ -12,7 +13,8 @@
 enum ReceiptStatus{
   FactoryMode = 0, AskUploadParamsOk, AskUploadParamsErr, AssignGroupIdArrayOk, AssignGroupIdArrayErr, SetSnAndSlaverCountOk, 
   SetSnAndSlaverCountErr, TrunOffOk, TrunOffErr, RestRollerOk, ResetRollerErr, OpenRollerOk, OpenRollerErr, LimitRollerOk,
-  LimitRollerErr, SetLoRaModeOk, SetLoRaModeErr
+  LimitRollerErr, SetLoRaModeOk, SetLoRaModeErr, SetScheduleOk, SetScheduleErr,
+  SetRtcOk, SetRtcErr, RegisterMapOk, RegisterMapErr
 };
 
 /*电机状态*/
@@ -24,6 +26,54 @@ enum MotorStatus{
 
 extern unsigned char gMotorStatus;
 
+/*处理一条指令期间发出过的回执*/
+#define RECEIPT_SENT_GENERAL    0x01  //通用回执
+#define RECEIPT_SENT_WORKING    0x02  //工作状态回执
+#define RECEIPT_SENT_REPORT     0x04  //通用参数上报
+
+/*状态上报方式，服务器通过A024寄存器0x0F协商*/
+#define STATUS_REPORT_FULL          0x00  //完整的E014，默认
+#define STATUS_REPORT_COMPACT       0x01  //E017紧凑状态，只在状态变化或超过死区时上报
+/*E014最后一个预留字节：本机支持的状态上报方式，bit0表示支持E017*/
+#define STATUS_REPORT_CAPS          0x01
+
+/*群发指令回执时隙*/
+#define REPLY_SLOT_UNIT             10      //时隙宽度单位（ms）
+#define REPLY_SLOT_WIDTH_MIN        70      //最小时隙宽度（10ms），要放得下合并后最长的一包回执：串口写入约100ms + SF9空中时间约600ms
+#define REPLY_SLOT_BY_SN            0xFFFF  //没有指定时隙号，按SN码末两字节计算
+
+/*上行确认，服务器通过A024寄存器0x19协商*/
+#define UPLINK_ACK_OFF              0x00  //按调用时给定的次数盲发，默认
+#define UPLINK_ACK_ON               0x01  //通用回执和状态回执带序号，收到A025确认后不再重发
+#define UPLINK_SEQ_LEN              1     //确认模式下数据末尾的上行序号长度
+#define UPLINK_ACK_TIMEOUT_UNIT     100   //等待确认时间单位（ms）
+#define UPLINK_ACK_RETRY_MAX        7     //最多重发次数上限
+
+/*E017控制字节*/
+#define COMPACT_HAS_OPENING         0x01  //带开度
+#define COMPACT_HAS_CURRENT         0x02  //带电流
+#define COMPACT_HAS_VOLTAGE         0x04  //带电压
+#define COMPACT_ABSOLUTE            0x08  //绝对值，否则为上次上报值的增量
+#define COMPACT_SEQ_SHIFT           4     //高4位为序号，服务器据此发现丢帧后查询A014
+/*E017增量单位和绝对值帧间隔*/
+#define COMPACT_CURRENT_UNIT        10    //mA
+#define COMPACT_VOLTAGE_UNIT        100   //mV
+#define COMPACT_KEY_FRAME_INTERVAL  16    //连续发送多少帧增量后发送一次绝对值
+
+/*上次上报给服务器的工作状态，E017的增量和死区都与它比较*/
+struct Status_Baseline{
+  bool Valid;
+  unsigned char Status;
+  unsigned char Opening;
+  unsigned int Current;   //mA
+  unsigned int Voltage;   //mV
+};
+
+struct Receipt_Record{
+  unsigned char SentFlags;
+  unsigned char GeneralStatus;  //最后一次通用回执的状态
+};
+
 /*
  @brief   : 设置当前设备工作状态
  @para    : 设备状态
@@ -44,11 +94,37 @@ public:
     void Request_Set_Group_Number(void);
     void Request_Device_SN_and_Channel(void);
     void Working_Parameter_Receipt(bool use_random_wait, unsigned char times);
+    void Full_Working_Receipt(bool use_random_wait, unsigned char times);
+    void Restart_Compact_Status(void) {Reported.Valid = false;}
     void General_Receipt(unsigned char status, unsigned char send_times);
+    void Current_Stream_Receipt(unsigned int current, unsigned long work_time);
+    void Register_Receipt(unsigned char operation, unsigned char reg_num, const unsigned char *result, unsigned char len);
+
+    Receipt_Record Read_Record(void) {return Record;}
+    void Write_Record(const Receipt_Record &record) {Record = record;}
+    void Clear_Record(void) {Record.SentFlags = 0;}
+    void Replay_Record(const Receipt_Record &record);
 private:
+  Receipt_Record Record;
+  Status_Baseline Reported;
+  unsigned char CompactSeq;
+  unsigned char CompactSinceKey;
+  bool CompactQueued;       //最后放入发送队列的状态是否为E017
+  unsigned char UplinkSeq;  //下一帧需要确认的回执的上行序号
+  bool SlotWaitFlag;        //这次回执的等待时间是群发回执时隙，由Send_Frame()用掉
+  unsigned long SlotPeriod; //时隙周期（ms），重发时加上整数个周期
+
+  bool Uplink_Ack_Config(unsigned char kind, unsigned char *config);
+  unsigned char Uplink_Trailer_Len(unsigned char kind);
+
+  void Sample_Status(Status_Baseline *sample);
+  void Compact_Status_Receipt(bool use_random_wait, const unsigned char *config);
+
   void Receipt_Random_Wait_Value(unsigned long int *random_value);
-  void Clear_Server_LoRa_Buffer(void);
-  void Print_Debug(unsigned char *base_addr, unsigned char len);
+  bool Reply_Slot_Wait_Value(unsigned long int *wait_value, unsigned long *period);
+  void Clear_Server_LoRa_Buffer(unsigned long int wait_us);
+  bool Send_Frame(Frame_Writer &writer, unsigned long int wait_us, unsigned char times, unsigned char kind);
+  void Print_Debug(const unsigned char *base_addr, unsigned char len);
 };
 
 extern Receipt Message_Receipt;